@@ -1,3 +1,4 @@
+#include "rate_ctrl.h"
 
 //* Conf
 
@@ -8,17 +9,29 @@
 
 #define VAL_MAX 677
 #define VAL_MIN 0
-#define VAL_DEADZONE 20
+// Raw units
+#define VAL_DEADZONE 40
+// Min change to resend a channel
+#define VAL_THRESHOLD 3
+// Samples per channel and period, running filter weight 1/2^VAL_FILT_SHIFT
+#define VAL_OVERSAMPLE_NB 4U
+#define VAL_FILT_SHIFT 2U
 
-#define SERIAL_TX_DELAY_MS 10U
+#define SERIAL_BAUD 1000000UL
+#define SERIAL_TX_PERIOD_IDLE_MS 10U
+#define SERIAL_TX_PERIOD_MOVE_MS 2U
 
 // Conf */
 
 #define VAL_NB 4U
-#define SERIAL_MSG_VAL_DFLT "000,"
-#define SERIAL_MSG_VAL_SIZE sizeof(SERIAL_MSG_VAL_DFLT)
-#define SERIAL_MSG_DFLT "000,000,000,000,"
-#define SERIAL_MSG_SIZE sizeof(SERIAL_MSG_DFLT)
+
+// Frame, see serial_frame.py
+#define FRAME_SAMPLE_BITS 10U
+#define FRAME_HDR_SIZE 7U
+#define FRAME_DATA_SIZE ((VAL_NB * FRAME_SAMPLE_BITS + 7U) / 8U)
+#define FRAME_SIZE (FRAME_HDR_SIZE + FRAME_DATA_SIZE + 1U)
+// COBS overhead (1 Byte per 254) and delimiter
+#define FRAME_COBS_SIZE (FRAME_SIZE + FRAME_SIZE / 254U + 2U)
 
 uint8_t PIN_ARRAY[VAL_NB] = {
     PIN_LEFT_VERTICAL,
@@ -27,36 +40,159 @@ uint8_t PIN_ARRAY[VAL_NB] = {
     PIN_RIGHT_HORIZONTAL,
 };
 
-const int valMid = int((VAL_MAX - VAL_MIN) / 2);
-int g_pVal[VAL_NB] = {0};
-char g_sSerialMsg[SERIAL_MSG_SIZE] = SERIAL_MSG_DFLT;
+const RateCtrlConf_t g_rateCtrlConf = {
+    VAL_NB,
+    (VAL_MAX - VAL_MIN) / 2,
+    VAL_DEADZONE,
+    VAL_THRESHOLD,
+    VAL_FILT_SHIFT,
+    SERIAL_TX_PERIOD_IDLE_MS,
+    SERIAL_TX_PERIOD_MOVE_MS,
+};
+
+RateCtrl_t g_rateCtrl;
+int16_t g_pVal[VAL_NB] = {0};
+uint8_t g_seq = 0U;
+uint8_t g_pFrame[FRAME_SIZE] = {0};
+uint8_t g_pFrameCobs[FRAME_COBS_SIZE] = {0};
+
+// CRC-8, poly 0x07, init 0x00
+uint8_t crc8(const uint8_t * pData, uint8_t len)
+{
+    uint8_t crc = 0U;
+
+    for (uint8_t idx = 0U; idx < len; idx += 1U)
+    {
+        crc ^= pData[idx];
+        for (uint8_t bit = 0U; bit < 8U; bit += 1U)
+        {
+            crc = (crc & 0x80U) ? (uint8_t) ((crc << 1) ^ 0x07U) : (uint8_t) (crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+// COBS encode pIn, 0x00 terminated, return encoded size
+uint8_t cobsEncode(const uint8_t * pIn, uint8_t len, uint8_t * pOut)
+{
+    uint8_t outIdx = 1U;
+    uint8_t codeIdx = 0U;
+    uint8_t code = 1U;
+
+    for (uint8_t inIdx = 0U; inIdx < len; inIdx += 1U)
+    {
+        if (pIn[inIdx] == 0U)
+        {
+            pOut[codeIdx] = code;
+            codeIdx = outIdx;
+            outIdx += 1U;
+            code = 1U;
+            continue;
+        }
+
+        pOut[outIdx] = pIn[inIdx];
+        outIdx += 1U;
+        code += 1U;
+
+        if (code == 0xFFU)
+        {
+            pOut[codeIdx] = code;
+            codeIdx = outIdx;
+            outIdx += 1U;
+            code = 1U;
+        }
+    }
+
+    pOut[codeIdx] = code;
+    pOut[outIdx] = 0x00U;
+
+    return outIdx + 1U;
+}
+
+// Build frame with the channels in mask, return frame size
+uint8_t frameBuild(uint8_t mask)
+{
+    uint8_t size = 0U;
+    uint32_t ts = micros();
+    uint32_t acc = 0U;
+    uint8_t accBits = 0U;
+
+    g_pFrame[size++] = FRAME_SAMPLE_BITS;
+    g_pFrame[size++] = g_seq;
+    g_pFrame[size++] = (uint8_t) ts;
+    g_pFrame[size++] = (uint8_t) (ts >> 8);
+    g_pFrame[size++] = (uint8_t) (ts >> 16);
+    g_pFrame[size++] = (uint8_t) (ts >> 24);
+    g_pFrame[size++] = mask;
+
+    // Samples, packed LSB first
+    for (uint8_t valIdx = 0U; valIdx < VAL_NB; valIdx += 1U)
+    {
+        if (!(mask & (1U << valIdx)))
+        {
+            continue;
+        }
+
+        acc |= ((uint32_t) g_pVal[valIdx] & ((1UL << FRAME_SAMPLE_BITS) - 1U)) << accBits;
+        accBits += FRAME_SAMPLE_BITS;
+
+        while (accBits >= 8U)
+        {
+            g_pFrame[size++] = (uint8_t) acc;
+            acc >>= 8;
+            accBits -= 8U;
+        }
+    }
+
+    if (accBits)
+    {
+        g_pFrame[size++] = (uint8_t) acc;
+    }
+
+    g_pFrame[size] = crc8(g_pFrame, size);
+    size += 1U;
+
+    g_seq += 1U;
+
+    return size;
+}
 
 void setup()
 {
-    Serial.begin(115200);
+    Serial.begin(SERIAL_BAUD);
+    rateCtrlInit(&g_rateCtrl, &g_rateCtrlConf);
 }
 
 void loop()
 {
-    bool bSend = false;
+    uint32_t start = millis();
+    uint32_t elapsed = 0U;
     uint8_t valIdx = 0U;
+    uint8_t sampleIdx = 0U;
+    uint8_t mask = 0U;
+    uint8_t size = 0U;
 
-    for (valIdx = 0U; valIdx < VAL_NB; valIdx += 1U)
+    for (sampleIdx = 0U; sampleIdx < VAL_OVERSAMPLE_NB; sampleIdx += 1U)
     {
-        g_pVal[valIdx] = analogRead(PIN_ARRAY[valIdx]);
-
-        snprintf(&g_sSerialMsg[(SERIAL_MSG_VAL_SIZE - 1U) * valIdx], SERIAL_MSG_VAL_SIZE, "%03d,", g_pVal[valIdx]);
-
-        if (int(abs(g_pVal[valIdx] - valMid) / 2U) > VAL_DEADZONE)
+        for (valIdx = 0U; valIdx < VAL_NB; valIdx += 1U)
         {
-            bSend = true;
+            rateCtrlSample(&g_rateCtrl, valIdx, analogRead(PIN_ARRAY[valIdx]));
         }
     }
 
-    if (bSend)
+    // Only changed channels, empty frame as heartbeat while moving
+    mask = rateCtrlStep(&g_rateCtrl, g_pVal);
+    if (rateCtrlIsDue(&g_rateCtrl, mask))
     {
-        Serial.println(&g_sSerialMsg[0U]);
+        size = frameBuild(mask);
+        size = cobsEncode(g_pFrame, size, g_pFrameCobs);
+        Serial.write(g_pFrameCobs, size);
     }
 
-    delay(SERIAL_TX_DELAY_MS);
+    elapsed = millis() - start;
+    if (elapsed < rateCtrlPeriodMs(&g_rateCtrl))
+    {
+        delay(rateCtrlPeriodMs(&g_rateCtrl) - elapsed);
+    }
 }
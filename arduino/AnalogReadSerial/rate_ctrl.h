@@ -0,0 +1,129 @@
+#ifndef RATE_CTRL_H
+#define RATE_CTRL_H
+
+// Change driven streaming: running filter, per channel deltas, final centre
+// frame and activity dependent period. Plain C or C++, no Arduino dependency,
+// host tested by esp/test_host/test_rate_ctrl.c.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define RATE_CTRL_CHAN_MAX 8U
+
+typedef struct
+{
+    uint8_t chanNb;
+    int16_t center;
+    // Channel is active when |filtered - center| > deadzone
+    int16_t deadzone;
+    // Channel is resent when it moved at least threshold since last sent
+    int16_t threshold;
+    // Running filter weight is 1 / 2^filtShift
+    uint8_t filtShift;
+    uint16_t periodIdleMs;
+    uint16_t periodMoveMs;
+} RateCtrlConf_t;
+
+typedef struct
+{
+    const RateCtrlConf_t * pConf;
+    // Filter state, value << filtShift
+    int32_t pFilt[RATE_CTRL_CHAN_MAX];
+    int16_t pSent[RATE_CTRL_CHAN_MAX];
+    bool bMoving;
+} RateCtrl_t;
+
+static inline int16_t rateCtrlAbs(int16_t val)
+{
+    return (val < 0) ? (int16_t) -val : val;
+}
+
+static inline int16_t rateCtrlGet(const RateCtrl_t * pInst, uint8_t chan)
+{
+    return (int16_t) (pInst->pFilt[chan] >> pInst->pConf->filtShift);
+}
+
+static inline void rateCtrlInit(RateCtrl_t * pInst, const RateCtrlConf_t * pConf)
+{
+    pInst->pConf = pConf;
+    pInst->bMoving = false;
+
+    for (uint8_t chan = 0U; chan < RATE_CTRL_CHAN_MAX; chan += 1U)
+    {
+        pInst->pFilt[chan] = (int32_t) pConf->center << pConf->filtShift;
+        pInst->pSent[chan] = pConf->center;
+    }
+}
+
+// Feed one raw sample, call several times per period to oversample
+static inline void rateCtrlSample(RateCtrl_t * pInst, uint8_t chan, int16_t sample)
+{
+    pInst->pFilt[chan] += sample - rateCtrlGet(pInst, chan);
+}
+
+// Once per period, return the mask of channels to send, values in pOut.
+// While moving an empty mask still means a frame is due (heartbeat, keeps
+// the host integrating), see rateCtrlIsDue.
+static inline uint8_t rateCtrlStep(RateCtrl_t * pInst, int16_t * pOut)
+{
+    const RateCtrlConf_t * pConf = pInst->pConf;
+    bool bActive = false;
+    bool bStart = false;
+    uint8_t mask = 0U;
+    uint8_t chan = 0U;
+
+    for (chan = 0U; chan < pConf->chanNb; chan += 1U)
+    {
+        if (rateCtrlAbs(rateCtrlGet(pInst, chan) - pConf->center) > pConf->deadzone)
+        {
+            bActive = true;
+        }
+    }
+
+    if (!bActive)
+    {
+        if (pInst->bMoving)
+        {
+            // Motion stopped, explicit centre frame with every channel
+            pInst->bMoving = false;
+            for (chan = 0U; chan < pConf->chanNb; chan += 1U)
+            {
+                pInst->pSent[chan] = pConf->center;
+                pOut[chan] = pConf->center;
+            }
+            return (uint8_t) ((1U << pConf->chanNb) - 1U);
+        }
+        return 0U;
+    }
+
+    bStart = !pInst->bMoving;
+    pInst->bMoving = true;
+
+    for (chan = 0U; chan < pConf->chanNb; chan += 1U)
+    {
+        int16_t val = rateCtrlGet(pInst, chan);
+
+        // Motion start resends everything so the host has the full state
+        if (bStart || (rateCtrlAbs(val - pInst->pSent[chan]) >= pConf->threshold))
+        {
+            pInst->pSent[chan] = val;
+            pOut[chan] = val;
+            mask |= (uint8_t) (1U << chan);
+        }
+    }
+
+    return mask;
+}
+
+// Frame due after rateCtrlStep: moving (maybe empty mask) or centre frame
+static inline bool rateCtrlIsDue(const RateCtrl_t * pInst, uint8_t mask)
+{
+    return pInst->bMoving || (mask != 0U);
+}
+
+static inline uint16_t rateCtrlPeriodMs(const RateCtrl_t * pInst)
+{
+    return pInst->bMoving ? pInst->pConf->periodMoveMs : pInst->pConf->periodIdleMs;
+}
+
+#endif
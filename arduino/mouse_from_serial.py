@@ -1,12 +1,22 @@
 
-import mouse, sys
+import argparse
+import selectors
+import sys
 import time
 from serial import Serial
 
+from serial_frame import FrameDecoder, TS_MOD
+
 MS_PER_S = 1000
+US_PER_S = 1000000
+
+SERIAL_PORT = "/dev/ttyACM1"
+SERIAL_BAUD = 1000000
 
-VAL_TX_DELAY_MS = 10
-VAL_TX_DELAY_S = MS_PER_S / VAL_TX_DELAY_MS
+# Nominal frame period, used for the first frame only, then sender timestamps are used
+VAL_TX_DELAY_MS = 2
+# Longest interval a held value is integrated over, bounds the jump after lost frames
+VAL_HOLD_MAX_MS = 100
 
 VAL_SRC_MIN = 1
 VAL_SRC_MAX = 680
@@ -15,67 +25,193 @@ VAL_DST_MIN = -1
 VAL_DST_MAX = 1
 VAL_DST_DEADZONE = 0.1
 
+# Frame channels (AnalogReadSerial PIN_ARRAY order)
+CHAN_X = 1
+CHAN_Y = 0
+
 MOV_FORMULA = "0.9x^5 + 0.1x"
 
 # Pixel/sec
 MOV_SPEED_MAX = 4000
 
+STATS_PERIOD_S = 2
+
 def map_val(val_src: int, range_src_min: int, range_src_max: int, range_dst_min: int, range_dst_max: int):
-    return (val_src - range_src_min) / range_src_max * (range_dst_max - range_dst_min) + range_dst_min
+    return (val_src - range_src_min) / (range_src_max - range_src_min) * (range_dst_max - range_dst_min) + range_dst_min
 
-def apply_formula(val_in: float, formula: str):
-    val_out = 0
+def parse_formula(formula: str):
+    terms = []
     for member in formula.replace(" ", "").split("+"):
         coef = float(member.split("x")[0])
         exp = 1
         if "x^" in member:
             exp = int(member.split("x^")[1])
+        terms.append((coef, exp))
+    return terms
+
+def apply_formula(val_in: float, terms, verbose: bool = False):
+    val_out = 0
+    for coef, exp in terms:
         val_out += coef * pow(val_in, exp)
-        print(f" += {coef}x^{exp}")
-    print(f"{formula}({val_in}) = {val_out}")
+        if verbose:
+            print(f" += {coef}x^{exp}")
+    if verbose:
+        print(f"f({val_in}) = {val_out}")
     return val_out
 
+def axis_speed(val_raw: int, terms, src_min: int = VAL_SRC_MIN, src_max: int = VAL_SRC_MAX):
+    val = map_val(val_raw, src_min, src_max, VAL_DST_MIN, VAL_DST_MAX)
+    if abs(val) <= VAL_DST_DEADZONE:
+        return 0
+    sign = 1 if val > 0 else -1
+    return sign * apply_formula(abs(val), terms) * MOV_SPEED_MAX
+
+class MouseSink:
+    """mouse package backend, one OS event per combined move"""
+
+    def __init__(self):
+        import mouse
+        self.mouse = mouse
+
+    def move(self, dx: int, dy: int):
+        self.mouse.move(dx, dy, absolute=False)
+
+    def close(self):
+        pass
+
+class Stats:
+    """Per frame timing, reported every STATS_PERIOD_S"""
+
+    def __init__(self):
+        self.reset(time.perf_counter())
+
+    def reset(self, now: float):
+        self.t_start = now
+        self.frame_nb = 0
+        self.wake_nb = 0
+        self.emit_nb = 0
+        self.frames_per_wake_max = 0
+        self.period_min_us = None
+        self.period_max_us = 0
+        self.latency_sum_us = 0
+        self.latency_max_us = 0
+
+    def frame(self, period_us: int):
+        self.frame_nb += 1
+        self.period_min_us = period_us if self.period_min_us is None else min(self.period_min_us, period_us)
+        self.period_max_us = max(self.period_max_us, period_us)
+
+    def wake(self, frame_nb: int, latency_us: float, emitted: bool):
+        self.wake_nb += 1
+        self.emit_nb += emitted
+        self.frames_per_wake_max = max(self.frames_per_wake_max, frame_nb)
+        self.latency_sum_us += latency_us
+        self.latency_max_us = max(self.latency_max_us, latency_us)
+
+    def report(self, now: float, decoder: FrameDecoder):
+        span = now - self.t_start
+        if span < STATS_PERIOD_S:
+            return
+        if self.wake_nb:
+            print(f"frames {self.frame_nb / span:.0f}/s, "
+                  f"sender period {self.period_min_us}..{self.period_max_us} us, "
+                  f"wakeups {self.wake_nb / span:.0f}/s (max {self.frames_per_wake_max} frames), "
+                  f"events {self.emit_nb / span:.0f}/s, "
+                  f"read->emit {self.latency_sum_us / self.wake_nb:.0f} us avg {self.latency_max_us:.0f} us max, "
+                  f"lost {decoder.lost_nb}, errors {decoder.error_nb}", file=sys.stderr)
+        self.reset(now)
+
 def main():
-    # mouse.FAILSAFE = False
-    serial = Serial("/dev/ttyACM1", 115200)
+    parser = argparse.ArgumentParser(description="Move mouse from joystick serial frames")
+    parser.add_argument("--port", default=SERIAL_PORT, help="serial port, or pty from serial_sim.py")
+    parser.add_argument("--baud", type=int, default=SERIAL_BAUD)
+    parser.add_argument("--backend", choices=["mouse", "uinput"], default="mouse")
+    parser.add_argument("--uinput-path", default="/dev/uinput", help="uinput node")
+    parser.add_argument("--uinput-dummy", metavar="PATH", help="write the uinput events to this file / FIFO instead, no device")
+    parser.add_argument("--src-min", type=int, default=VAL_SRC_MIN, help="raw value at full deflection, low side")
+    parser.add_argument("--src-max", type=int, default=VAL_SRC_MAX, help="raw value at full deflection, high side (ESP raw stream : ~800)")
+    parser.add_argument("--stats", action="store_true", help="print timing stats every few seconds")
+    args = parser.parse_args()
+
+    if args.src_max <= args.src_min:
+        parser.error(f"--src-max ({args.src_max}) must be above --src-min ({args.src_min})")
+    # Both ends map onto the full output range, whatever the minimum
+    for val_src, val_dst in ((args.src_min, VAL_DST_MIN), (args.src_max, VAL_DST_MAX), ((args.src_min + args.src_max) / 2, (VAL_DST_MIN + VAL_DST_MAX) / 2)):
+        assert abs(map_val(val_src, args.src_min, args.src_max, VAL_DST_MIN, VAL_DST_MAX) - val_dst) < 1e-9, f"map_val({val_src})"
+
+    if args.backend == "uinput":
+        from uinput import UInputDummy, UInputMouse
+        try:
+            sink = UInputDummy(args.uinput_dummy) if args.uinput_dummy else UInputMouse(args.uinput_path)
+        except RuntimeError as exc:
+            sys.exit(f"uinput backend : {exc}")
+    else:
+        sink = MouseSink()
+
+    # Non blocking, reads are driven by the selector
+    serial = Serial(args.port, args.baud, timeout=0)
     time.sleep(1)
 
+    selector = selectors.DefaultSelector()
+    selector.register(serial.fileno(), selectors.EVENT_READ)
+
+    terms = parse_formula(MOV_FORMULA)
+    decoder = FrameDecoder()
+    stats = Stats()
+    lost_nb = 0
+    ts_prev = None
+    # Sender only sends changed channels, last value held until replaced
+    held = {}
+
     mouse_mov_x_buf = 0
     mouse_mov_y_buf = 0
 
-    while True:
-        data = str(serial.readline().decode('ascii'))
-        # print(data)
-
-        val_list = [map_val(int(val_str), VAL_SRC_MIN, VAL_SRC_MAX, VAL_DST_MIN, VAL_DST_MAX) for val_str in data.split(",")[0:2]]
-        # print(val_list)
-
-        mouse_mov_x = 0
-        if abs(val_list[1]) > VAL_DST_DEADZONE:
-            mov = val_list[1]
-            mov_abs = abs(mov)
-            sign = mov / mov_abs
-            mouse_mov_x = sign * apply_formula(mov_abs, MOV_FORMULA) * MOV_SPEED_MAX / VAL_TX_DELAY_S
-
-        mouse_mov_y = 0
-        if abs(val_list[0]) > VAL_DST_DEADZONE:
-            mov = val_list[0]
-            mov_abs = abs(mov)
-            sign = mov / mov_abs
-            mouse_mov_y = sign * apply_formula(mov_abs, MOV_FORMULA) * MOV_SPEED_MAX / VAL_TX_DELAY_S
-
-        if mouse_mov_x:
-            if abs(mouse_mov_x + mouse_mov_x_buf) < 1:
-                mouse_mov_x_buf += mouse_mov_x
-            else:
-                mouse.move(mouse_mov_x + mouse_mov_x_buf, 0, absolute=False)
-                mouse_mov_x_buf = 0
-        if mouse_mov_y:
-            if abs(mouse_mov_y + mouse_mov_y_buf) < 1:
-                mouse_mov_y_buf += mouse_mov_y
-            else:
-                mouse.move(0, mouse_mov_y + mouse_mov_y_buf, absolute=False)
-                mouse_mov_y_buf = 0
+    try:
+        while True:
+            if not selector.select(timeout=STATS_PERIOD_S):
+                if args.stats:
+                    stats.report(time.perf_counter(), decoder)
+                continue
+            t_wake = time.perf_counter()
+
+            # Drain everything pending, frames are merged into a single move
+            frames = decoder.feed(serial.read(serial.in_waiting or 1))
+            if decoder.lost_nb != lost_nb:
+                print(f"lost {decoder.lost_nb - lost_nb} frame(s)", file=sys.stderr)
+                lost_nb = decoder.lost_nb
+
+            for frame in frames:
+                dt_us = VAL_TX_DELAY_MS * US_PER_S // MS_PER_S
+                if ts_prev is not None:
+                    dt_us = (frame.ts_us - ts_prev) % TS_MOD
+                ts_prev = frame.ts_us
+                stats.frame(dt_us)
+
+                # Held values apply until this frame
+                if CHAN_X in held and CHAN_Y in held:
+                    dt_us = min(dt_us, VAL_HOLD_MAX_MS * US_PER_S // MS_PER_S)
+                    mouse_mov_x_buf += axis_speed(held[CHAN_X], terms, args.src_min, args.src_max) * dt_us / US_PER_S
+                    mouse_mov_y_buf += axis_speed(held[CHAN_Y], terms, args.src_min, args.src_max) * dt_us / US_PER_S
+                held.update(frame.values)
+
+            # Whole pixels out, fraction kept for next wakeup
+            mouse_mov_x = int(mouse_mov_x_buf)
+            mouse_mov_y = int(mouse_mov_y_buf)
+            mouse_mov_x_buf -= mouse_mov_x
+            mouse_mov_y_buf -= mouse_mov_y
+
+            emitted = bool(mouse_mov_x or mouse_mov_y)
+            if emitted:
+                sink.move(mouse_mov_x, mouse_mov_y)
+
+            if args.stats and frames:
+                now = time.perf_counter()
+                stats.wake(len(frames), (now - t_wake) * US_PER_S, emitted)
+                stats.report(now, decoder)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        sink.close()
 
 if __name__ ==  "__main__":
     main()
@@ -0,0 +1,144 @@
+
+import struct
+from dataclasses import dataclass, field
+
+# Frame, COBS encoded and 0x00 terminated on the wire:
+#   bits   u8  sample width (10 : Arduino analogRead)
+#   seq    u8  frame sequence, wraps
+#   ts_us  u32 sender timestamp (micros()), little endian, wraps
+#   mask   u8  channels present, bit n : channel n
+#   data       present channel samples, bits wide, packed LSB first
+#   crc    u8  CRC-8 (poly 0x07, init 0x00) of all previous bytes
+FRAME_HDR_FMT = "<BBIB"
+FRAME_HDR_LEN = struct.calcsize(FRAME_HDR_FMT)
+FRAME_DELIM = b"\x00"
+FRAME_CHAN_NB_MAX = 8
+
+SEQ_MOD = 256
+TS_MOD = 1 << 32
+
+def crc8(data: bytes) -> int:
+    crc = 0
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+def cobs_encode(data: bytes) -> bytes:
+    out = bytearray(b"\x00")
+    code_idx = 0
+    code = 1
+    for byte in data:
+        if byte == 0:
+            out[code_idx] = code
+            code_idx = len(out)
+            out.append(0)
+            code = 1
+            continue
+        out.append(byte)
+        code += 1
+        if code == 0xFF:
+            out[code_idx] = code
+            code_idx = len(out)
+            out.append(0)
+            code = 1
+    out[code_idx] = code
+    return bytes(out)
+
+def cobs_decode(data: bytes):
+    out = bytearray()
+    idx = 0
+    while idx < len(data):
+        code = data[idx]
+        if code == 0 or idx + code > len(data):
+            return None
+        out += data[idx + 1:idx + code]
+        idx += code
+        if code < 0xFF and idx < len(data):
+            out.append(0)
+    return bytes(out)
+
+def pack_samples(values, bits: int) -> bytes:
+    acc = 0
+    acc_bits = 0
+    out = bytearray()
+    for val in values:
+        acc |= (val & ((1 << bits) - 1)) << acc_bits
+        acc_bits += bits
+        while acc_bits >= 8:
+            out.append(acc & 0xFF)
+            acc >>= 8
+            acc_bits -= 8
+    if acc_bits:
+        out.append(acc & 0xFF)
+    return bytes(out)
+
+def unpack_samples(data: bytes, bits: int, count: int):
+    acc = int.from_bytes(data, "little")
+    mask = (1 << bits) - 1
+    return [(acc >> (idx * bits)) & mask for idx in range(count)]
+
+def mask_channels(mask: int):
+    return [chan for chan in range(FRAME_CHAN_NB_MAX) if mask & (1 << chan)]
+
+def frame_encode(seq: int, ts_us: int, values: dict, bits: int) -> bytes:
+    mask = 0
+    for chan in values:
+        mask |= 1 << chan
+    payload = struct.pack(FRAME_HDR_FMT, bits, seq % SEQ_MOD, ts_us % TS_MOD, mask)
+    payload += pack_samples([values[chan] for chan in mask_channels(mask)], bits)
+    payload += bytes([crc8(payload)])
+    return cobs_encode(payload) + FRAME_DELIM
+
+@dataclass
+class Frame:
+    seq: int
+    ts_us: int
+    bits: int
+    # Channel index : raw value, only channels present in frame
+    values: dict = field(default_factory=dict)
+
+class FrameDecoder:
+    """Splits a byte stream on delimiters and decodes frames, counting errors and lost frames"""
+
+    def __init__(self):
+        self.buf = bytearray()
+        self.seq_prev = None
+        self.frame_nb = 0
+        self.lost_nb = 0
+        self.error_nb = 0
+
+    def decode(self, raw: bytes):
+        payload = cobs_decode(raw)
+        if payload is None or len(payload) < FRAME_HDR_LEN + 1 or crc8(payload[:-1]) != payload[-1]:
+            return None
+        bits, seq, ts_us, mask = struct.unpack_from(FRAME_HDR_FMT, payload)
+        if bits == 0 or bits > 16:
+            return None
+        chans = mask_channels(mask)
+        data = payload[FRAME_HDR_LEN:-1]
+        if len(data) != (len(chans) * bits + 7) // 8:
+            return None
+        return Frame(seq, ts_us, bits, dict(zip(chans, unpack_samples(data, bits, len(chans)))))
+
+    def feed(self, data: bytes):
+        frames = []
+        self.buf += data
+        while True:
+            end = self.buf.find(FRAME_DELIM)
+            if end < 0:
+                return frames
+            raw = bytes(self.buf[:end])
+            del self.buf[:end + 1]
+            if not raw:
+                continue
+            frame = self.decode(raw)
+            if frame is None:
+                self.error_nb += 1
+                continue
+            if self.seq_prev is not None:
+                self.lost_nb += (frame.seq - self.seq_prev - 1) % SEQ_MOD
+            self.seq_prev = frame.seq
+            self.frame_nb += 1
+            frames.append(frame)
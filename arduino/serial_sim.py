@@ -0,0 +1,47 @@
+
+import argparse
+import math
+import os
+import time
+import tty
+
+from serial_frame import frame_encode
+
+US_PER_S = 1000000
+
+VAL_MID = 338
+VAL_AMPL = 300
+SAMPLE_BITS = 10
+
+def main():
+    parser = argparse.ArgumentParser(description="Stand-in for AnalogReadSerial, writes frames to a pty")
+    parser.add_argument("--rate", type=float, default=500, help="frames per second")
+    parser.add_argument("--bits", type=int, default=SAMPLE_BITS, help="sample width (13 : ESP raw stream)")
+    parser.add_argument("--chan-nb", type=int, default=4, help="channels per frame (2 : ESP raw stream)")
+    parser.add_argument("--drop", type=int, default=0, help="skip every Nth frame, to exercise lost frame detection")
+    args = parser.parse_args()
+
+    master, slave = os.openpty()
+    tty.setraw(slave)
+    print(os.ttyname(slave), flush=True)
+
+    seq = 0
+    t_start = time.monotonic()
+    while True:
+        t = time.monotonic() - t_start
+        # Slow circle on left stick, right stick centred
+        values = {
+            0: int(VAL_MID + VAL_AMPL * math.sin(t)),
+            1: int(VAL_MID + VAL_AMPL * math.cos(t)),
+            2: VAL_MID,
+            3: VAL_MID,
+        }
+        values = {chan: values[chan] for chan in range(args.chan_nb)}
+        frame = frame_encode(seq, int(t * US_PER_S), values, args.bits)
+        if not (args.drop and seq % args.drop == 0):
+            os.write(master, frame)
+        seq += 1
+        time.sleep(1 / args.rate)
+
+if __name__ == "__main__":
+    main()
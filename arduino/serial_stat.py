@@ -0,0 +1,93 @@
+
+import argparse
+import sys
+import time
+from serial import Serial
+
+from serial_frame import FrameDecoder, SEQ_MOD, TS_MOD
+
+US_PER_S = 1000000
+
+SERIAL_PORT = "/dev/ttyACM0"
+SERIAL_BAUD = 1000000
+
+REPORT_PERIOD_S = 1
+
+class Window:
+    """Throughput and gaps over one report period"""
+
+    def __init__(self, now: float):
+        self.t_start = now
+        self.byte_nb = 0
+        self.frame_nb = 0
+        self.sample_nb = 0
+        self.gap_nb = 0
+        self.lost_nb = 0
+        self.period_min_us = None
+        self.period_max_us = 0
+
+    def report(self, now: float, decoder: FrameDecoder, fmt: str):
+        span = now - self.t_start
+        period_avg_us = span * US_PER_S / self.frame_nb if self.frame_nb else 0
+        print(f"{fmt} {self.frame_nb / span:7.0f} frames/s {self.sample_nb / span:7.0f} samples/s "
+              f"{self.byte_nb / span / 1000:6.1f} kB/s, "
+              f"sender period {self.period_min_us}/{period_avg_us:.0f}/{self.period_max_us} us (min/avg/max), "
+              f"gaps {self.gap_nb} ({self.lost_nb} frames), "
+              f"total lost {decoder.lost_nb}/{decoder.frame_nb + decoder.lost_nb}, errors {decoder.error_nb}")
+
+def main():
+    parser = argparse.ArgumentParser(description="Report throughput and gaps of a framed sample stream (AnalogReadSerial or ESP raw stream)")
+    parser.add_argument("--port", default=SERIAL_PORT, help="serial port, CDC-ACM port of the ESP, or pty from serial_sim.py")
+    parser.add_argument("--baud", type=int, default=SERIAL_BAUD, help="ignored by CDC-ACM")
+    parser.add_argument("--period", type=float, default=REPORT_PERIOD_S, help="report period, in seconds")
+    parser.add_argument("--duration", type=float, default=0, help="stop after this many seconds (0 : never)")
+    args = parser.parse_args()
+
+    # Opening the port asserts DTR, the ESP only streams while it is set
+    serial = Serial(args.port, args.baud, timeout=args.period / 10)
+
+    decoder = FrameDecoder()
+    t_start = time.perf_counter()
+    window = Window(t_start)
+    seq_prev = None
+    ts_prev = None
+    fmt = "-"
+
+    try:
+        while True:
+            data = serial.read(serial.in_waiting or 1)
+            now = time.perf_counter()
+            window.byte_nb += len(data)
+
+            for frame in decoder.feed(data):
+                fmt = f"{frame.bits}b x{len(frame.values)}"
+                window.frame_nb += 1
+                window.sample_nb += len(frame.values)
+
+                if seq_prev is not None:
+                    lost = (frame.seq - seq_prev - 1) % SEQ_MOD
+                    if lost:
+                        window.gap_nb += 1
+                        window.lost_nb += lost
+                seq_prev = frame.seq
+
+                if ts_prev is not None:
+                    period_us = (frame.ts_us - ts_prev) % TS_MOD
+                    window.period_max_us = max(window.period_max_us, period_us)
+                    if window.period_min_us is None or period_us < window.period_min_us:
+                        window.period_min_us = period_us
+                ts_prev = frame.ts_us
+
+            if now - window.t_start >= args.period:
+                window.report(now, decoder, fmt)
+                window = Window(now)
+
+            if args.duration and now - t_start >= args.duration:
+                break
+    except KeyboardInterrupt:
+        pass
+
+    print(f"frames {decoder.frame_nb}, lost {decoder.lost_nb}, errors {decoder.error_nb}", file=sys.stderr)
+
+if __name__ == "__main__":
+    main()
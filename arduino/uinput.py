@@ -0,0 +1,89 @@
+
+import fcntl
+import os
+import stat
+import struct
+import time
+
+# linux/input-event-codes.h
+EV_SYN = 0x00
+EV_KEY = 0x01
+EV_REL = 0x02
+SYN_REPORT = 0x00
+REL_X = 0x00
+REL_Y = 0x01
+BTN_LEFT = 0x110
+BTN_RIGHT = 0x111
+BUS_USB = 0x03
+
+# struct input_event : timeval, type, code, value
+INPUT_EVENT_FMT = "llHHi"
+# struct uinput_setup : input_id (bustype, vendor, product, version), name[80], ff_effects_max
+UINPUT_SETUP_FMT = "HHHH80sI"
+UINPUT_NAME = b"thumb_mouse serial bridge"
+
+def _ioc(direction: int, nr: int, size: int) -> int:
+    return (direction << 30) | (size << 16) | (ord("U") << 8) | nr
+
+_IOC_WRITE = 1
+UI_DEV_CREATE = _ioc(0, 1, 0)
+UI_DEV_DESTROY = _ioc(0, 2, 0)
+UI_DEV_SETUP = _ioc(_IOC_WRITE, 3, struct.calcsize(UINPUT_SETUP_FMT))
+UI_SET_EVBIT = _ioc(_IOC_WRITE, 100, 4)
+UI_SET_KEYBIT = _ioc(_IOC_WRITE, 101, 4)
+UI_SET_RELBIT = _ioc(_IOC_WRITE, 102, 4)
+
+def input_event(ev_type: int, code: int, value: int, ts: float = 0.0) -> bytes:
+    sec = int(ts)
+    return struct.pack(INPUT_EVENT_FMT, sec, int((ts - sec) * 1000000), ev_type, code, value)
+
+class UInputMouse:
+    """Relative pointer on /dev/uinput, X, Y and SYN written in a single batch"""
+
+    def __init__(self, path: str = "/dev/uinput"):
+        # No O_CREAT : a missing node must fail, not turn into a regular file that swallows events
+        try:
+            self.fd = os.open(path, os.O_WRONLY | os.O_NONBLOCK)
+        except OSError as exc:
+            raise RuntimeError(f"cannot open {path} ({exc.strerror}), "
+                               "uinput module loaded (modprobe uinput) and node writable by this user?") from exc
+        if not stat.S_ISCHR(os.fstat(self.fd).st_mode):
+            os.close(self.fd)
+            raise RuntimeError(f"{path} is not a character device, record events with UInputDummy (--uinput-dummy) instead")
+        self._setup()
+
+    def _setup(self):
+        fcntl.ioctl(self.fd, UI_SET_EVBIT, EV_KEY)
+        # Buttons make the device classified as a mouse by libinput
+        fcntl.ioctl(self.fd, UI_SET_KEYBIT, BTN_LEFT)
+        fcntl.ioctl(self.fd, UI_SET_KEYBIT, BTN_RIGHT)
+        fcntl.ioctl(self.fd, UI_SET_EVBIT, EV_REL)
+        fcntl.ioctl(self.fd, UI_SET_RELBIT, REL_X)
+        fcntl.ioctl(self.fd, UI_SET_RELBIT, REL_Y)
+        fcntl.ioctl(self.fd, UI_DEV_SETUP, struct.pack(UINPUT_SETUP_FMT, BUS_USB, 0x303A, 0x8000, 1, UINPUT_NAME, 0))
+        fcntl.ioctl(self.fd, UI_DEV_CREATE)
+        # Let udev / compositor pick up the new device
+        time.sleep(0.5)
+
+    def move(self, dx: int, dy: int):
+        events = b""
+        if dx:
+            events += input_event(EV_REL, REL_X, dx)
+        if dy:
+            events += input_event(EV_REL, REL_Y, dy)
+        if not events:
+            return
+        os.write(self.fd, events + input_event(EV_SYN, SYN_REPORT, 0))
+
+    def close(self):
+        fcntl.ioctl(self.fd, UI_DEV_DESTROY)
+        os.close(self.fd)
+
+class UInputDummy(UInputMouse):
+    """Same events written as-is to a regular file or FIFO, created if missing, without device setup"""
+
+    def __init__(self, path: str):
+        self.fd = os.open(path, os.O_WRONLY | os.O_CREAT | os.O_TRUNC, 0o644)
+
+    def close(self):
+        os.close(self.fd)
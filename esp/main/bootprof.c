@@ -0,0 +1,159 @@
+
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "esp_private/esp_clk.h"
+
+#include "logger.h"
+
+#include "bootprof.h"
+
+static const char * STAGE_NAME_LIST[] =
+{
+    "app_main",
+    "logger",
+    "gpio",
+    "controller",
+    "transport",
+    "mouse / usb start",
+    "telemetry",
+    "monitor",
+    "predict",
+    "stream",
+    "mouse task",
+    "init done",
+    "usb mount",
+    "first cycle",
+    "first report",
+    "unknown",
+};
+
+_Static_assert(sizeof(STAGE_NAME_LIST) / sizeof(STAGE_NAME_LIST[0]) == BOOTPROF_STAGE_NB + 1U, "stage names");
+
+// esp_timer us at app_main to us from reset, 0 if unknown
+static uint32_t g_offsetUs = 0U;
+
+static esp_reset_reason_t g_resetReason = ESP_RST_UNKNOWN;
+
+// Written from the TinyUSB task too, 32 bits so reads are not torn
+static volatile uint32_t g_pStageUs[BOOTPROF_STAGE_NB];
+
+static void __attribute__((format (printf, 2, 3))) _log(LogLevel_e lvl, const char * sFmt, ...);
+
+static void _log(LogLevel_e lvl, const char * sFmt, ...)
+{
+    va_list pArg;
+
+    va_start(pArg, sFmt);
+    LOGGER_log_va(MODULE_ID_BOOTPROF, lvl, sFmt, pArg);
+    va_end(pArg);
+}
+
+void BOOTPROF_init(void)
+{
+    int64_t timerUs = esp_timer_get_time();
+    uint64_t rtcUs = 0U;
+
+    g_resetReason = esp_reset_reason();
+    g_offsetUs = 0U;
+
+    // RTC counter runs from power on only, it keeps counting over soft and deep sleep resets
+    if (g_resetReason == ESP_RST_POWERON)
+    {
+        rtcUs = esp_clk_rtc_time();
+    }
+
+    // esp_timer runs from its start in the app startup code
+    if (rtcUs > (uint64_t) timerUs)
+    {
+        g_offsetUs = (uint32_t) (rtcUs - (uint64_t) timerUs);
+    }
+
+    memset((void *) g_pStageUs, 0, sizeof(g_pStageUs));
+    BOOTPROF_mark(BOOTPROF_STAGE_APP_START);
+}
+
+void BOOTPROF_mark(BootStage_e stage)
+{
+    uint32_t nowUs = 0U;
+
+    if ((stage >= BOOTPROF_STAGE_NB) || g_pStageUs[stage])
+    {
+        return;
+    }
+
+    nowUs = (uint32_t) esp_timer_get_time() + g_offsetUs;
+    g_pStageUs[stage] = nowUs ? nowUs : 1U;
+}
+
+uint8_t BOOTPROF_isMarked(BootStage_e stage)
+{
+    return (stage < BOOTPROF_STAGE_NB) && g_pStageUs[stage];
+}
+
+uint32_t BOOTPROF_getUs(BootStage_e stage)
+{
+    if (stage >= BOOTPROF_STAGE_NB)
+    {
+        return 0U;
+    }
+
+    return g_pStageUs[stage];
+}
+
+// Chronological, FAST_BOOT_EN reorders the init stages
+void BOOTPROF_log(void)
+{
+    uint32_t prevUs = 0U;
+    uint32_t doneMask = 0U;
+
+    _Static_assert(BOOTPROF_STAGE_NB <= 32U, "stage mask");
+
+    LOGGER_setLevel(MODULE_ID_BOOTPROF, LOG_LVL_DEBUG);
+
+    if (g_offsetUs)
+    {
+        _log(LOG_LVL_INFO, "%-18s %8lu us", "before app_main", g_offsetUs);
+    }
+    else
+    {
+        _log(LOG_LVL_INFO, "Reset reason %d, time before app_main unknown, times from esp_timer start", g_resetReason);
+    }
+
+    for (uint8_t idx = 0U; idx < BOOTPROF_STAGE_NB; idx += 1U)
+    {
+        BootStage_e next = BOOTPROF_STAGE_NB;
+
+        for (BootStage_e stage = BOOTPROF_STAGE_APP_START; stage < BOOTPROF_STAGE_NB; stage += 1)
+        {
+            if ((doneMask & (1UL << stage)) || !g_pStageUs[stage])
+            {
+                continue;
+            }
+
+            if ((next == BOOTPROF_STAGE_NB) || (g_pStageUs[stage] < g_pStageUs[next]))
+            {
+                next = stage;
+            }
+        }
+
+        if (next == BOOTPROF_STAGE_NB)
+        {
+            break;
+        }
+
+        doneMask |= 1UL << next;
+        _log(LOG_LVL_INFO, "%-18s %8lu us, +%lu us", STAGE_NAME_LIST[next], g_pStageUs[next], prevUs ? g_pStageUs[next] - prevUs : 0U);
+        prevUs = g_pStageUs[next];
+    }
+
+    for (BootStage_e stage = BOOTPROF_STAGE_APP_START; stage < BOOTPROF_STAGE_NB; stage += 1)
+    {
+        if (!g_pStageUs[stage])
+        {
+            _log(LOG_LVL_INFO, "%-18s not reached", STAGE_NAME_LIST[stage]);
+        }
+    }
+}
@@ -0,0 +1,59 @@
+
+#ifndef BOOTPROF_H
+#define BOOTPROF_H
+
+#include <inttypes.h>
+
+/**
+ * @brief Boot stages, in app_main order
+ *
+ * Init stages are marked when the step completes. Marks are kept once, from
+ * any task, without logging, so they work before the logger is started.
+ */
+typedef enum BootStage_e
+{
+    BOOTPROF_STAGE_APP_START = 0,
+    BOOTPROF_STAGE_LOGGER,
+    BOOTPROF_STAGE_GPIO,
+    BOOTPROF_STAGE_CTRL,
+    BOOTPROF_STAGE_TRANSPORT,
+    // Transport started, USB enumeration runs from here
+    BOOTPROF_STAGE_MOUSE,
+    BOOTPROF_STAGE_TELEM,
+    BOOTPROF_STAGE_MONITOR,
+    BOOTPROF_STAGE_PREDICT,
+    BOOTPROF_STAGE_STREAM,
+    BOOTPROF_STAGE_TASK,
+    BOOTPROF_STAGE_INIT_DONE,
+    // Host configured the device
+    BOOTPROF_STAGE_USB_MOUNT,
+    // First report cycle processed by the mouse task
+    BOOTPROF_STAGE_FIRST_CYCLE,
+    // First report accepted by the transport, needs the mouse enabled
+    BOOTPROF_STAGE_FIRST_REPORT,
+    BOOTPROF_STAGE_NB,
+} BootStage_e;
+
+/**
+ * @brief First call in app_main
+ *
+ * After a power on reset, times are counted from reset : the time before
+ * app_main (ROM, bootloader and app startup as one stage) is estimated from
+ * the RTC slow clock counter, read with esp_clk_rtc_time from the ESP-IDF
+ * private header esp_private/esp_clk.h, which may change between IDF releases.
+ * After any other reset that counter does not restart with the boot, times are
+ * then counted from the esp_timer start.
+ */
+void BOOTPROF_init(void);
+
+void BOOTPROF_mark(BootStage_e stage);
+
+uint8_t BOOTPROF_isMarked(BootStage_e stage);
+
+// us from reset (from esp_timer start if not a power on reset), 0 if not reached
+uint32_t BOOTPROF_getUs(BootStage_e stage);
+
+// Table of every stage, from reset and from the previous one
+void BOOTPROF_log(void);
+
+#endif // BOOTPROF_H
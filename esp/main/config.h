@@ -7,44 +7,99 @@
 // GPIO2
 #define JOY_HW_Y_CHAN ADC1_CHANNEL_1
 
-#define JOY_HW_ADA 0
-#define JOY_HW_GAMEPAD 1
-#define JOY_HW JOY_HW_GAMEPAD
-
-#if (JOY_HW == JOY_HW_ADA)
-    #define JOY_X_MIN        50
-    #define JOY_X_CENTER     875
-    #define JOY_X_MAX        1600
-    #define JOY_X_DEADZONE   50
-    #define JOY_X_SIGN       -1
-
-    #define JOY_Y_MIN        50
-    #define JOY_Y_CENTER     870
-    #define JOY_Y_MAX        1600
-    #define JOY_Y_DEADZONE   50
-    #define JOY_Y_SIGN       -1
-#elif (JOY_HW == JOY_HW_GAMEPAD)
-    #define JOY_X_MIN        20
-    #define JOY_X_CENTER     412
-    #define JOY_X_MAX        800
-    #define JOY_X_DEADZONE   10
-    #define JOY_X_SIGN       -1
-
-    #define JOY_Y_MIN        20
-    #define JOY_Y_CENTER     400
-    #define JOY_Y_MAX        800
-    #define JOY_Y_DEADZONE   5
-    #define JOY_Y_SIGN       1
-#endif // JOY_HW
+// Hardware profile (HwProfileId_e, hw_profile.c table) selection at boot
+#define HW_PROFILE_SEL_FIXED 0
+// Strap pin, pulled up : HW_PROFILE_DFLT when high, HW_PROFILE_STRAP_LOW when low
+#define HW_PROFILE_SEL_STRAP 1
+// Stored setting (HW_PROFILE_save), HW_PROFILE_DFLT when none
+#define HW_PROFILE_SEL_NVS 2
+#define HW_PROFILE_SEL HW_PROFILE_SEL_FIXED
+
+#define HW_PROFILE_DFLT HW_PROFILE_ID_GAMEPAD
+#define HW_PROFILE_STRAP_GPIO GPIO_NUM_5
+#define HW_PROFILE_STRAP_LOW HW_PROFILE_ID_ADA
 
 #define DEADZONE 15
 
 // Oversampling
 #define ACQ_NB 10U
 
+// Decimating low pass FIR over the ACQ_NB acquisitions instead of their average
+#define CTRL_FIR_EN 0
+#define CTRL_FIR_TAP_NB (2U * ACQ_NB)
+// Preferred implementation (FirImpl_e), reference if not built for the target or not bit exact
+#define CTRL_FIR_IMPL FIR_IMPL_DSP
+
 #define MOUSE_REPORT_FREQ_HZ 60U
 #define MOUSE_SPEED_MAX 30
 
+// HID transport (TransportId_e)
+#define TRANSPORT_DFLT TRANSPORT_ID_USB
+
+// BLE transport
+#define BLE_DEVICE_NAME "Thumb Mouse"
+// Until the central updates connection parameters
+#define BLE_CONN_INTERVAL_DFLT_US 7500U
+
+// Loopback transport simulated connection interval
+#define TRANSPORT_LOOPBACK_INTERVAL_US 7500U
+
+// HID personality at boot (MousePersonality_e)
+#define MOUSE_PERSONALITY_DFLT MOUSE_PERSO_MOUSE
+
+// Absolute mode source
+#define MOUSE_ABS_SRC_INTEGRATE  0
+#define MOUSE_ABS_SRC_DEFLECTION 1
+#define MOUSE_ABS_SRC MOUSE_ABS_SRC_INTEGRATE
+
+// Absolute units per relative unit, when integrating
+#define MOUSE_ABS_GAIN 16
+
+// Relative motion backlog bound, per axis, beyond it motion is dropped and counted (host not polling)
+#define MOUSE_MOVE_ACC_MAX 4096
+
+// Boot button hold time to switch between relative and absolute mode
+#define MODE_SWITCH_PRESS_MS 1000U
+
+// Wheel / pan units per detent when the host enables the resolution multiplier
+#define MOUSE_SCROLL_RES_MULT 16U
+
+// Predictive stage on the report cycle average (alpha-beta), gains Q8
+#define PREDICT_EN_DFLT 0U
+#define PREDICT_ALPHA_DFLT 224U
+#define PREDICT_BETA_DFLT 32U
+// Extrapolation ahead of the averaged sample, half a report period plus the wait for the next flush
+#define PREDICT_LEAD_US (US_PER_S / MOUSE_REPORT_FREQ_HZ)
+
+// Raw acquisitions streamed over USB CDC-ACM, needs CONFIG_TINYUSB_CDC_ENABLED
+#define STREAM_EN 0
+
+// Report cycle monitor : period over nominal + tolerance is an overrun
+#define MONITOR_OVERRUN_TOL_US 2000U
+// Capture the cycles around the first period over threshold (0 : off)
+#define MONITOR_CAPTURE_TH_US (3U * US_PER_S / MOUSE_REPORT_FREQ_HZ)
+// Stats log period, in report cycles (0 : off)
+#define MONITOR_LOG_CYCLE_NB (10U * MOUSE_REPORT_FREQ_HZ)
+
+// Telemetry report period, in mouse report cycles (0 : disabled)
+#define TELEMETRY_PERIOD_DFLT 1U
+
+// Every long lived instance, queue and task in .bss instead of heap
+#define STATIC_ALLOC_EN 0
+
+#define LOGGER_TASK_STACK_SIZE 0x1000U
+#define MOUSE_TASK_STACK_SIZE 0x1000U
+
+// USB started first, rest initialized during enumeration, logger started last
+#define FAST_BOOT_EN 0
+// Boot stage timings logged at the first report, or after this delay with what is reached
+#define BOOTPROF_LOG_TIMEOUT_MS 5000U
+
+// Stack high water marks, heap minimum and CPU load log period (0 : off)
+#define SYSMON_LOG_PERIOD_MS 10000U
+// CPU load measurement period, FreeRTOS run time stats (0 : off)
+#define SYSMON_CPU_PERIOD_MS 1000U
+
 #define MOUSE_LOG_LOOP_NB 20U
 #define CTRL_LOG_LOOP_NB (MOUSE_LOG_LOOP_NB * 4U)
 
@@ -4,14 +4,20 @@
 #include <string.h>
 
 #include "driver/adc.h"
+#include "esp_timer.h"
 
 #include "config.h"
 #include "logger.h"
+#include "utils.h"
 
 #include "controller.h"
 
 static const uint32_t MAGIC = 561348;
 
+UTILS_INST_POOL(Controller_t, 1);
+
+_Static_assert(!CTRL_FIR_EN || (ACQ_NB >= 2U), "FIR decimates by ACQ_NB, needs at least 2");
+
 static void __attribute__((format (printf, 2, 3))) _log(LogLevel_e lvl, const char * sFmt, ...);
 
 static void _log(LogLevel_e lvl, const char * sFmt, ...)
@@ -23,22 +29,41 @@ static void _log(LogLevel_e lvl, const char * sFmt, ...)
     va_end(pArg);
 }
 
-static int32_t map(int32_t in, int32_t in_min, int32_t in_max, int32_t out_min, int32_t out_max)
+// adc1_get_raw returns -1 on error, that would map to a full deflection
+static int16_t adcRead(Controller_t * pInst, adc1_channel_t chan, int32_t * pLast)
 {
-    if (in < in_min)
+    int raw = adc1_get_raw(chan);
+
+    if ((raw < 0) || (raw > HW_PROFILE_RAW_MAX))
     {
-        return out_min;
+        if (pInst->adcErrNb == 0U)
+        {
+            _log(LOG_LVL_WARN, "%s() Channel %u read FAILED (%d), last value used", __func__, chan, raw);
+        }
+        pInst->adcErrNb += 1U;
+        return (int16_t) *pLast;
     }
 
-    if (in > in_max)
+    *pLast = raw;
+
+    return (int16_t) raw;
+}
+
+static void sampleOut(Controller_t * pInst, int16_t x, int16_t y)
+{
+    Coord_t sample;
+
+    if (!pInst->sampleCb)
     {
-        return out_max;
+        return;
     }
 
-    return (in - in_min) * (out_max - out_min) / in_max + out_min;
+    sample.x = x;
+    sample.y = y;
+    pInst->sampleCb((uint32_t) esp_timer_get_time(), &sample, pInst->pSampleArg);
 }
 
-Controller_t * CONTROLLER_init(void)
+Controller_t * CONTROLLER_init(const HwProfile_t * pProfile)
 {
     Controller_t * pInst = NULL;
 
@@ -46,19 +71,58 @@ Controller_t * CONTROLLER_init(void)
 
     _log(LOG_LVL_DEBUG, "%s()", __func__);
 
-    _log(LOG_LVL_DEBUG, "%s() Configure ADC", __func__);
+    if (!pProfile)
+    {
+        _log(LOG_LVL_ERROR, "%s() pProfile NULL", __func__);
+        return NULL;
+    }
+
+    _log(LOG_LVL_DEBUG, "%s() Configure ADC, %s profile", __func__, pProfile->sName);
     adc1_config_width(ADC_WIDTH_BIT_13);
-    adc1_config_channel_atten(JOY_HW_X_CHAN, ADC_ATTEN_DB_0);
-    adc1_config_channel_atten(JOY_HW_Y_CHAN, ADC_ATTEN_DB_0);
+    adc1_config_channel_atten((adc1_channel_t) pProfile->x.chan, ADC_ATTEN_DB_0);
+    adc1_config_channel_atten((adc1_channel_t) pProfile->y.chan, ADC_ATTEN_DB_0);
 
-    pInst = (Controller_t *) malloc(sizeof(Controller_t));
+    pInst = UTILS_INST_ALLOC(Controller_t);
     if (!pInst)
     {
-        _log(LOG_LVL_ERROR, "%s() malloc %u Bytes for Controller_t FAILED", __func__, sizeof(Controller_t));
+        _log(LOG_LVL_ERROR, "%s() Alloc %u Bytes for Controller_t FAILED", __func__, sizeof(Controller_t));
         return NULL;
     }
 
     pInst->magic = MAGIC;
+    pInst->pProfile = pProfile;
+    pInst->coordRaw.x = 0;
+    pInst->coordRaw.y = 0;
+    pInst->acqLast.x = pProfile->x.center;
+    pInst->acqLast.y = pProfile->y.center;
+    pInst->adcErrNb = 0U;
+    pInst->pFirX = NULL;
+    pInst->pFirY = NULL;
+    pInst->sampleCb = NULL;
+    pInst->pSampleArg = NULL;
+
+    if (CTRL_FIR_EN)
+    {
+        FirImpl_e impl = CTRL_FIR_IMPL;
+
+        // Logs samples/s of each implementation, keep the reference unless bit exact
+        if (FIR_selfTest(CTRL_FIR_TAP_NB, ACQ_NB) || !FIR_isAvailable(impl))
+        {
+            _log(LOG_LVL_WARN, "%s() FIR implementation %u not usable, reference used", __func__, impl);
+            impl = FIR_IMPL_REF;
+        }
+
+        pInst->pFirX = FIR_init(CTRL_FIR_TAP_NB, ACQ_NB, impl);
+        pInst->pFirY = FIR_init(CTRL_FIR_TAP_NB, ACQ_NB, impl);
+        if (!pInst->pFirX || !pInst->pFirY)
+        {
+            _log(LOG_LVL_ERROR, "%s() FIR_init FAILED", __func__);
+            UTILS_INST_FREE(pInst->pFirX);
+            UTILS_INST_FREE(pInst->pFirY);
+            UTILS_INST_FREE(pInst);
+            return NULL;
+        }
+    }
 
     return pInst;
 }
@@ -66,6 +130,8 @@ Controller_t * CONTROLLER_init(void)
 uint8_t CONTROLLER_getJoy(Controller_t * pInst, Coord_t * pCoord)
 {
     static uint16_t callCnt = 0U;
+    adc1_channel_t chanX = ADC1_CHANNEL_0;
+    adc1_channel_t chanY = ADC1_CHANNEL_0;
 
     if (!pInst || pInst->magic != MAGIC)
     {
@@ -81,56 +147,121 @@ uint8_t CONTROLLER_getJoy(Controller_t * pInst, Coord_t * pCoord)
 
     pCoord->x = 0;
     pCoord->y = 0;
+    chanX = (adc1_channel_t) pInst->pProfile->x.chan;
+    chanY = (adc1_channel_t) pInst->pProfile->y.chan;
 
-    for (uint8_t acq_idx = 0U; acq_idx < ACQ_NB; acq_idx += 1U)
+    if (CTRL_FIR_EN)
     {
-        pCoord->x += (int32_t) adc1_get_raw(JOY_HW_X_CHAN);
-        pCoord->y += (int32_t) adc1_get_raw(JOY_HW_Y_CHAN);
+        int16_t pAcqX[ACQ_NB];
+        int16_t pAcqY[ACQ_NB];
+        int16_t firX = 0;
+        int16_t firY = 0;
+
+        for (uint8_t acq_idx = 0U; acq_idx < ACQ_NB; acq_idx += 1U)
+        {
+            pAcqX[acq_idx] = adcRead(pInst, chanX, &pInst->acqLast.x);
+            pAcqY[acq_idx] = adcRead(pInst, chanY, &pInst->acqLast.y);
+            sampleOut(pInst, pAcqX[acq_idx], pAcqY[acq_idx]);
+        }
+
+        // Filter history spans calls, one output per ACQ_NB acquisitions
+        FIR_decimate(pInst->pFirX, pAcqX, ACQ_NB, &firX);
+        FIR_decimate(pInst->pFirY, pAcqY, ACQ_NB, &firY);
+
+        pCoord->x = firX;
+        pCoord->y = firY;
+    }
+    else
+    {
+        for (uint8_t acq_idx = 0U; acq_idx < ACQ_NB; acq_idx += 1U)
+        {
+            int16_t acqX = adcRead(pInst, chanX, &pInst->acqLast.x);
+            int16_t acqY = adcRead(pInst, chanY, &pInst->acqLast.y);
+
+            sampleOut(pInst, acqX, acqY);
+            pCoord->x += acqX;
+            pCoord->y += acqY;
+        }
+
+        pCoord->x /= ACQ_NB;
+        pCoord->y /= ACQ_NB;
     }
 
-    pCoord->x /= ACQ_NB;
-    pCoord->y /= ACQ_NB;
+    pInst->coordRaw = *pCoord;
 
     if ((CTRL_LOG_LOOP_NB < 0xFF) && (callCnt == CTRL_LOG_LOOP_NB))
     {
-        _log(LOG_LVL_DEBUG, "(raw) x = %04ld, y = %04ld", pCoord->x, pCoord->y);
+        _log(LOG_LVL_DEBUG, "(raw) x = %04ld, y = %04ld, adc errors %lu", pCoord->x, pCoord->y, pInst->adcErrNb);
     }
 
-    if (pCoord->x < JOY_X_CENTER)
+    // Profile slopes, no division per sample
+    pCoord->x = HW_PROFILE_map(&pInst->pProfile->x, pCoord->x);
+    pCoord->y = HW_PROFILE_map(&pInst->pProfile->y, pCoord->y);
+
+    if ((CTRL_LOG_LOOP_NB < 0xFF) && (callCnt == CTRL_LOG_LOOP_NB))
     {
-        pCoord->x = (int8_t) map(pCoord->x, JOY_X_MIN, JOY_X_CENTER - JOY_X_DEADZONE / 2, X_OUT_MIN, X_OUT_CENTER);
+        _log(LOG_LVL_DEBUG, "(map) x = %04ld, y = %04ld", pCoord->x, pCoord->y);
+        callCnt = 0U;
     }
-    else
+
+    callCnt += 1U;
+
+    return 0U;
+}
+
+uint8_t CONTROLLER_getRaw(Controller_t * pInst, Coord_t * pCoord)
+{
+    if (!pInst || pInst->magic != MAGIC)
     {
-        pCoord->x = (int8_t) map(pCoord->x, JOY_X_CENTER - JOY_X_DEADZONE / 2, JOY_X_MAX, X_OUT_CENTER, X_OUT_MAX);
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return 1U;
     }
 
-    if (pCoord->y < JOY_Y_CENTER)
+    if (!pCoord)
     {
-        pCoord->y = (int8_t) map(pCoord->y, JOY_Y_MIN, JOY_Y_CENTER - JOY_Y_DEADZONE / 2, Y_OUT_MIN, Y_OUT_CENTER);
+        _log(LOG_LVL_ERROR, "%s() pCoord NULL", __func__);
+        return 1U;
     }
-    else
+
+    *pCoord = pInst->coordRaw;
+
+    return 0U;
+}
+
+uint8_t CONTROLLER_setSampleCb(Controller_t * pInst, CtrlSampleCb_t sampleCb, void * pArg)
+{
+    if (!pInst || pInst->magic != MAGIC)
     {
-        pCoord->y = (int8_t) map(pCoord->y, JOY_Y_CENTER - JOY_Y_DEADZONE / 2, JOY_Y_MAX, Y_OUT_CENTER, Y_OUT_MAX);
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return 1U;
     }
 
-    if (JOY_X_SIGN < 0)
+    pInst->sampleCb = sampleCb;
+    pInst->pSampleArg = pArg;
+
+    return 0U;
+}
+
+void CONTROLLER_toMotion(const Coord_t * pJoy, Coord_t * pMotion)
+{
+    pMotion->x = 0;
+    pMotion->y = 0;
+
+    if (pJoy->x < X_OUT_CENTER - DEADZONE)
     {
-        pCoord->x = -pCoord->x;
+        pMotion->x = - (X_OUT_CENTER - pJoy->x - DEADZONE) / 3;
     }
-
-    if (JOY_Y_SIGN < 0)
+    else if (pJoy->x > X_OUT_CENTER + DEADZONE)
     {
-        pCoord->y = -pCoord->y;
+        pMotion->x = (pJoy->x - X_OUT_CENTER - DEADZONE) / 3;
     }
 
-    if ((CTRL_LOG_LOOP_NB < 0xFF) && (callCnt == CTRL_LOG_LOOP_NB))
+    if (pJoy->y < Y_OUT_CENTER - DEADZONE)
     {
-        _log(LOG_LVL_DEBUG, "(map) x = %04ld, y = %04ld", pCoord->x, pCoord->y);
-        callCnt = 0U;
+        pMotion->y = - (Y_OUT_CENTER - pJoy->y - DEADZONE) / 3;
+    }
+    else if (pJoy->y > Y_OUT_CENTER + DEADZONE)
+    {
+        pMotion->y = (pJoy->y - Y_OUT_CENTER - DEADZONE) / 3;
     }
-
-    callCnt += 1U;
-
-    return 0U;
 }
@@ -4,23 +4,50 @@
 
 #include <inttypes.h>
 
+#include "fir.h"
+#include "hw_profile.h"
 #include "utils.h"
 
 // (X, Y) mapped values ranges
-#define X_OUT_MIN (-100)
-#define X_OUT_MAX 100
-#define Y_OUT_MIN (-100)
-#define Y_OUT_MAX 100
+#define X_OUT_MIN HW_PROFILE_OUT_MIN
+#define X_OUT_MAX HW_PROFILE_OUT_MAX
+#define Y_OUT_MIN HW_PROFILE_OUT_MIN
+#define Y_OUT_MAX HW_PROFILE_OUT_MAX
 #define X_OUT_CENTER (X_OUT_MIN + (X_OUT_MAX - X_OUT_MIN) / 2)
 #define Y_OUT_CENTER (Y_OUT_MIN + (Y_OUT_MAX - Y_OUT_MIN) / 2)
 
+// Every acquisition, before averaging or filtering : raw X/Y as used (last good value on a failed read)
+typedef void (*CtrlSampleCb_t)(uint32_t timestampUs, const Coord_t * pRaw, void * pArg);
+
 typedef struct Controller_t
 {
     uint32_t magic;
+    const HwProfile_t * pProfile;
+    // Last averaged raw ADC values
+    Coord_t coordRaw;
+    // Last good acquisition, stands in for failed reads
+    Coord_t acqLast;
+    // Failed ADC reads since init
+    uint32_t adcErrNb;
+    // Decimating filters, CTRL_FIR_EN
+    Fir_t * pFirX;
+    Fir_t * pFirY;
+    // Raw sample sink, NULL : none
+    CtrlSampleCb_t sampleCb;
+    void * pSampleArg;
 } Controller_t;
 
-Controller_t * CONTROLLER_init(void);
+Controller_t * CONTROLLER_init(const HwProfile_t * pProfile);
 
 uint8_t CONTROLLER_getJoy(Controller_t * pInst, Coord_t * pCoord);
 
+// Averaged (or filtered) raw values behind last CONTROLLER_getJoy
+uint8_t CONTROLLER_getRaw(Controller_t * pInst, Coord_t * pCoord);
+
+// Called from CONTROLLER_getJoy for each of its ACQ_NB acquisitions, NULL to stop
+uint8_t CONTROLLER_setSampleCb(Controller_t * pInst, CtrlSampleCb_t sampleCb, void * pArg);
+
+// Mapped value (X/Y_OUT range) to relative motion, 0 within DEADZONE of the center
+void CONTROLLER_toMotion(const Coord_t * pJoy, Coord_t * pMotion);
+
 #endif // CONTROLLER_H
@@ -0,0 +1,257 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sdkconfig.h"
+#include "esp_timer.h"
+
+#include "logger.h"
+#include "utils.h"
+
+#include "fir.h"
+
+// Vector path only where PIE is available
+#if CONFIG_IDF_TARGET_ESP32S3
+#define FIR_DSP_AVAILABLE 1U
+#include "dsps_fird.h"
+#else
+#define FIR_DSP_AVAILABLE 0U
+#endif
+
+// esp-dsp reads 8 samples past the taps and wants 16 Bytes alignment
+#define FIR_DSP_PAD 8U
+#define FIR_DSP_ALIGN 16U
+
+// Self test outputs per implementation and benchmark calls
+#define FIR_TEST_OUT_NB 32U
+#define FIR_BENCH_LOOP_NB 500U
+
+static const uint32_t MAGIC = 561348;
+
+struct Fir_t
+{
+    uint32_t magic;
+    FirImpl_e impl;
+    uint16_t decim;
+    int16_t pCoef[FIR_TAP_MAX + FIR_DSP_PAD] __attribute__((aligned(FIR_DSP_ALIGN)));
+    FirRef_t ref;
+#if FIR_DSP_AVAILABLE
+    fir_s16_t dsp;
+    int16_t pDelay[FIR_TAP_MAX + FIR_DSP_PAD] __attribute__((aligned(FIR_DSP_ALIGN)));
+#endif
+};
+
+// One per controller axis
+UTILS_INST_POOL(Fir_t, 2);
+
+static const char * IMPL_NAME_LIST[] =
+{
+    "ref",
+    "dsp",
+    "unknown",
+};
+
+static void __attribute__((format (printf, 2, 3))) _log(LogLevel_e lvl, const char * sFmt, ...);
+
+static void _log(LogLevel_e lvl, const char * sFmt, ...)
+{
+    va_list pArg;
+
+    va_start(pArg, sFmt);
+    LOGGER_log_va(MODULE_ID_FIR, lvl, sFmt, pArg);
+    va_end(pArg);
+}
+
+uint8_t FIR_isAvailable(FirImpl_e impl)
+{
+    if (impl == FIR_IMPL_DSP)
+    {
+        return FIR_DSP_AVAILABLE;
+    }
+
+    return impl < FIR_IMPL_NB;
+}
+
+// Caller provided storage, instances or self test stack
+static uint8_t firSetup(Fir_t * pInst, uint16_t tapNb, uint16_t decim, FirImpl_e impl)
+{
+    memset(pInst, 0, sizeof(Fir_t));
+
+    if (FIR_REF_design(pInst->pCoef, tapNb, decim) || FIR_REF_init(&pInst->ref, pInst->pCoef, tapNb, decim))
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad taps %u (max %u) or decimation %u", __func__, tapNb, FIR_TAP_MAX, decim);
+        return 1U;
+    }
+
+#if FIR_DSP_AVAILABLE
+    if (impl == FIR_IMPL_DSP)
+    {
+        // Q15 coefficients, result shifted back by 15
+        if (dsps_fird_init_s16(&pInst->dsp, pInst->pCoef, pInst->pDelay, tapNb, decim, 0, 0) != ESP_OK)
+        {
+            _log(LOG_LVL_ERROR, "%s() dsps_fird_init_s16 FAILED", __func__);
+            return 1U;
+        }
+    }
+#endif
+
+    pInst->magic = MAGIC;
+    pInst->impl = impl;
+    pInst->decim = decim;
+
+    return 0U;
+}
+
+Fir_t * FIR_init(uint16_t tapNb, uint16_t decim, FirImpl_e impl)
+{
+    Fir_t * pInst = NULL;
+
+    LOGGER_setLevel(MODULE_ID_FIR, LOG_LVL_DEBUG);
+
+    _log(LOG_LVL_DEBUG, "%s() %u taps, decimation %u, %s", __func__, tapNb, decim, IMPL_NAME_LIST[(impl < FIR_IMPL_NB) ? impl : FIR_IMPL_NB]);
+
+    if (!FIR_isAvailable(impl))
+    {
+        _log(LOG_LVL_ERROR, "%s() Implementation %u not available on this target", __func__, impl);
+        return NULL;
+    }
+
+    // Heap alignment is 4 Bytes, the dsp buffers need FIR_DSP_ALIGN, carried by the type
+    pInst = UTILS_INST_ALLOC(Fir_t);
+    if (!pInst)
+    {
+        _log(LOG_LVL_ERROR, "%s() Alloc %u Bytes for Fir_t FAILED", __func__, sizeof(Fir_t));
+        return NULL;
+    }
+
+    if (firSetup(pInst, tapNb, decim, impl))
+    {
+        UTILS_INST_FREE(pInst);
+        return NULL;
+    }
+
+    return pInst;
+}
+
+FirImpl_e FIR_getImpl(Fir_t * pInst)
+{
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return FIR_IMPL_NB;
+    }
+
+    return pInst->impl;
+}
+
+uint16_t FIR_decimate(Fir_t * pInst, const int16_t * pIn, uint16_t inNb, int16_t * pOut)
+{
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return 0U;
+    }
+
+    if (!pIn || !pOut)
+    {
+        _log(LOG_LVL_ERROR, "%s() pIn or pOut NULL", __func__);
+        return 0U;
+    }
+
+#if FIR_DSP_AVAILABLE
+    if (pInst->impl == FIR_IMPL_DSP)
+    {
+        // Length is the output count, decim inputs each
+        return (uint16_t) dsps_fird_s16(&pInst->dsp, pIn, pOut, inNb / pInst->decim);
+    }
+#endif
+
+    return FIR_REF_decimate(&pInst->ref, pIn, inNb, pOut);
+}
+
+// Input samples per second over FIR_BENCH_LOOP_NB calls, one output each as in the controller
+static uint32_t bench(Fir_t * pInst, const int16_t * pIn)
+{
+    int64_t startUs = esp_timer_get_time();
+    int64_t spanUs = 0;
+    int16_t out = 0;
+
+    for (uint16_t loop = 0U; loop < FIR_BENCH_LOOP_NB; loop += 1U)
+    {
+        FIR_decimate(pInst, pIn, pInst->decim, &out);
+    }
+
+    spanUs = esp_timer_get_time() - startUs;
+    if (spanUs <= 0)
+    {
+        return 0U;
+    }
+
+    return (uint32_t) ((int64_t) pInst->decim * FIR_BENCH_LOOP_NB * US_PER_S / spanUs);
+}
+
+// No allocation : one instance on the stack reused per implementation, input generated per block
+uint8_t FIR_selfTest(uint16_t tapNb, uint16_t decim)
+{
+    uint8_t ret = 0U;
+    Fir_t fir;
+    int16_t pBlock[FIR_TAP_MAX];
+    int16_t pOutRef[FIR_TEST_OUT_NB];
+
+    if ((decim < 2U) || (decim > FIR_TAP_MAX))
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad decimation %u", __func__, decim);
+        return 1U;
+    }
+
+    // Reference first, the others compare against its outputs
+    for (FirImpl_e impl = FIR_IMPL_REF; impl < FIR_IMPL_NB; impl += 1)
+    {
+        uint32_t lfsr = 0xACE1U;
+        uint32_t rate = 0U;
+
+        if (!FIR_isAvailable(impl))
+        {
+            continue;
+        }
+
+        if (firSetup(&fir, tapNb, decim, impl))
+        {
+            return 1U;
+        }
+
+        for (uint16_t outIdx = 0U; outIdx < FIR_TEST_OUT_NB; outIdx += 1U)
+        {
+            int16_t out = 0;
+
+            // Full scale pseudo random input, stresses rounding and saturation
+            for (uint16_t idx = 0U; idx < decim; idx += 1U)
+            {
+                lfsr = lfsr * 1103515245U + 12345U;
+                pBlock[idx] = (int16_t) (lfsr >> 16);
+            }
+
+            if (FIR_decimate(&fir, pBlock, decim, &out) != 1U)
+            {
+                out = INT16_MIN;
+            }
+
+            if (impl == FIR_IMPL_REF)
+            {
+                pOutRef[outIdx] = out;
+            }
+            else if (out != pOutRef[outIdx])
+            {
+                _log(LOG_LVL_ERROR, "%s() %s differs from reference at %u", __func__, IMPL_NAME_LIST[impl], outIdx);
+                ret = 1U;
+                break;
+            }
+        }
+
+        rate = bench(&fir, pBlock);
+        _log(LOG_LVL_INFO, "%s : %lu samples/s (%u taps, decimation %u)", IMPL_NAME_LIST[impl], rate, tapNb, decim);
+    }
+
+    return ret;
+}
@@ -0,0 +1,63 @@
+
+#ifndef FIR_H
+#define FIR_H
+
+#include <inttypes.h>
+
+// Coefficients are Q15, sum to FIR_COEF_ONE (unity DC gain)
+#define FIR_COEF_SHIFT 15U
+#define FIR_COEF_ONE (1L << FIR_COEF_SHIFT)
+
+#define FIR_TAP_MAX 64U
+
+typedef enum FirImpl_e
+{
+    // Portable C, bit exact reference
+    FIR_IMPL_REF = 0,
+    // esp-dsp dsps_fird_s16, vector instructions on ESP32-S3
+    FIR_IMPL_DSP,
+    FIR_IMPL_NB,
+} FirImpl_e;
+
+/**
+ * @brief Reference decimator state, portable C (fir_ref.c, builds on the host)
+ */
+typedef struct FirRef_t
+{
+    const int16_t * pCoef;
+    uint16_t tapNb;
+    uint16_t decim;
+    // Circular delay line, next write position
+    uint16_t pos;
+    int16_t pDelay[FIR_TAP_MAX];
+} FirRef_t;
+
+typedef struct Fir_t Fir_t;
+
+/************* Reference, fir_ref.c ****************/
+
+// Windowed sinc low pass, cutoff at the decimated Nyquist frequency, decim >= 2
+// Symmetric (linear phase), coefficients sum to FIR_COEF_ONE
+uint8_t FIR_REF_design(int16_t * pCoef, uint16_t tapNb, uint16_t decim);
+
+uint8_t FIR_REF_init(FirRef_t * pRef, const int16_t * pCoef, uint16_t tapNb, uint16_t decim);
+
+// inNb multiple of decim, writes inNb / decim samples, return written count
+uint16_t FIR_REF_decimate(FirRef_t * pRef, const int16_t * pIn, uint16_t inNb, int16_t * pOut);
+
+/************* Module, fir.c ****************/
+
+// Implementation built for this target
+uint8_t FIR_isAvailable(FirImpl_e impl);
+
+Fir_t * FIR_init(uint16_t tapNb, uint16_t decim, FirImpl_e impl);
+
+FirImpl_e FIR_getImpl(Fir_t * pInst);
+
+// inNb multiple of decim, writes inNb / decim samples, return written count
+uint16_t FIR_decimate(Fir_t * pInst, const int16_t * pIn, uint16_t inNb, int16_t * pOut);
+
+// Check every implementation against the reference and log samples/s, 0 if all bit exact
+uint8_t FIR_selfTest(uint16_t tapNb, uint16_t decim);
+
+#endif // FIR_H
@@ -0,0 +1,140 @@
+
+// Portable reference, no ESP-IDF dependency so it builds on the host as is
+
+#include <math.h>
+#include <string.h>
+
+#include "fir.h"
+
+static int16_t sat16(int64_t val)
+{
+    if (val > INT16_MAX)
+    {
+        return INT16_MAX;
+    }
+
+    if (val < INT16_MIN)
+    {
+        return INT16_MIN;
+    }
+
+    return (int16_t) val;
+}
+
+uint8_t FIR_REF_design(int16_t * pCoef, uint16_t tapNb, uint16_t decim)
+{
+    double pWeight[FIR_TAP_MAX];
+    int32_t pQuant[FIR_TAP_MAX];
+    double sum = 0.0;
+    int32_t qSum = 0;
+    int32_t residue = 0;
+    const double center = (tapNb - 1U) / 2.0;
+
+    // No decimation, no low pass : a unity tap would not fit Q15
+    if (!pCoef || (tapNb == 0U) || (tapNb > FIR_TAP_MAX) || (decim < 2U))
+    {
+        return 1U;
+    }
+
+    // Hamming windowed sinc, cutoff 0.5 / decim of the input rate
+    for (uint16_t tap = 0U; tap < tapNb; tap += 1U)
+    {
+        double t = tap - center;
+        double sinc = (t == 0.0) ? 1.0 : sin(M_PI * t / decim) / (M_PI * t / decim);
+        double win = (tapNb == 1U) ? 1.0 : 0.54 - 0.46 * cos(2.0 * M_PI * tap / (tapNb - 1U));
+
+        pWeight[tap] = sinc * win;
+        sum += pWeight[tap];
+    }
+
+    // Second half mirrors the first, exact linear phase whatever the rounding
+    for (uint16_t tap = 0U; tap < tapNb; tap += 1U)
+    {
+        uint16_t mirror = tapNb - 1U - tap;
+
+        pQuant[tap] = (tap <= mirror) ? (int32_t) lround(pWeight[tap] / sum * FIR_COEF_ONE) : pQuant[mirror];
+        qSum += pQuant[tap];
+    }
+
+    // Quantization error on the center tap(s), exact unity DC gain. Even tap
+    // count : taps come in pairs, the residue is even and split over both.
+    residue = (int32_t) FIR_COEF_ONE - qSum;
+    if (tapNb % 2U)
+    {
+        pQuant[tapNb / 2U] += residue;
+    }
+    else
+    {
+        pQuant[tapNb / 2U - 1U] += residue / 2;
+        pQuant[tapNb / 2U] += residue / 2;
+    }
+
+    for (uint16_t tap = 0U; tap < tapNb; tap += 1U)
+    {
+        if ((pQuant[tap] > INT16_MAX) || (pQuant[tap] < INT16_MIN))
+        {
+            return 1U;
+        }
+
+        pCoef[tap] = (int16_t) pQuant[tap];
+    }
+
+    return 0U;
+}
+
+uint8_t FIR_REF_init(FirRef_t * pRef, const int16_t * pCoef, uint16_t tapNb, uint16_t decim)
+{
+    if (!pRef || !pCoef || (tapNb == 0U) || (tapNb > FIR_TAP_MAX) || (decim == 0U))
+    {
+        return 1U;
+    }
+
+    memset(pRef, 0, sizeof(FirRef_t));
+
+    pRef->pCoef = pCoef;
+    pRef->tapNb = tapNb;
+    pRef->decim = decim;
+
+    return 0U;
+}
+
+uint16_t FIR_REF_decimate(FirRef_t * pRef, const int16_t * pIn, uint16_t inNb, int16_t * pOut)
+{
+    uint16_t outNb = 0U;
+    uint16_t inIdx = 0U;
+
+    while (inIdx + pRef->decim <= inNb)
+    {
+        int64_t acc = 0;
+        uint16_t pos = 0U;
+
+        for (uint16_t idx = 0U; idx < pRef->decim; idx += 1U)
+        {
+            pRef->pDelay[pRef->pos] = pIn[inIdx];
+            inIdx += 1U;
+            pRef->pos += 1U;
+            if (pRef->pos >= pRef->tapNb)
+            {
+                pRef->pos = 0U;
+            }
+        }
+
+        // Newest sample with coefficient 0, oldest with the last one
+        pos = pRef->pos;
+        for (uint16_t tap = pRef->tapNb; tap > 0U; tap -= 1U)
+        {
+            acc += (int32_t) pRef->pCoef[tap - 1U] * pRef->pDelay[pos];
+            pos += 1U;
+            if (pos >= pRef->tapNb)
+            {
+                pos = 0U;
+            }
+        }
+
+        // Round to nearest
+        pOut[outNb] = sat16((acc + (1L << (FIR_COEF_SHIFT - 1U))) >> FIR_COEF_SHIFT);
+        outNb += 1U;
+    }
+
+    return outNb;
+}
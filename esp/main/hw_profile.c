@@ -0,0 +1,254 @@
+
+#include <stdio.h>
+#include <string.h>
+
+#include "driver/adc.h"
+#include "driver/gpio.h"
+#include "nvs.h"
+#include "nvs_flash.h"
+
+#include "config.h"
+#include "logger.h"
+
+#include "hw_profile.h"
+
+#define NVS_NAMESPACE "hw_profile"
+#define NVS_KEY_ID "id"
+
+// Axis raw calibration : min, center, max, deadzone, sign
+#define HW_ADA_X         50, 875, 1600, 50, -1
+#define HW_ADA_Y         50, 870, 1600, 50, -1
+#define HW_GAMEPAD_X     20, 412,  800, 10, -1
+#define HW_GAMEPAD_Y     20, 400,  800,  5,  1
+
+#define HW_PROFILE_AXIS_CHECK(...) \
+    _Static_assert(HW_PROFILE_AXIS_VALID(__VA_ARGS__), "axis calibration " #__VA_ARGS__)
+
+HW_PROFILE_AXIS_CHECK(HW_ADA_X);
+HW_PROFILE_AXIS_CHECK(HW_ADA_Y);
+HW_PROFILE_AXIS_CHECK(HW_GAMEPAD_X);
+HW_PROFILE_AXIS_CHECK(HW_GAMEPAD_Y);
+
+const HwProfile_t HW_PROFILE_LIST[HW_PROFILE_ID_NB] =
+{
+    [HW_PROFILE_ID_ADA] =
+    {
+        .sName = "ada",
+        .x = HW_PROFILE_AXIS(JOY_HW_X_CHAN, HW_ADA_X),
+        .y = HW_PROFILE_AXIS(JOY_HW_Y_CHAN, HW_ADA_Y),
+    },
+    [HW_PROFILE_ID_GAMEPAD] =
+    {
+        .sName = "gamepad",
+        .x = HW_PROFILE_AXIS(JOY_HW_X_CHAN, HW_GAMEPAD_X),
+        .y = HW_PROFILE_AXIS(JOY_HW_Y_CHAN, HW_GAMEPAD_Y),
+    },
+};
+
+_Static_assert(HW_PROFILE_DFLT < HW_PROFILE_ID_NB, "HW_PROFILE_DFLT");
+_Static_assert(HW_PROFILE_STRAP_LOW < HW_PROFILE_ID_NB, "HW_PROFILE_STRAP_LOW");
+
+static void __attribute__((format (printf, 2, 3))) _log(LogLevel_e lvl, const char * sFmt, ...);
+
+static void _log(LogLevel_e lvl, const char * sFmt, ...)
+{
+    va_list pArg;
+
+    va_start(pArg, sFmt);
+    LOGGER_log_va(MODULE_ID_HW_PROFILE, lvl, sFmt, pArg);
+    va_end(pArg);
+}
+
+static uint8_t axisCheck(const HwAxis_t * pAxis, char name)
+{
+    int32_t outPrev = HW_PROFILE_OUT_MIN;
+    int32_t bandMin = HW_PROFILE_RAW_MAX;
+    int32_t bandMax = 0;
+
+    if ((pAxis->lowSlope <= 0) || (pAxis->highSlope <= 0))
+    {
+        _log(LOG_LVL_ERROR, "%s() %c : slope %ld/%ld not positive", __func__, name, pAxis->lowSlope, pAxis->highSlope);
+        return 1U;
+    }
+
+    for (int32_t raw = 0; raw <= HW_PROFILE_RAW_MAX; raw += 1)
+    {
+        // Unsigned direction, sign is a plain mirror
+        int32_t out = HW_PROFILE_map(pAxis, raw);
+
+        if (pAxis->sign < 0)
+        {
+            out = 2 * HW_PROFILE_OUT_CENTER - out;
+        }
+
+        if ((out < HW_PROFILE_OUT_MIN) || (out > HW_PROFILE_OUT_MAX))
+        {
+            _log(LOG_LVL_ERROR, "%s() %c : raw %ld maps to %ld, out of range", __func__, name, raw, out);
+            return 1U;
+        }
+
+        if (out < outPrev)
+        {
+            _log(LOG_LVL_ERROR, "%s() %c : raw %ld maps to %ld < %ld, not monotonic", __func__, name, raw, out, outPrev);
+            return 1U;
+        }
+        outPrev = out;
+
+        if (out == HW_PROFILE_OUT_CENTER)
+        {
+            bandMin = (raw < bandMin) ? raw : bandMin;
+            bandMax = (raw > bandMax) ? raw : bandMax;
+        }
+    }
+
+    if ((HW_PROFILE_map(pAxis, pAxis->min) != ((pAxis->sign < 0) ? HW_PROFILE_OUT_MAX : HW_PROFILE_OUT_MIN))
+        || (HW_PROFILE_map(pAxis, pAxis->max) != ((pAxis->sign < 0) ? HW_PROFILE_OUT_MIN : HW_PROFILE_OUT_MAX)))
+    {
+        _log(LOG_LVL_ERROR, "%s() %c : end points not mapped to the output range ends", __func__, name);
+        return 1U;
+    }
+
+    // Band can extend past the edges by rounding, never be narrower
+    if ((bandMin > pAxis->lowEdge) || (bandMax < pAxis->highEdge))
+    {
+        _log(LOG_LVL_ERROR, "%s() %c : center band %ld..%ld narrower than %ld..%ld", __func__, name,
+            bandMin, bandMax, pAxis->lowEdge, pAxis->highEdge);
+        return 1U;
+    }
+
+    return 0U;
+}
+
+#if HW_PROFILE_SEL == HW_PROFILE_SEL_STRAP
+static HwProfileId_e strapRead(void)
+{
+    const gpio_config_t gpioConf =
+    {
+        .pin_bit_mask = BIT64(HW_PROFILE_STRAP_GPIO),
+        .mode = GPIO_MODE_INPUT,
+        .intr_type = GPIO_INTR_DISABLE,
+        .pull_up_en = true,
+        .pull_down_en = false,
+    };
+
+    if (gpio_config(&gpioConf) != ESP_OK)
+    {
+        _log(LOG_LVL_ERROR, "%s() gpio_config FAILED", __func__);
+        return HW_PROFILE_DFLT;
+    }
+
+    return gpio_get_level(HW_PROFILE_STRAP_GPIO) ? HW_PROFILE_DFLT : HW_PROFILE_STRAP_LOW;
+}
+#endif
+
+#if HW_PROFILE_SEL == HW_PROFILE_SEL_NVS
+static HwProfileId_e nvsRead(void)
+{
+    nvs_handle_t handle = 0U;
+    uint8_t id = HW_PROFILE_DFLT;
+    esp_err_t espRet = ESP_OK;
+
+    // Already initialized is fine, the BLE transport shares the partition
+    if (nvs_flash_init() != ESP_OK)
+    {
+        _log(LOG_LVL_WARN, "%s() nvs_flash_init FAILED", __func__);
+        return HW_PROFILE_DFLT;
+    }
+
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK)
+    {
+        // Namespace created by the first HW_PROFILE_save
+        return HW_PROFILE_DFLT;
+    }
+
+    espRet = nvs_get_u8(handle, NVS_KEY_ID, &id);
+    nvs_close(handle);
+
+    if ((espRet != ESP_OK) || (id >= HW_PROFILE_ID_NB))
+    {
+        _log(LOG_LVL_WARN, "%s() No valid stored profile (%d, %u)", __func__, espRet, id);
+        return HW_PROFILE_DFLT;
+    }
+
+    return (HwProfileId_e) id;
+}
+#endif
+
+HwProfileId_e HW_PROFILE_select(void)
+{
+    HwProfileId_e id = HW_PROFILE_DFLT;
+
+    LOGGER_setLevel(MODULE_ID_HW_PROFILE, LOG_LVL_DEBUG);
+
+#if HW_PROFILE_SEL == HW_PROFILE_SEL_STRAP
+    id = strapRead();
+#elif HW_PROFILE_SEL == HW_PROFILE_SEL_NVS
+    id = nvsRead();
+#endif
+
+    // Calibrations are checked at build time (HW_PROFILE_AXIS_CHECK), the mapping by the host tests
+    _log(LOG_LVL_INFO, "Hardware profile %s", HW_PROFILE_LIST[id].sName);
+
+    return id;
+}
+
+const HwProfile_t * HW_PROFILE_get(HwProfileId_e id)
+{
+    if (id >= HW_PROFILE_ID_NB)
+    {
+        _log(LOG_LVL_ERROR, "%s() id out of range (%u >= %u)", __func__, id, HW_PROFILE_ID_NB);
+        return NULL;
+    }
+
+    return &HW_PROFILE_LIST[id];
+}
+
+uint8_t HW_PROFILE_save(HwProfileId_e id)
+{
+    nvs_handle_t handle = 0U;
+    esp_err_t espRet = ESP_OK;
+
+    if (id >= HW_PROFILE_ID_NB)
+    {
+        _log(LOG_LVL_ERROR, "%s() id out of range (%u >= %u)", __func__, id, HW_PROFILE_ID_NB);
+        return 1U;
+    }
+
+    if (nvs_flash_init() != ESP_OK)
+    {
+        _log(LOG_LVL_ERROR, "%s() nvs_flash_init FAILED", __func__);
+        return 1U;
+    }
+
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK)
+    {
+        _log(LOG_LVL_ERROR, "%s() nvs_open FAILED", __func__);
+        return 1U;
+    }
+
+    espRet = nvs_set_u8(handle, NVS_KEY_ID, (uint8_t) id);
+    if (espRet == ESP_OK)
+    {
+        espRet = nvs_commit(handle);
+    }
+    nvs_close(handle);
+
+    if (espRet != ESP_OK)
+    {
+        _log(LOG_LVL_ERROR, "%s() nvs_set_u8 FAILED (%d)", __func__, espRet);
+        return 1U;
+    }
+
+    return 0U;
+}
+
+uint8_t HW_PROFILE_check(const HwProfile_t * pProfile)
+{
+    if (!pProfile)
+    {
+        _log(LOG_LVL_ERROR, "%s() pProfile NULL", __func__);
+        return 1U;
+    }
+
+    return axisCheck(&pProfile->x, 'x') || axisCheck(&pProfile->y, 'y');
+}
@@ -0,0 +1,120 @@
+
+#ifndef HW_PROFILE_H
+#define HW_PROFILE_H
+
+#include <inttypes.h>
+
+// Mapped output range, every profile and axis
+#define HW_PROFILE_OUT_MIN (-100)
+#define HW_PROFILE_OUT_MAX 100
+#define HW_PROFILE_OUT_CENTER (HW_PROFILE_OUT_MIN + (HW_PROFILE_OUT_MAX - HW_PROFILE_OUT_MIN) / 2)
+
+// ADC_WIDTH_BIT_13
+#define HW_PROFILE_RAW_MAX 8191
+
+// Slopes are output units per raw unit, Q16
+#define HW_PROFILE_SLOPE_SHIFT 16U
+
+typedef enum HwProfileId_e
+{
+    // Adafruit analog thumbstick
+    HW_PROFILE_ID_ADA = 0,
+    // Gamepad thumbstick module
+    HW_PROFILE_ID_GAMEPAD,
+    HW_PROFILE_ID_NB,
+} HwProfileId_e;
+
+/**
+ * @brief One joystick axis
+ *
+ * min, center, max, deadzone in raw ADC units, deadzone is the full width of
+ * the band around center mapped to the output center. Edges and slopes are
+ * derived at build time by HW_PROFILE_AXIS, the per sample mapping is then a
+ * compare, a multiply and a shift.
+ */
+typedef struct HwAxis_t
+{
+    // ADC1 channel
+    uint8_t chan;
+    int32_t min;
+    int32_t center;
+    int32_t max;
+    int32_t deadzone;
+    int8_t sign;
+    // Derived
+    int32_t lowEdge;
+    int32_t highEdge;
+    int32_t lowSlope;
+    int32_t highSlope;
+} HwAxis_t;
+
+typedef struct HwProfile_t
+{
+    const char * sName;
+    HwAxis_t x;
+    HwAxis_t y;
+} HwProfile_t;
+
+#define HW_PROFILE_AXIS_VALID(minV, centerV, maxV, dzV, signV) \
+    (((minV) >= 0) && ((maxV) <= HW_PROFILE_RAW_MAX) && ((dzV) >= 0) \
+    && ((minV) < (centerV) - (dzV) / 2) && ((centerV) + (dzV) / 2 < (maxV)) \
+    && (((signV) == 1) || ((signV) == -1)))
+
+#define HW_PROFILE_AXIS(chanV, ...) HW_PROFILE_AXIS_(chanV, __VA_ARGS__)
+#define HW_PROFILE_AXIS_(chanV, minV, centerV, maxV, dzV, signV) \
+    { \
+        .chan = (chanV), \
+        .min = (minV), \
+        .center = (centerV), \
+        .max = (maxV), \
+        .deadzone = (dzV), \
+        .sign = (signV), \
+        .lowEdge = (centerV) - (dzV) / 2, \
+        .highEdge = (centerV) + (dzV) / 2, \
+        .lowSlope = (int32_t) (((int64_t) (HW_PROFILE_OUT_CENTER - HW_PROFILE_OUT_MIN) << HW_PROFILE_SLOPE_SHIFT) \
+            / ((centerV) - (dzV) / 2 - (minV))), \
+        .highSlope = (int32_t) (((int64_t) (HW_PROFILE_OUT_MAX - HW_PROFILE_OUT_CENTER) << HW_PROFILE_SLOPE_SHIFT) \
+            / ((maxV) - ((centerV) + (dzV) / 2))), \
+    }
+
+extern const HwProfile_t HW_PROFILE_LIST[HW_PROFILE_ID_NB];
+
+// Strap pin or stored setting, per HW_PROFILE_SEL, HW_PROFILE_DFLT otherwise
+HwProfileId_e HW_PROFILE_select(void);
+
+const HwProfile_t * HW_PROFILE_get(HwProfileId_e id);
+
+// Stored setting, used at next boot with HW_PROFILE_SEL_NVS
+uint8_t HW_PROFILE_save(HwProfileId_e id);
+
+// Sweeps the whole raw range : bounds, end points, center band, monotonic. Host tests, not run at boot
+uint8_t HW_PROFILE_check(const HwProfile_t * pProfile);
+
+// Raw ADC value to output range, signed per profile
+static inline int32_t HW_PROFILE_map(const HwAxis_t * pAxis, int32_t raw)
+{
+    int32_t out = HW_PROFILE_OUT_CENTER;
+
+    if (raw <= pAxis->min)
+    {
+        out = HW_PROFILE_OUT_MIN;
+    }
+    else if (raw < pAxis->lowEdge)
+    {
+        out = HW_PROFILE_OUT_CENTER
+            - (((pAxis->lowEdge - raw) * pAxis->lowSlope + (1L << (HW_PROFILE_SLOPE_SHIFT - 1U))) >> HW_PROFILE_SLOPE_SHIFT);
+    }
+    else if (raw >= pAxis->max)
+    {
+        out = HW_PROFILE_OUT_MAX;
+    }
+    else if (raw > pAxis->highEdge)
+    {
+        out = HW_PROFILE_OUT_CENTER
+            + (((raw - pAxis->highEdge) * pAxis->highSlope + (1L << (HW_PROFILE_SLOPE_SHIFT - 1U))) >> HW_PROFILE_SLOPE_SHIFT);
+    }
+
+    return (pAxis->sign < 0) ? 2 * HW_PROFILE_OUT_CENTER - out : out;
+}
+
+#endif // HW_PROFILE_H
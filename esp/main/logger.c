@@ -10,12 +10,15 @@
 #include "freertos/task.h"
 #include "freertos/queue.h"
 
+#include "config.h"
 #include "utils.h"
 
 #include "logger.h"
 
 #define BUF_SIZE_MAX 200U
 
+#define MSG_NB_MAX 50U
+
 typedef struct Msg_t
 {
     struct timespec tp;
@@ -26,8 +29,6 @@ typedef struct Msg_t
 
 static const LogLevel_e LOG_LVL_DFLT = LOG_LVL_INFO;
 
-static const uint16_t MSG_NB_MAX = 50U;
-
 static const char * LEVEL_PFX_LIST[] =
 {
     "ERROR",
@@ -43,22 +44,90 @@ static const char * MODULE_NAME_LIST[] =
     "MAIN",
     "CTRL",
     "MOUSE",
+    "TELEM",
+    "TRANS",
+    "STRM",
+    "PRED",
+    "FIR",
+    "MON",
+    "SYSMON",
+    "BOOT",
+    "HWPROF",
     "UNKNOWN",
 };
 
+// Messages are formatted in place in a pool slot, the queues only carry slot indexes :
+// callers (esp_timer, TinyUSB and BLE callbacks included) need no Msg_t on their stack
+static Msg_t g_pMsgPool[MSG_NB_MAX];
+
+_Static_assert(MSG_NB_MAX <= UINT8_MAX, "slot index is uint8_t");
+
+// Filled slots, in log order
 static QueueHandle_t g_queue = NULL;
 
+// Slots free for the callers
+static QueueHandle_t g_freeQueue = NULL;
+
+static TaskHandle_t g_task = NULL;
+
+#if STATIC_ALLOC_EN
+static StaticQueue_t g_queueBuf;
+static uint8_t g_pQueueStorage[MSG_NB_MAX];
+static StaticQueue_t g_freeQueueBuf;
+static uint8_t g_pFreeQueueStorage[MSG_NB_MAX];
+static StaticTask_t g_taskBuf;
+static StackType_t g_pTaskStack[LOGGER_TASK_STACK_SIZE];
+#endif
+
+static uint32_t g_dropCnt = 0U;
+
+// Logged before LOGGER_init (FAST_BOOT_EN defers it)
+static uint32_t g_earlyCnt = 0U;
+
 static LogLevel_e g_pLvlModule[MODULE_ID_NB] = {
     LOG_LVL_DFLT,
     LOG_LVL_DFLT,
     LOG_LVL_DFLT,
     LOG_LVL_DFLT,
+    LOG_LVL_DFLT,
+    LOG_LVL_DFLT,
+    LOG_LVL_DFLT,
+    LOG_LVL_DFLT,
+    LOG_LVL_DFLT,
+    LOG_LVL_DFLT,
+    LOG_LVL_DFLT,
+    LOG_LVL_DFLT,
+    LOG_LVL_DFLT,
 };
 
+static void msgPrint(const Msg_t * pMsg)
+{
+    if (pMsg->moduleId >= MODULE_ID_NB)
+    {
+        printf("ERROR Logger %s() moduleId out of range (%u >= %u)\n", __func__, pMsg->moduleId, MODULE_ID_NB);
+        return;
+    }
+
+    if (pMsg->lvl >= LOG_LVL_NB)
+    {
+        printf("ERROR Logger %s() lvl out of range (%u >= %u)\n", __func__, pMsg->lvl, LOG_LVL_NB);
+        return;
+    }
+
+    if (pMsg->lvl > g_pLvlModule[pMsg->moduleId])
+    {
+        return;
+    }
+
+    printf("%04lld.%03lu [%s][%10s] %s\n",
+        pMsg->tp.tv_sec, pMsg->tp.tv_nsec / NS_PER_MS,
+        LEVEL_PFX_LIST[(uint8_t) pMsg->lvl], MODULE_NAME_LIST[(uint8_t) pMsg->moduleId], pMsg->sBuf);
+}
+
 static void _main(void * pArg)
 {
     BaseType_t baseRet = pdTRUE;
-    Msg_t * pMsg = NULL;
+    uint8_t slot = 0U;
 
     (void) pArg;
 
@@ -73,51 +142,53 @@ static void _main(void * pArg)
     printf("DEBUG Logger %s() main loop\n", __func__);
     while (true)
     {
-        baseRet = xQueueReceive(g_queue, (void *) &pMsg, portMAX_DELAY);
+        baseRet = xQueueReceive(g_queue, (void *) &slot, portMAX_DELAY);
         if (baseRet != pdPASS)
         {
             continue;
         }
 
-        if (!pMsg)
-        {
-            printf("ERROR Logger %s() pMsg NULL\n", __func__);
-            continue;
-        }
-
-        if (pMsg->moduleId >= MODULE_ID_NB)
+        if (slot >= MSG_NB_MAX)
         {
-            printf("ERROR Logger %s() moduleId out of range (%u >= %u)\n", __func__, pMsg->moduleId, MODULE_ID_NB);
+            printf("ERROR Logger %s() slot out of range (%u >= %u)\n", __func__, slot, MSG_NB_MAX);
             continue;
         }
 
-        if (pMsg->lvl >= LOG_LVL_NB)
-        {
-            printf("ERROR Logger %s() lvl out of range (%u >= %u)\n", __func__, pMsg->lvl, LOG_LVL_NB);
-            continue;
-        }
+        msgPrint(&g_pMsgPool[slot]);
 
-        if (pMsg->lvl > g_pLvlModule[pMsg->moduleId])
-        {
-            continue;
-        }
-
-        printf("%04lld.%03lu [%s][%10s] %s\n",
-            pMsg->tp.tv_sec, pMsg->tp.tv_nsec / NS_PER_MS,
-            LEVEL_PFX_LIST[(uint8_t) pMsg->lvl], MODULE_NAME_LIST[(uint8_t) pMsg->moduleId], pMsg->sBuf);
-
-        free(pMsg);
-        pMsg = NULL;
+        // Printed, the slot can be reused, never more slots than the free queue holds
+        (void) xQueueSend(g_freeQueue, (void *) &slot, 0U);
     }
 }
 
 uint8_t LOGGER_init(LogLevel_e lvl)
 {
-    TaskHandle_t task = NULL;
+    uint8_t slot = 0U;
 
     LOGGER_setLevel(MODULE_ID_NONE, lvl);
 
-    g_queue = xQueueCreate(MSG_NB_MAX, sizeof(Msg_t *));
+    // Every slot free before g_queue exists, callers test g_queue only
+#if STATIC_ALLOC_EN
+    g_freeQueue = xQueueCreateStatic(MSG_NB_MAX, sizeof(uint8_t), g_pFreeQueueStorage, &g_freeQueueBuf);
+#else
+    g_freeQueue = xQueueCreate(MSG_NB_MAX, sizeof(uint8_t));
+#endif
+    if (!g_freeQueue)
+    {
+        printf("ERROR Logger %s() xQueueCreate FAILED", __func__);
+        return 1U;
+    }
+
+    for (slot = 0U; slot < MSG_NB_MAX; slot += 1U)
+    {
+        (void) xQueueSend(g_freeQueue, (void *) &slot, 0U);
+    }
+
+#if STATIC_ALLOC_EN
+    g_queue = xQueueCreateStatic(MSG_NB_MAX, sizeof(uint8_t), g_pQueueStorage, &g_queueBuf);
+#else
+    g_queue = xQueueCreate(MSG_NB_MAX, sizeof(uint8_t));
+#endif
     if (!g_queue)
     {
         printf("ERROR Logger %s() xQueueCreate FAILED", __func__);
@@ -125,13 +196,22 @@ uint8_t LOGGER_init(LogLevel_e lvl)
     }
 
     printf("DEBUG Logger %s() Create main task\n", __func__);
-    xTaskCreate(_main, "loggerMain", 0x1000U, NULL, 1U, &task);
-    if (!task)
+#if STATIC_ALLOC_EN
+    g_task = xTaskCreateStatic(_main, "loggerMain", LOGGER_TASK_STACK_SIZE, NULL, 1U, g_pTaskStack, &g_taskBuf);
+#else
+    xTaskCreate(_main, "loggerMain", LOGGER_TASK_STACK_SIZE, NULL, 1U, &g_task);
+#endif
+    if (!g_task)
     {
         printf("ERROR Logger %s() xTaskCreate FAILED", __func__);
         return 1U;
     }
 
+    if (g_earlyCnt)
+    {
+        printf("DEBUG Logger %s() %lu messages before start, errors and warnings printed, others dropped\n", __func__, g_earlyCnt);
+    }
+
     return 0U;
 }
 
@@ -167,20 +247,38 @@ void LOGGER_log_va(ModuleId_e moduleId, LogLevel_e lvl, const char * sFmt, va_li
 {
     int iRet = 0;
     BaseType_t baseRet = pdFALSE;
+    uint8_t slot = 0U;
     Msg_t * pMsg = NULL;
 
-    pMsg = (Msg_t *) malloc(sizeof(Msg_t));
-    if (!pMsg)
+    // Not started yet : no queue to post to, keep the boot path short
+    if (!g_queue)
+    {
+        g_earlyCnt += 1U;
+        if ((lvl <= LOG_LVL_WARN) && (moduleId < MODULE_ID_NB))
+        {
+            printf("%s [%10s] ", LEVEL_PFX_LIST[(uint8_t) lvl], MODULE_NAME_LIST[(uint8_t) moduleId]);
+            vprintf(sFmt, pArg);
+            printf("\n");
+        }
+        return;
+    }
+
+    // Short wait for the logger task to print one, as the former by value send did
+    baseRet = xQueueReceive(g_freeQueue, (void *) &slot, 10U);
+    if (!baseRet)
     {
-        printf("ERROR Logger %s() malloc %u Bytes for Msg_t FAILED\n", __func__, sizeof(Msg_t));
+        g_dropCnt += 1U;
+        printf("ERROR Logger %s() no free slot\n", __func__);
         return;
     }
 
+    pMsg = &g_pMsgPool[slot];
     memset(pMsg, 0, sizeof(Msg_t));
 
     iRet = clock_gettime(CLOCK_MONOTONIC, &pMsg->tp);
     if (iRet != 0)
     {
+        (void) xQueueSend(g_freeQueue, (void *) &slot, 0U);
         printf("ERROR Logger %s() clock_gettime FAILED", __func__);
         return;
     }
@@ -191,15 +289,12 @@ void LOGGER_log_va(ModuleId_e moduleId, LogLevel_e lvl, const char * sFmt, va_li
     vsnprintf(pMsg->sBuf, BUF_SIZE_MAX, sFmt, pArg);
     pMsg->sBuf[BUF_SIZE_MAX - 1U] = '\0';
 
-    if (!g_queue)
-    {
-        printf("ERROR Logger %s() g_queue NULL", __func__);
-        return;
-    }
-
-    baseRet = xQueueSend(g_queue, (void *) &pMsg, 10U);
+    // As many entries as slots, cannot be full
+    baseRet = xQueueSend(g_queue, (void *) &slot, 0U);
     if (!baseRet)
     {
+        (void) xQueueSend(g_freeQueue, (void *) &slot, 0U);
+        g_dropCnt += 1U;
         printf("ERROR Logger %s() xQueueSend FAILED\n", __func__);
         return;
     }
@@ -230,3 +325,18 @@ void LOGGER_log(ModuleId_e moduleId, LogLevel_e lvl, const char * sFmt, ...)
     LOGGER_log_va(moduleId, lvl, sFmt, pArg);
     va_end(pArg);
 }
+
+uint16_t LOGGER_getQueueDepth(void)
+{
+    if (!g_queue)
+    {
+        return 0U;
+    }
+
+    return (uint16_t) uxQueueMessagesWaiting(g_queue);
+}
+
+uint32_t LOGGER_getDropCnt(void)
+{
+    return g_dropCnt;
+}
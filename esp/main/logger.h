@@ -20,9 +20,19 @@ typedef enum ModuleId_e
     MODULE_ID_MAIN,
     MODULE_ID_CTRL,
     MODULE_ID_MOUSE,
+    MODULE_ID_TELEM,
+    MODULE_ID_TRANSPORT,
+    MODULE_ID_STREAM,
+    MODULE_ID_PREDICT,
+    MODULE_ID_FIR,
+    MODULE_ID_MONITOR,
+    MODULE_ID_SYSMON,
+    MODULE_ID_BOOTPROF,
+    MODULE_ID_HW_PROFILE,
     MODULE_ID_NB,
 } ModuleId_e;
 
+// Logging before init is allowed : errors and warnings printed directly, others dropped
 uint8_t LOGGER_init(LogLevel_e lvl);
 
 void LOGGER_setLevel(ModuleId_e moduleId, LogLevel_e lvl);
@@ -31,4 +41,10 @@ void LOGGER_log_va(ModuleId_e moduleId, LogLevel_e lvl, const char * sFmt, va_li
 
 void LOGGER_log(ModuleId_e moduleId, LogLevel_e lvl, const char * sFmt, ...);
 
+// Messages waiting in queue
+uint16_t LOGGER_getQueueDepth(void);
+
+// Messages dropped since init (queue full)
+uint32_t LOGGER_getDropCnt(void);
+
 #endif // LOGGER_H
@@ -0,0 +1,324 @@
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_timer.h"
+
+#include "config.h"
+#include "logger.h"
+#include "utils.h"
+
+#include "monitor.h"
+
+static const uint32_t MAGIC = 561348;
+
+UTILS_INST_POOL(Monitor_t, 1);
+
+static const char * CAPTURE_NAME_LIST[] =
+{
+    "off",
+    "armed",
+    "triggered",
+    "done",
+    "unknown",
+};
+
+static void __attribute__((format (printf, 2, 3))) _log(LogLevel_e lvl, const char * sFmt, ...);
+
+static void _log(LogLevel_e lvl, const char * sFmt, ...)
+{
+    va_list pArg;
+
+    va_start(pArg, sFmt);
+    LOGGER_log_va(MODULE_ID_MONITOR, lvl, sFmt, pArg);
+    va_end(pArg);
+}
+
+static uint32_t sat32u(int64_t val)
+{
+    if (val < 0)
+    {
+        return 0U;
+    }
+
+    if (val > UINT32_MAX)
+    {
+        return UINT32_MAX;
+    }
+
+    return (uint32_t) val;
+}
+
+static void statsClear(Monitor_t * pInst)
+{
+    memset(&pInst->stats, 0, sizeof(pInst->stats));
+    pInst->stats.periodMinUs = UINT32_MAX;
+    pInst->devSum = 0;
+    pInst->devSqSum = 0U;
+    pInst->missedCnt = 0U;
+    // Next period is across the reset, skip it
+    pInst->startPrevUs = 0;
+}
+
+static void captureRecord(Monitor_t * pInst, const MonitorRecord_t * pRecord)
+{
+    if ((pInst->capState != MONITOR_CAPTURE_ARMED) && (pInst->capState != MONITOR_CAPTURE_TRIGGERED))
+    {
+        return;
+    }
+
+    pInst->pCap[pInst->capIdx] = *pRecord;
+    pInst->capIdx = (pInst->capIdx + 1U) % MONITOR_CAPTURE_LEN;
+
+    if ((pInst->capState == MONITOR_CAPTURE_ARMED) && (pRecord->periodUs > pInst->capThUs))
+    {
+        pInst->capState = MONITOR_CAPTURE_TRIGGERED;
+        pInst->capLeft = MONITOR_CAPTURE_LEN / 2U;
+        _log(LOG_LVL_WARN, "Capture triggered, period %lu us > %lu us", pRecord->periodUs, pInst->capThUs);
+        return;
+    }
+
+    if (pInst->capState == MONITOR_CAPTURE_TRIGGERED)
+    {
+        pInst->capLeft -= 1U;
+        if (pInst->capLeft == 0U)
+        {
+            pInst->capState = MONITOR_CAPTURE_DONE;
+            pInst->capDumpIdx = 0U;
+        }
+    }
+}
+
+// One captured record per cycle, keeps the logger queue from overflowing
+static void captureDump(Monitor_t * pInst)
+{
+    const MonitorRecord_t * pRecord = NULL;
+
+    if ((pInst->capState != MONITOR_CAPTURE_DONE) || (pInst->capDumpIdx >= MONITOR_CAPTURE_LEN))
+    {
+        return;
+    }
+
+    pRecord = &pInst->pCap[(pInst->capIdx + pInst->capDumpIdx) % MONITOR_CAPTURE_LEN];
+    _log(LOG_LVL_INFO, "cap %02u start %10lu period %6lu wake %6lu busy %6lu acq %u",
+        pInst->capDumpIdx, pRecord->startUs, pRecord->periodUs, pRecord->wakeUs, pRecord->busyUs, pRecord->acqNb);
+    pInst->capDumpIdx += 1U;
+}
+
+Monitor_t * MONITOR_init(uint32_t nominalUs, uint32_t overrunTolUs)
+{
+    Monitor_t * pInst = NULL;
+
+    LOGGER_setLevel(MODULE_ID_MONITOR, LOG_LVL_DEBUG);
+
+    _log(LOG_LVL_DEBUG, "%s()", __func__);
+
+    pInst = UTILS_INST_ALLOC(Monitor_t);
+    if (!pInst)
+    {
+        _log(LOG_LVL_ERROR, "%s() Alloc %u Bytes for Monitor_t FAILED", __func__, sizeof(Monitor_t));
+        return NULL;
+    }
+
+    memset(pInst, 0, sizeof(Monitor_t));
+
+    pInst->magic = MAGIC;
+    pInst->nominalUs = nominalUs;
+    pInst->overrunTolUs = overrunTolUs;
+    statsClear(pInst);
+
+    return pInst;
+}
+
+void MONITOR_timerFired(Monitor_t * pInst)
+{
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        return;
+    }
+
+    pInst->firedUs = (uint32_t) esp_timer_get_time();
+}
+
+void MONITOR_timerMissed(Monitor_t * pInst)
+{
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        return;
+    }
+
+    pInst->missedCnt += 1U;
+}
+
+uint8_t MONITOR_cycleStart(Monitor_t * pInst)
+{
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return 1U;
+    }
+
+    pInst->startUs = esp_timer_get_time();
+
+    return 0U;
+}
+
+uint8_t MONITOR_cycleEnd(Monitor_t * pInst, uint16_t acqNb)
+{
+    MonitorStats_t * pStats = NULL;
+    MonitorRecord_t record;
+    int64_t dev = 0;
+
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return 1U;
+    }
+
+    pStats = &pInst->stats;
+
+    record.startUs = (uint32_t) pInst->startUs;
+    record.periodUs = 0U;
+    record.wakeUs = (uint32_t) pInst->startUs - pInst->firedUs;
+    record.busyUs = sat32u(esp_timer_get_time() - pInst->startUs);
+    record.acqNb = acqNb;
+
+    pStats->missedCnt = pInst->missedCnt;
+    pStats->wakeMaxUs = (record.wakeUs > pStats->wakeMaxUs) ? record.wakeUs : pStats->wakeMaxUs;
+    pStats->busyMaxUs = (record.busyUs > pStats->busyMaxUs) ? record.busyUs : pStats->busyMaxUs;
+
+    if (pInst->startPrevUs)
+    {
+        record.periodUs = sat32u(pInst->startUs - pInst->startPrevUs);
+        dev = (int64_t) record.periodUs - pInst->nominalUs;
+
+        pStats->cycleNb += 1U;
+        pStats->periodMinUs = (record.periodUs < pStats->periodMinUs) ? record.periodUs : pStats->periodMinUs;
+        pStats->periodMaxUs = (record.periodUs > pStats->periodMaxUs) ? record.periodUs : pStats->periodMaxUs;
+        pStats->jitterMaxUs = (sat32u(llabs(dev)) > pStats->jitterMaxUs) ? sat32u(llabs(dev)) : pStats->jitterMaxUs;
+        pInst->devSum += dev;
+        pInst->devSqSum += (uint64_t) (dev * dev);
+
+        if (record.periodUs > pInst->nominalUs + pInst->overrunTolUs)
+        {
+            pStats->overrunCnt += 1U;
+        }
+
+        captureRecord(pInst, &record);
+    }
+    pInst->startPrevUs = pInst->startUs;
+
+    captureDump(pInst);
+
+    pInst->logCnt += 1U;
+    if ((MONITOR_LOG_CYCLE_NB > 0U) && (pInst->logCnt >= MONITOR_LOG_CYCLE_NB))
+    {
+        MonitorStats_t stats;
+
+        MONITOR_getStats(pInst, &stats);
+        _log(LOG_LVL_INFO, "%lu cycles, period %lu/%lu/%lu us, jitter std %lu max %lu us, overrun %lu, missed %lu, wake max %lu us, busy max %lu us",
+            stats.cycleNb, stats.periodMinUs, stats.periodMeanUs, stats.periodMaxUs, stats.jitterStdUs, stats.jitterMaxUs,
+            stats.overrunCnt, stats.missedCnt, stats.wakeMaxUs, stats.busyMaxUs);
+        pInst->logCnt = 0U;
+    }
+
+    return 0U;
+}
+
+uint8_t MONITOR_getStats(Monitor_t * pInst, MonitorStats_t * pStats)
+{
+    double mean = 0.0;
+    double var = 0.0;
+
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return 1U;
+    }
+
+    if (!pStats)
+    {
+        _log(LOG_LVL_ERROR, "%s() pStats NULL", __func__);
+        return 1U;
+    }
+
+    *pStats = pInst->stats;
+    pStats->missedCnt = pInst->missedCnt;
+
+    if (pStats->cycleNb == 0U)
+    {
+        pStats->periodMinUs = 0U;
+        return 0U;
+    }
+
+    mean = (double) pInst->devSum / pStats->cycleNb;
+    var = (double) pInst->devSqSum / pStats->cycleNb - mean * mean;
+
+    pStats->periodMeanUs = sat32u(pInst->nominalUs + llround(mean));
+    pStats->jitterStdUs = (var > 0.0) ? sat32u(llround(sqrt(var))) : 0U;
+
+    return 0U;
+}
+
+uint8_t MONITOR_resetStats(Monitor_t * pInst)
+{
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return 1U;
+    }
+
+    statsClear(pInst);
+
+    return 0U;
+}
+
+uint8_t MONITOR_armCapture(Monitor_t * pInst, uint32_t thresholdUs)
+{
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return 1U;
+    }
+
+    memset(pInst->pCap, 0, sizeof(pInst->pCap));
+    pInst->capIdx = 0U;
+    pInst->capLeft = 0U;
+    pInst->capDumpIdx = 0U;
+    pInst->capThUs = thresholdUs;
+    pInst->capState = thresholdUs ? MONITOR_CAPTURE_ARMED : MONITOR_CAPTURE_OFF;
+
+    _log(LOG_LVL_INFO, "Capture %s, threshold %lu us", CAPTURE_NAME_LIST[pInst->capState], thresholdUs);
+
+    return 0U;
+}
+
+uint8_t MONITOR_getCapture(Monitor_t * pInst, MonitorRecord_t * pRecords, uint16_t * pNb)
+{
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return 1U;
+    }
+
+    if (!pRecords || !pNb)
+    {
+        _log(LOG_LVL_ERROR, "%s() pRecords or pNb NULL", __func__);
+        return 1U;
+    }
+
+    if (pInst->capState != MONITOR_CAPTURE_DONE)
+    {
+        return 1U;
+    }
+
+    for (uint16_t idx = 0U; idx < MONITOR_CAPTURE_LEN; idx += 1U)
+    {
+        pRecords[idx] = pInst->pCap[(pInst->capIdx + idx) % MONITOR_CAPTURE_LEN];
+    }
+    *pNb = MONITOR_CAPTURE_LEN;
+
+    return 0U;
+}
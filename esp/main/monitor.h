@@ -0,0 +1,99 @@
+
+#ifndef MONITOR_H
+#define MONITOR_H
+
+#include <inttypes.h>
+
+// Cycles kept around a capture trigger, half of them after it
+#define MONITOR_CAPTURE_LEN 32U
+
+typedef enum MonitorCapture_e
+{
+    MONITOR_CAPTURE_OFF = 0,
+    // Recording, waiting for a cycle over threshold
+    MONITOR_CAPTURE_ARMED,
+    // Triggered, recording the cycles after the trigger
+    MONITOR_CAPTURE_TRIGGERED,
+    // Frozen, readable with MONITOR_getCapture
+    MONITOR_CAPTURE_DONE,
+    MONITOR_CAPTURE_NB,
+} MonitorCapture_e;
+
+// One report cycle
+typedef struct MonitorRecord_t
+{
+    // Cycle start, esp_timer low 32 bits
+    uint32_t startUs;
+    // Since previous cycle start
+    uint32_t periodUs;
+    // Timer firing to cycle start
+    uint32_t wakeUs;
+    // Cycle start to cycle end
+    uint32_t busyUs;
+    uint16_t acqNb;
+} MonitorRecord_t;
+
+typedef struct MonitorStats_t
+{
+    uint32_t cycleNb;
+    // Period over nominal + tolerance
+    uint32_t overrunCnt;
+    // Timer fired while the previous firing was still pending
+    uint32_t missedCnt;
+    uint32_t periodMinUs;
+    uint32_t periodMaxUs;
+    uint32_t periodMeanUs;
+    // Period deviation from nominal, standard deviation and max absolute
+    uint32_t jitterStdUs;
+    uint32_t jitterMaxUs;
+    uint32_t wakeMaxUs;
+    uint32_t busyMaxUs;
+} MonitorStats_t;
+
+typedef struct Monitor_t
+{
+    uint32_t magic;
+    uint32_t nominalUs;
+    uint32_t overrunTolUs;
+    int64_t startUs;
+    int64_t startPrevUs;
+    // Written by the timer callback, low 32 bits so reads are not torn
+    volatile uint32_t firedUs;
+    volatile uint32_t missedCnt;
+    MonitorStats_t stats;
+    // Period deviation sums, for mean and standard deviation
+    int64_t devSum;
+    uint64_t devSqSum;
+    uint16_t logCnt;
+    // Capture ring
+    MonitorCapture_e capState;
+    uint32_t capThUs;
+    uint16_t capIdx;
+    uint16_t capLeft;
+    uint16_t capDumpIdx;
+    MonitorRecord_t pCap[MONITOR_CAPTURE_LEN];
+} Monitor_t;
+
+Monitor_t * MONITOR_init(uint32_t nominalUs, uint32_t overrunTolUs);
+
+// Timer callback side, no logging
+void MONITOR_timerFired(Monitor_t * pInst);
+
+void MONITOR_timerMissed(Monitor_t * pInst);
+
+// Task side, around the report cycle work
+uint8_t MONITOR_cycleStart(Monitor_t * pInst);
+
+uint8_t MONITOR_cycleEnd(Monitor_t * pInst, uint16_t acqNb);
+
+uint8_t MONITOR_getStats(Monitor_t * pInst, MonitorStats_t * pStats);
+
+uint8_t MONITOR_resetStats(Monitor_t * pInst);
+
+// Capture the cycles around the first period over thresholdUs (0 : off)
+uint8_t MONITOR_armCapture(Monitor_t * pInst, uint32_t thresholdUs);
+
+// Oldest first, fails until the capture is done
+uint8_t MONITOR_getCapture(Monitor_t * pInst, MonitorRecord_t * pRecords, uint16_t * pNb);
+
+#endif // MONITOR_H
@@ -1,88 +1,285 @@
 
 #include <inttypes.h>
 #include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
 
-#include "tinyusb.h"
-#include "class/hid/hid_device.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "class/hid/hid.h"
 
+#include "config.h"
 #include "logger.h"
+#include "utils.h"
 
 #include "mouse.h"
 
-/************* TinyUSB descriptors ****************/
+/************* HID report descriptors ****************/
 
-#define TUSB_DESC_TOTAL_LEN      (TUD_CONFIG_DESC_LEN + CFG_TUD_HID * TUD_HID_DESC_LEN)
+// Report IDs are the same in every personality
+#define REPORT_ID_MOUSE    HID_ITF_PROTOCOL_MOUSE
+#define REPORT_ID_ABS      3U
+#define REPORT_ID_GAMEPAD  4U
 
 /**
- * @brief HID report descriptor
+ * @brief Resolution multiplier feature field
  *
- * In this example we implement Keyboard + Mouse HID device,
- * so we must define both report descriptors
+ * 2 bits feature, logical 0..1 mapped to physical 1..MOUSE_SCROLL_RES_MULT.
+ * Physical range is reset afterwards so it does not apply to the next input.
  */
-const uint8_t hid_report_descriptor[] = {
-    TUD_HID_REPORT_DESC_KEYBOARD(HID_REPORT_ID(HID_ITF_PROTOCOL_KEYBOARD)),
-    TUD_HID_REPORT_DESC_MOUSE(HID_REPORT_ID(HID_ITF_PROTOCOL_MOUSE))
-};
+#define HID_REPORT_DESC_RES_MULT \
+    HID_USAGE          ( HID_USAGE_DESKTOP_RESOLUTION_MULTIPLIER  ) ,\
+    HID_LOGICAL_MIN    ( 0                                        ) ,\
+    HID_LOGICAL_MAX    ( 1                                        ) ,\
+    HID_PHYSICAL_MIN   ( 1                                        ) ,\
+    HID_PHYSICAL_MAX   ( MOUSE_SCROLL_RES_MULT                    ) ,\
+    HID_REPORT_COUNT   ( 1                                        ) ,\
+    HID_REPORT_SIZE    ( 2                                        ) ,\
+    HID_FEATURE        ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE   ) ,\
+    HID_PHYSICAL_MIN   ( 0                                        ) ,\
+    HID_PHYSICAL_MAX   ( 0                                        )
 
 /**
- * @brief String descriptor
+ * @brief Mouse report descriptor with high resolution wheel and pan
+ *
+ * Same input report layout as TUD_HID_REPORT_DESC_MOUSE (hid_mouse_report_t),
+ * plus a 1 Byte feature report holding the wheel (bits 0..1) and pan (bits 2..3)
+ * resolution multipliers, each in its own logical collection with the axis it applies to.
  */
-const char* hid_string_descriptor[5] = {
-    // array of pointer to string descriptors
-    (char[]){0x09, 0x04},  // 0: is supported language is English (0x0409)
-    "TinyUSB",             // 1: Manufacturer
-    "TinyUSB Device",      // 2: Product
-    "123456",              // 3: Serials, should use chip ID
-    "Example HID interface",  // 4: HID
-};
+#define HID_REPORT_DESC_MOUSE_HIRES(...) \
+    HID_USAGE_PAGE     ( HID_USAGE_PAGE_DESKTOP                   ) ,\
+    HID_USAGE          ( HID_USAGE_DESKTOP_MOUSE                  ) ,\
+    HID_COLLECTION     ( HID_COLLECTION_APPLICATION               ) ,\
+        __VA_ARGS__ \
+        HID_USAGE      ( HID_USAGE_DESKTOP_POINTER                ) ,\
+        HID_COLLECTION ( HID_COLLECTION_PHYSICAL                  ) ,\
+            HID_USAGE_PAGE     ( HID_USAGE_PAGE_BUTTON                    ) ,\
+            HID_USAGE_MIN      ( 1                                        ) ,\
+            HID_USAGE_MAX      ( 5                                        ) ,\
+            HID_LOGICAL_MIN    ( 0                                        ) ,\
+            HID_LOGICAL_MAX    ( 1                                        ) ,\
+            HID_REPORT_COUNT   ( 5                                        ) ,\
+            HID_REPORT_SIZE    ( 1                                        ) ,\
+            HID_INPUT          ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE   ) ,\
+            HID_REPORT_COUNT   ( 1                                        ) ,\
+            HID_REPORT_SIZE    ( 3                                        ) ,\
+            HID_INPUT          ( HID_CONSTANT                             ) ,\
+            HID_USAGE_PAGE     ( HID_USAGE_PAGE_DESKTOP                   ) ,\
+            HID_USAGE          ( HID_USAGE_DESKTOP_X                      ) ,\
+            HID_USAGE          ( HID_USAGE_DESKTOP_Y                      ) ,\
+            HID_LOGICAL_MIN    ( 0x81                                     ) ,\
+            HID_LOGICAL_MAX    ( 0x7f                                     ) ,\
+            HID_REPORT_COUNT   ( 2                                        ) ,\
+            HID_REPORT_SIZE    ( 8                                        ) ,\
+            HID_INPUT          ( HID_DATA | HID_VARIABLE | HID_RELATIVE   ) ,\
+            HID_COLLECTION     ( HID_COLLECTION_LOGICAL                   ) ,\
+                HID_REPORT_DESC_RES_MULT ,\
+                HID_USAGE          ( HID_USAGE_DESKTOP_WHEEL                  ) ,\
+                HID_LOGICAL_MIN    ( 0x81                                     ) ,\
+                HID_LOGICAL_MAX    ( 0x7f                                     ) ,\
+                HID_REPORT_COUNT   ( 1                                        ) ,\
+                HID_REPORT_SIZE    ( 8                                        ) ,\
+                HID_INPUT          ( HID_DATA | HID_VARIABLE | HID_RELATIVE   ) ,\
+            HID_COLLECTION_END ,\
+            HID_COLLECTION     ( HID_COLLECTION_LOGICAL                   ) ,\
+                HID_REPORT_DESC_RES_MULT ,\
+                HID_USAGE_PAGE     ( HID_USAGE_PAGE_CONSUMER                  ) ,\
+                HID_USAGE_N        ( HID_USAGE_CONSUMER_AC_PAN, 2             ) ,\
+                HID_LOGICAL_MIN    ( 0x81                                     ) ,\
+                HID_LOGICAL_MAX    ( 0x7f                                     ) ,\
+                HID_REPORT_COUNT   ( 1                                        ) ,\
+                HID_REPORT_SIZE    ( 8                                        ) ,\
+                HID_INPUT          ( HID_DATA | HID_VARIABLE | HID_RELATIVE   ) ,\
+            HID_COLLECTION_END ,\
+            HID_USAGE_PAGE     ( HID_USAGE_PAGE_DESKTOP                   ) ,\
+            HID_REPORT_COUNT   ( 1                                        ) ,\
+            HID_REPORT_SIZE    ( 4                                        ) ,\
+            HID_FEATURE        ( HID_CONSTANT                             ) ,\
+        HID_COLLECTION_END ,\
+    HID_COLLECTION_END
+
+/**
+ * @brief Absolute pointer report descriptor
+ *
+ * 5 buttons, X and Y absolute in [MOUSE_ABS_MIN, MOUSE_ABS_MAX], see AbsReport_t
+ */
+#define HID_REPORT_DESC_ABS(...) \
+    HID_USAGE_PAGE     ( HID_USAGE_PAGE_DESKTOP                   ) ,\
+    HID_USAGE          ( HID_USAGE_DESKTOP_MOUSE                  ) ,\
+    HID_COLLECTION     ( HID_COLLECTION_APPLICATION               ) ,\
+        __VA_ARGS__ \
+        HID_USAGE      ( HID_USAGE_DESKTOP_POINTER                ) ,\
+        HID_COLLECTION ( HID_COLLECTION_PHYSICAL                  ) ,\
+            HID_USAGE_PAGE     ( HID_USAGE_PAGE_BUTTON                    ) ,\
+            HID_USAGE_MIN      ( 1                                        ) ,\
+            HID_USAGE_MAX      ( 5                                        ) ,\
+            HID_LOGICAL_MIN    ( 0                                        ) ,\
+            HID_LOGICAL_MAX    ( 1                                        ) ,\
+            HID_REPORT_COUNT   ( 5                                        ) ,\
+            HID_REPORT_SIZE    ( 1                                        ) ,\
+            HID_INPUT          ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE   ) ,\
+            HID_REPORT_COUNT   ( 1                                        ) ,\
+            HID_REPORT_SIZE    ( 3                                        ) ,\
+            HID_INPUT          ( HID_CONSTANT                             ) ,\
+            HID_USAGE_PAGE     ( HID_USAGE_PAGE_DESKTOP                   ) ,\
+            HID_USAGE          ( HID_USAGE_DESKTOP_X                      ) ,\
+            HID_USAGE          ( HID_USAGE_DESKTOP_Y                      ) ,\
+            HID_LOGICAL_MIN    ( MOUSE_ABS_MIN                            ) ,\
+            HID_LOGICAL_MAX_N  ( MOUSE_ABS_MAX, 2                         ) ,\
+            HID_REPORT_COUNT   ( 2                                        ) ,\
+            HID_REPORT_SIZE    ( 16                                       ) ,\
+            HID_INPUT          ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE   ) ,\
+        HID_COLLECTION_END ,\
+    HID_COLLECTION_END
+
+/**
+ * @brief Gamepad report descriptor
+ *
+ * 8 buttons, X and Y 16 bits signed, see GamepadReport_t (5 Bytes)
+ */
+#define HID_REPORT_DESC_GAMEPAD_XY(...) \
+    HID_USAGE_PAGE     ( HID_USAGE_PAGE_DESKTOP                   ) ,\
+    HID_USAGE          ( HID_USAGE_DESKTOP_GAMEPAD                ) ,\
+    HID_COLLECTION     ( HID_COLLECTION_APPLICATION               ) ,\
+        __VA_ARGS__ \
+        HID_USAGE_PAGE     ( HID_USAGE_PAGE_BUTTON                    ) ,\
+        HID_USAGE_MIN      ( 1                                        ) ,\
+        HID_USAGE_MAX      ( 8                                        ) ,\
+        HID_LOGICAL_MIN    ( 0                                        ) ,\
+        HID_LOGICAL_MAX    ( 1                                        ) ,\
+        HID_REPORT_COUNT   ( 8                                        ) ,\
+        HID_REPORT_SIZE    ( 1                                        ) ,\
+        HID_INPUT          ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE   ) ,\
+        HID_USAGE_PAGE     ( HID_USAGE_PAGE_DESKTOP                   ) ,\
+        HID_USAGE          ( HID_USAGE_DESKTOP_X                      ) ,\
+        HID_USAGE          ( HID_USAGE_DESKTOP_Y                      ) ,\
+        HID_LOGICAL_MIN_N  ( -MOUSE_GAMEPAD_AXIS_MAX, 2               ) ,\
+        HID_LOGICAL_MAX_N  ( MOUSE_GAMEPAD_AXIS_MAX, 2                ) ,\
+        HID_REPORT_COUNT   ( 2                                        ) ,\
+        HID_REPORT_SIZE    ( 16                                       ) ,\
+        HID_INPUT          ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE   ) ,\
+    HID_COLLECTION_END
+
+typedef struct __attribute__((packed)) GamepadReport_t
+{
+    uint8_t buttons;
+    int16_t x;
+    int16_t y;
+} GamepadReport_t;
+
+typedef struct __attribute__((packed)) AbsReport_t
+{
+    uint8_t buttons;
+    uint16_t x;
+    uint16_t y;
+} AbsReport_t;
+
+// Resolution multiplier feature report bits
+#define RES_MULT_WHEEL_MASK 0x03U
+#define RES_MULT_PAN_SHIFT  2U
+#define RES_MULT_PAN_MASK   (0x03U << RES_MULT_PAN_SHIFT)
+#define RES_MULT_FEATURE_LEN 1U
 
 /**
- * @brief Configuration descriptor
+ * @brief HID report descriptors, one per personality
  *
- * This is a simple configuration descriptor that defines 1 configuration and 1 HID interface
+ * Mouse : relative mouse + absolute pointer
+ * Gamepad : gamepad only
+ * Combined : all of them
  */
-static const uint8_t hid_configuration_descriptor[] = {
-    // Configuration number, interface count, string index, total length, attribute, power in mA
-    TUD_CONFIG_DESCRIPTOR(1, 1, 0, TUSB_DESC_TOTAL_LEN, TUSB_DESC_CONFIG_ATT_REMOTE_WAKEUP, 100),
+const uint8_t hid_report_descriptor_mouse[] = {
+    HID_REPORT_DESC_MOUSE_HIRES(HID_REPORT_ID(REPORT_ID_MOUSE)),
+    HID_REPORT_DESC_ABS(HID_REPORT_ID(REPORT_ID_ABS))
+};
 
-    // Interface number, string index, boot protocol, report descriptor len, EP In address, size & polling interval
-    TUD_HID_DESCRIPTOR(0, 4, false, sizeof(hid_report_descriptor), 0x81, 16, 10),
+const uint8_t hid_report_descriptor_gamepad[] = {
+    HID_REPORT_DESC_GAMEPAD_XY(HID_REPORT_ID(REPORT_ID_GAMEPAD))
 };
 
-/********* TinyUSB HID callbacks ***************/
+const uint8_t hid_report_descriptor_combined[] = {
+    HID_REPORT_DESC_MOUSE_HIRES(HID_REPORT_ID(REPORT_ID_MOUSE)),
+    HID_REPORT_DESC_ABS(HID_REPORT_ID(REPORT_ID_ABS)),
+    HID_REPORT_DESC_GAMEPAD_XY(HID_REPORT_ID(REPORT_ID_GAMEPAD))
+};
 
-// Invoked when received GET HID REPORT DESCRIPTOR request
-// Application return pointer to descriptor, whose contents must exist long enough for transfer to complete
-uint8_t const *tud_hid_descriptor_report_cb(uint8_t instance)
+// Resolution multiplier feature report, as last set by the host (0 : 1 detent per unit)
+static uint8_t g_resMult = 0U;
+
+// Instance flushed on transport send completion and reset by the host, single instance
+static Mouse_t * g_pInstDone = NULL;
+
+typedef struct __attribute__((packed)) RelReport_t
+{
+    uint8_t buttons;
+    int8_t x;
+    int8_t y;
+    int8_t wheel;
+    int8_t pan;
+} RelReport_t;
+
+typedef struct Personality_t
 {
-    // We use only one interface and one HID report descriptor, so we can ignore parameter 'instance'
-    return hid_report_descriptor;
+    const char * sName;
+    const uint8_t * pReportDesc;
+    uint16_t reportDescLen;
+    uint8_t bMouse;
+    uint8_t bGamepad;
+} Personality_t;
+
+static const Personality_t PERSONALITY_LIST[MOUSE_PERSO_NB] =
+{
+    { "mouse",    hid_report_descriptor_mouse,    sizeof(hid_report_descriptor_mouse),    1U, 0U },
+    { "gamepad",  hid_report_descriptor_gamepad,  sizeof(hid_report_descriptor_gamepad),  0U, 1U },
+    { "combined", hid_report_descriptor_combined, sizeof(hid_report_descriptor_combined), 1U, 1U },
+};
+
+/********* Feature reports, from transport ***************/
+
+static uint16_t getFeature(uint8_t reportId, uint8_t * pBuf, uint16_t len)
+{
+    if ((reportId != REPORT_ID_MOUSE) || (len < RES_MULT_FEATURE_LEN))
+    {
+        return 0U;
+    }
+
+    pBuf[0] = g_resMult;
+
+    return RES_MULT_FEATURE_LEN;
 }
 
-// Invoked when received GET_REPORT control request
-// Application must fill buffer report's content and return its length.
-// Return zero will cause the stack to STALL request
-uint16_t tud_hid_get_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type, uint8_t* buffer, uint16_t reqlen)
+static void setFeature(uint8_t reportId, const uint8_t * pBuf, uint16_t len)
 {
-    (void) instance;
-    (void) report_id;
-    (void) report_type;
-    (void) buffer;
-    (void) reqlen;
+    if ((reportId != REPORT_ID_MOUSE) || (len < RES_MULT_FEATURE_LEN))
+    {
+        return;
+    }
 
-    return 0;
+    g_resMult = pBuf[0] & (RES_MULT_WHEEL_MASK | RES_MULT_PAN_MASK);
 }
 
-// Invoked when received SET_REPORT control request or
-// received data on OUT endpoint ( Report ID = 0, Type = 0 )
-void tud_hid_set_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type, uint8_t const* buffer, uint16_t bufsize)
+// Next host starts from the descriptor default, until it sets the feature again
+static void hostReset(void)
 {
+    g_resMult = 0U;
+
+    // Transport context, scroll backlog rounded by the next holder of the mutex
+    if (g_pInstDone)
+    {
+        g_pInstDone->bHostReset = 1U;
+    }
 }
 
-/************* TinyUSB ****************/
+/************* Mouse ****************/
 
 static const uint32_t MAGIC = 561348;
 
+UTILS_INST_POOL(Mouse_t, 1);
+
+#if STATIC_ALLOC_EN
+static StaticSemaphore_t g_mutexBuf;
+#endif
+
 static void __attribute__((format (printf, 2, 3))) _log(LogLevel_e lvl, const char * sFmt, ...);
 
 static void _log(LogLevel_e lvl, const char * sFmt, ...)
@@ -94,48 +291,366 @@ static void _log(LogLevel_e lvl, const char * sFmt, ...)
     va_end(pArg);
 }
 
-Mouse_t * MOUSE_init(uint8_t bEn)
+static int8_t clamp8(int32_t val)
 {
-    int ret = 0;
-    Mouse_t * pInst = NULL;
+    if (val > INT8_MAX)
+    {
+        return INT8_MAX;
+    }
+
+    if (val < -INT8_MAX)
+    {
+        return -INT8_MAX;
+    }
+
+    return (int8_t) val;
+}
+
+// Accumulated scroll (1 / MOUSE_SCROLL_RES_MULT detent) to report units, *pUsed : accumulator units consumed
+static int8_t scrollUnits(int32_t acc, uint8_t bHiRes, int32_t * pUsed)
+{
+    int8_t val = 0;
+
+    if (bHiRes)
+    {
+        val = clamp8(acc);
+        *pUsed = val;
+    }
+    else
+    {
+        val = clamp8(acc / (int32_t) MOUSE_SCROLL_RES_MULT);
+        *pUsed = val * (int32_t) MOUSE_SCROLL_RES_MULT;
+    }
+
+    return val;
+}
+
+// Hi-res units left from the previous host would never go out in low resolution : whole detents only
+static void scrollReset(Mouse_t * pInst)
+{
+    if (!pInst->bHostReset)
+    {
+        return;
+    }
+
+    pInst->bHostReset = 0U;
+    pInst->scrollAcc.x -= pInst->scrollAcc.x % (int32_t) MOUSE_SCROLL_RES_MULT;
+    pInst->scrollAcc.y -= pInst->scrollAcc.y % (int32_t) MOUSE_SCROLL_RES_MULT;
+}
+
+// Adds to the backlog up to MOUSE_MOVE_ACC_MAX, returns the part taken
+static int32_t accAdd(int32_t * pAcc, int32_t val, uint32_t * pClipNb)
+{
+    int64_t sum = (int64_t) *pAcc + val;
 
-    const tinyusb_config_t usbConf =
+    if (sum > MOUSE_MOVE_ACC_MAX)
     {
-        .device_descriptor = NULL,
-        .string_descriptor = hid_string_descriptor,
-        .string_descriptor_count = sizeof(hid_string_descriptor) / sizeof(hid_string_descriptor[0]),
-        .external_phy = false,
-        .configuration_descriptor = hid_configuration_descriptor,
-    };
+        sum = MOUSE_MOVE_ACC_MAX;
+        *pClipNb += 1U;
+    }
+    else if (sum < -MOUSE_MOVE_ACC_MAX)
+    {
+        sum = -MOUSE_MOVE_ACC_MAX;
+        *pClipNb += 1U;
+    }
+
+    val = (int32_t) (sum - *pAcc);
+    *pAcc = (int32_t) sum;
+
+    return val;
+}
+
+// Statistics totals, modulo 2^32 so the difference of two totals stays exact
+static int32_t wrapAdd(int32_t total, int32_t val)
+{
+    return (int32_t) ((uint32_t) total + (uint32_t) val);
+}
+
+static int32_t absClamp(int64_t val)
+{
+    if (val < MOUSE_ABS_MIN)
+    {
+        return MOUSE_ABS_MIN;
+    }
+
+    if (val > MOUSE_ABS_MAX)
+    {
+        return MOUSE_ABS_MAX;
+    }
+
+    return (int32_t) val;
+}
+
+static uint8_t sendAbs(Mouse_t * pInst)
+{
+    AbsReport_t report;
+
+    report.buttons = 0x00;
+    report.x = (uint16_t) pInst->absPos.x;
+    report.y = (uint16_t) pInst->absPos.y;
+
+    if (TRANSPORT_send(pInst->pTransport, REPORT_ID_ABS, &report, sizeof(report)))
+    {
+        return 0U;
+    }
+
+    pInst->bAbsDirty = 0U;
+
+    return 1U;
+}
+
+static uint8_t sendGamepad(Mouse_t * pInst)
+{
+    GamepadReport_t report;
+
+    report.buttons = pInst->gamepadBtn;
+    report.x = (int16_t) pInst->gamepad.x;
+    report.y = (int16_t) pInst->gamepad.y;
+
+    if (TRANSPORT_send(pInst->pTransport, REPORT_ID_GAMEPAD, &report, sizeof(report)))
+    {
+        return 0U;
+    }
+
+    pInst->bGamepadDirty = 0U;
+
+    return 1U;
+}
+
+// Relative report from accumulators, totals beyond int8 are left for next reports
+static uint8_t sendRel(Mouse_t * pInst, int64_t nowUs)
+{
+    RelReport_t report;
+    int32_t wheelUsed = 0;
+    int32_t panUsed = 0;
+
+    report.buttons = 0x00;
+    report.x = clamp8(pInst->moveAcc.x);
+    report.y = clamp8(pInst->moveAcc.y);
+    report.wheel = scrollUnits(pInst->scrollAcc.y, (g_resMult & RES_MULT_WHEEL_MASK) != 0U, &wheelUsed);
+    report.pan = scrollUnits(pInst->scrollAcc.x, (g_resMult & RES_MULT_PAN_MASK) != 0U, &panUsed);
+
+    if ((report.x == 0) && (report.y == 0) && (report.wheel == 0) && (report.pan == 0))
+    {
+        return 0U;
+    }
+
+    if (TRANSPORT_send(pInst->pTransport, REPORT_ID_MOUSE, &report, sizeof(report)))
+    {
+        return 0U;
+    }
+
+    pInst->moveAcc.x -= report.x;
+    pInst->moveAcc.y -= report.y;
+
+    if ((pInst->moveAcc.x != 0) || (pInst->moveAcc.y != 0))
+    {
+        // Total beyond int8, rest goes in the next reports
+        pInst->stats.splitNb += 1U;
+    }
+    pInst->scrollAcc.y -= wheelUsed;
+    pInst->scrollAcc.x -= panUsed;
+
+    pInst->stats.moveOut.x = wrapAdd(pInst->stats.moveOut.x, report.x);
+    pInst->stats.moveOut.y = wrapAdd(pInst->stats.moveOut.y, report.y);
+
+    if (nowUs - pInst->pendingSinceUs > pInst->stats.latencyMaxUs)
+    {
+        pInst->stats.latencyMaxUs = (uint32_t) (nowUs - pInst->pendingSinceUs);
+    }
+
+    // Remainder (split report) counts from now
+    pInst->pendingSinceUs = nowUs;
+
+    return 1U;
+}
+
+static uint8_t isPending(const Mouse_t * pInst, MouseReport_e report)
+{
+    int32_t used = 0;
+
+    switch (report)
+    {
+        case MOUSE_REPORT_ABS:
+            return pInst->bAbsDirty;
+        case MOUSE_REPORT_GAMEPAD:
+            return pInst->bGamepadDirty;
+        default:
+            break;
+    }
+
+    // Same rounding as sendRel, scroll below one detent in low resolution waits for more
+    return (pInst->moveAcc.x != 0) || (pInst->moveAcc.y != 0) ||
+        scrollUnits(pInst->scrollAcc.y, (g_resMult & RES_MULT_WHEEL_MASK) != 0U, &used) ||
+        scrollUnits(pInst->scrollAcc.x, (g_resMult & RES_MULT_PAN_MASK) != 0U, &used);
+}
+
+/**
+ * @brief Send the next pending report, if the transport takes it
+ *
+ * One report per call, at most one per transport interval : the rest goes on
+ * the next call (mouse task cycle or send completion). Pending report kinds
+ * take turns, a gamepad moving every cycle does not hold back motion.
+ */
+static void flush(Mouse_t * pInst)
+{
+    int64_t nowUs = esp_timer_get_time();
+    uint32_t intervalUs = TRANSPORT_getIntervalUs(pInst->pTransport);
+    MouseReport_e report = pInst->lastReport;
+    uint8_t bRet = 0U;
+
+    scrollReset(pInst);
+
+    if ((intervalUs != 0U) && ((nowUs - pInst->lastSendUs) < (int64_t) intervalUs))
+    {
+        // Merge until next connection event
+        return;
+    }
+
+    if (!TRANSPORT_isReady(pInst->pTransport))
+    {
+        return;
+    }
+
+    for (uint8_t i = 0U; i < MOUSE_REPORT_NB; i++)
+    {
+        report = (MouseReport_e) ((pInst->lastReport + 1U + i) % MOUSE_REPORT_NB);
+        if (isPending(pInst, report))
+        {
+            break;
+        }
+    }
+
+    switch (report)
+    {
+        case MOUSE_REPORT_ABS:
+            bRet = pInst->bAbsDirty ? sendAbs(pInst) : 0U;
+            break;
+        case MOUSE_REPORT_GAMEPAD:
+            bRet = pInst->bGamepadDirty ? sendGamepad(pInst) : 0U;
+            break;
+        default:
+            bRet = sendRel(pInst, nowUs);
+            break;
+    }
+
+    if (!bRet)
+    {
+        return;
+    }
+
+    pInst->lastReport = report;
+    pInst->lastSendUs = nowUs;
+    pInst->stats.reportNb += 1U;
+}
+
+/**
+ * @brief Transport context, the endpoint is free again : send what built up meanwhile
+ *
+ * Runs in the stack task (TinyUSB) : never blocks on the mutex, the holder may
+ * itself wait on the transport. When held, the report goes on the next
+ * MOUSE_flush of the mouse task.
+ */
+static void sendDone(void)
+{
+    Mouse_t * pInst = g_pInstDone;
+    uint32_t reportNb = 0U;
+
+    if (!pInst)
+    {
+        return;
+    }
+
+    if (xSemaphoreTake(pInst->mutex, 0U) != pdTRUE)
+    {
+        pInst->doneMissNb += 1U;
+        return;
+    }
+
+    reportNb = pInst->stats.reportNb;
+    flush(pInst);
+    pInst->stats.reportDoneNb += pInst->stats.reportNb - reportNb;
+    xSemaphoreGive(pInst->mutex);
+}
+
+Mouse_t * MOUSE_init(Transport_t * pTransport, uint8_t bEn, MousePersonality_e perso)
+{
+    uint8_t uRet = 0U;
+    Mouse_t * pInst = NULL;
+    TransportConf_t transportConf;
 
     LOGGER_setLevel(MODULE_ID_MOUSE, LOG_LVL_DEBUG);
 
     _log(LOG_LVL_DEBUG, "%s()", __func__);
 
-    pInst = (Mouse_t *) malloc(sizeof(Mouse_t));
+    if (!pTransport)
+    {
+        _log(LOG_LVL_ERROR, "%s() pTransport NULL", __func__);
+        goto out_err;
+    }
+
+    if (perso >= MOUSE_PERSO_NB)
+    {
+        _log(LOG_LVL_ERROR, "%s() perso out of range (%u >= %u)", __func__, perso, MOUSE_PERSO_NB);
+        goto out_err;
+    }
+
+    pInst = UTILS_INST_ALLOC(Mouse_t);
     if (!pInst)
     {
-        _log(LOG_LVL_ERROR, "%s() malloc %u Bytes for Mouse_t FAILED", __func__, sizeof(Mouse_t));
+        _log(LOG_LVL_ERROR, "%s() Alloc %u Bytes for Mouse_t FAILED", __func__, sizeof(Mouse_t));
         goto out_err;
     }
 
+    memset(pInst, 0, sizeof(Mouse_t));
+
     pInst->magic = MAGIC;
+    pInst->pTransport = pTransport;
     pInst->bEn = bEn;
+    pInst->perso = perso;
+    pInst->mode = MOUSE_MODE_REL;
+    pInst->absPos.x = MOUSE_ABS_CENTER;
+    pInst->absPos.y = MOUSE_ABS_CENTER;
+
+#if STATIC_ALLOC_EN
+    pInst->mutex = xSemaphoreCreateMutexStatic(&g_mutexBuf);
+#else
+    pInst->mutex = xSemaphoreCreateMutex();
+#endif
+    if (!pInst->mutex)
+    {
+        _log(LOG_LVL_ERROR, "%s() xSemaphoreCreateMutex FAILED", __func__);
+        goto out_free_err;
+    }
+
+    // Before start, completions can come as soon as the host polls
+    g_pInstDone = pInst;
+
+    transportConf.pReportDesc = PERSONALITY_LIST[perso].pReportDesc;
+    transportConf.reportDescLen = PERSONALITY_LIST[perso].reportDescLen;
+    transportConf.getFeature = getFeature;
+    transportConf.setFeature = setFeature;
+    transportConf.sendDone = sendDone;
+    transportConf.hostReset = hostReset;
+    hostReset();
 
-    _log(LOG_LVL_DEBUG, "%s() Init USB", __func__);
+    _log(LOG_LVL_DEBUG, "%s() Start transport, %s personality", __func__, PERSONALITY_LIST[perso].sName);
 
-    ret = tinyusb_driver_install(&usbConf);
-    if (ret != ESP_OK)
+    uRet = TRANSPORT_start(pTransport, &transportConf);
+    if (uRet)
     {
-        _log(LOG_LVL_ERROR, "%s() tinyusb_driver_install FAILED", __func__);
+        _log(LOG_LVL_ERROR, "%s() TRANSPORT_start FAILED", __func__);
         goto out_free_err;
     }
 
     return pInst;
 
 out_free_err:
+    g_pInstDone = NULL;
+    if (pInst && pInst->mutex)
+        vSemaphoreDelete(pInst->mutex);
     if (pInst)
-        free(pInst);
+        UTILS_INST_FREE(pInst);
 out_err:
     return NULL;
 }
@@ -171,7 +686,122 @@ uint8_t MOUSE_getEnabled(Mouse_t * pInst)
     return pInst->bEn;
 }
 
-uint8_t MOUSE_move(Mouse_t * pInst, int8_t x, int8_t y)
+void MOUSE_setPersonality(Mouse_t * pInst, MousePersonality_e perso)
+{
+    uint8_t uRet = 0U;
+
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return;
+    }
+
+    if (perso >= MOUSE_PERSO_NB)
+    {
+        _log(LOG_LVL_ERROR, "%s() perso out of range (%u >= %u)", __func__, perso, MOUSE_PERSO_NB);
+        return;
+    }
+
+    // Flush and the send completion read the personality and pending state
+    xSemaphoreTake(pInst->mutex, portMAX_DELAY);
+
+    if (perso == pInst->perso)
+    {
+        xSemaphoreGive(pInst->mutex);
+        return;
+    }
+
+    uRet = TRANSPORT_setReportDesc(pInst->pTransport, PERSONALITY_LIST[perso].pReportDesc, PERSONALITY_LIST[perso].reportDescLen);
+    if (uRet)
+    {
+        xSemaphoreGive(pInst->mutex);
+        _log(LOG_LVL_ERROR, "%s() TRANSPORT_setReportDesc FAILED", __func__);
+        return;
+    }
+
+    pInst->perso = perso;
+    hostReset();
+
+    // Pending reports the new descriptor does not declare are dropped
+    if (!PERSONALITY_LIST[perso].bGamepad)
+    {
+        pInst->bGamepadDirty = 0U;
+    }
+
+    if (!PERSONALITY_LIST[perso].bMouse)
+    {
+        pInst->bAbsDirty = 0U;
+        // Out of moveIn too, moveIn - moveOut stays the backlog
+        pInst->stats.moveIn.x = wrapAdd(pInst->stats.moveIn.x, -pInst->moveAcc.x);
+        pInst->stats.moveIn.y = wrapAdd(pInst->stats.moveIn.y, -pInst->moveAcc.y);
+        pInst->moveAcc.x = 0;
+        pInst->moveAcc.y = 0;
+        pInst->scrollAcc.x = 0;
+        pInst->scrollAcc.y = 0;
+    }
+
+    xSemaphoreGive(pInst->mutex);
+
+    _log(LOG_LVL_INFO, "Personality %s", PERSONALITY_LIST[perso].sName);
+}
+
+MousePersonality_e MOUSE_getPersonality(Mouse_t * pInst)
+{
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return MOUSE_PERSO_MOUSE;
+    }
+
+    return pInst->perso;
+}
+
+void MOUSE_setMode(Mouse_t * pInst, MouseMode_e mode)
+{
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return;
+    }
+
+    if (mode >= MOUSE_MODE_NB)
+    {
+        _log(LOG_LVL_ERROR, "%s() mode out of range (%u >= %u)", __func__, mode, MOUSE_MODE_NB);
+        return;
+    }
+
+    xSemaphoreTake(pInst->mutex, portMAX_DELAY);
+    pInst->mode = mode;
+    if (pInst->mode == MOUSE_MODE_ABS)
+    {
+        // Restart from screen center, host position is unknown
+        pInst->absPos.x = MOUSE_ABS_CENTER;
+        pInst->absPos.y = MOUSE_ABS_CENTER;
+    }
+    xSemaphoreGive(pInst->mutex);
+
+    if (mode == MOUSE_MODE_ABS)
+    {
+        _log(LOG_LVL_INFO, "Absolute mode");
+    }
+    else
+    {
+        _log(LOG_LVL_INFO, "Relative mode");
+    }
+}
+
+MouseMode_e MOUSE_getMode(Mouse_t * pInst)
+{
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return MOUSE_MODE_REL;
+    }
+
+    return pInst->mode;
+}
+
+uint8_t MOUSE_move(Mouse_t * pInst, int32_t x, int32_t y)
 {
     if (!pInst || pInst->magic != MAGIC)
     {
@@ -179,17 +809,166 @@ uint8_t MOUSE_move(Mouse_t * pInst, int8_t x, int8_t y)
         return 1U;
     }
 
-    if (pInst->bEn == 0U)
+    if ((pInst->bEn == 0U) || !PERSONALITY_LIST[pInst->perso].bMouse)
     {
         return 0U;
     }
 
-    if ((x == 0U) && (y == 0U))
+    xSemaphoreTake(pInst->mutex, portMAX_DELAY);
+
+    if ((x != 0) || (y != 0))
+    {
+        if (pInst->mode == MOUSE_MODE_ABS)
+        {
+            pInst->absPos.x = absClamp(pInst->absPos.x + (int64_t) x * MOUSE_ABS_GAIN);
+            pInst->absPos.y = absClamp(pInst->absPos.y + (int64_t) y * MOUSE_ABS_GAIN);
+            pInst->bAbsDirty = 1U;
+        }
+        else
+        {
+            if ((pInst->moveAcc.x == 0) && (pInst->moveAcc.y == 0))
+            {
+                pInst->pendingSinceUs = esp_timer_get_time();
+            }
+            else
+            {
+                // Earlier motion still waiting for the endpoint, both go in the same report
+                pInst->stats.coalescedNb += 1U;
+            }
+
+            x = accAdd(&pInst->moveAcc.x, x, &pInst->stats.clipNb);
+            y = accAdd(&pInst->moveAcc.y, y, &pInst->stats.clipNb);
+            pInst->stats.moveIn.x = wrapAdd(pInst->stats.moveIn.x, x);
+            pInst->stats.moveIn.y = wrapAdd(pInst->stats.moveIn.y, y);
+        }
+    }
+
+    flush(pInst);
+    xSemaphoreGive(pInst->mutex);
+
+    return 0U;
+}
+
+uint8_t MOUSE_moveAbs(Mouse_t * pInst, int32_t x, int32_t y)
+{
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return 1U;
+    }
+
+    if ((pInst->bEn == 0U) || !PERSONALITY_LIST[pInst->perso].bMouse || (pInst->mode != MOUSE_MODE_ABS))
     {
         return 0U;
     }
 
-    tud_hid_mouse_report(HID_ITF_PROTOCOL_MOUSE, 0x00, x, y, 0, 0);
+    xSemaphoreTake(pInst->mutex, portMAX_DELAY);
+
+    x = absClamp(x);
+    y = absClamp(y);
+
+    if ((x != pInst->absPos.x) || (y != pInst->absPos.y))
+    {
+        pInst->absPos.x = x;
+        pInst->absPos.y = y;
+        pInst->bAbsDirty = 1U;
+    }
+
+    flush(pInst);
+    xSemaphoreGive(pInst->mutex);
+
+    return 0U;
+}
+
+uint8_t MOUSE_scroll(Mouse_t * pInst, int16_t wheel, int16_t pan)
+{
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return 1U;
+    }
+
+    if ((pInst->bEn == 0U) || !PERSONALITY_LIST[pInst->perso].bMouse)
+    {
+        return 0U;
+    }
+
+    xSemaphoreTake(pInst->mutex, portMAX_DELAY);
+
+    // Before adding, the new scroll is in the new host units
+    scrollReset(pInst);
+    accAdd(&pInst->scrollAcc.x, pan, &pInst->stats.clipNb);
+    accAdd(&pInst->scrollAcc.y, wheel, &pInst->stats.clipNb);
+
+    flush(pInst);
+    xSemaphoreGive(pInst->mutex);
+
+    return 0U;
+}
+
+uint8_t MOUSE_gamepad(Mouse_t * pInst, int16_t x, int16_t y, uint8_t buttons)
+{
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return 1U;
+    }
+
+    if ((pInst->bEn == 0U) || !PERSONALITY_LIST[pInst->perso].bGamepad)
+    {
+        return 0U;
+    }
+
+    xSemaphoreTake(pInst->mutex, portMAX_DELAY);
+
+    // Absolute axes, only changes are sent, latest state wins
+    if ((x != pInst->gamepad.x) || (y != pInst->gamepad.y) || (buttons != pInst->gamepadBtn))
+    {
+        pInst->gamepad.x = x;
+        pInst->gamepad.y = y;
+        pInst->gamepadBtn = buttons;
+        pInst->bGamepadDirty = 1U;
+    }
+
+    flush(pInst);
+    xSemaphoreGive(pInst->mutex);
+
+    return 0U;
+}
+
+uint8_t MOUSE_flush(Mouse_t * pInst)
+{
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return 1U;
+    }
+
+    xSemaphoreTake(pInst->mutex, portMAX_DELAY);
+    flush(pInst);
+    xSemaphoreGive(pInst->mutex);
+
+    return 0U;
+}
+
+uint8_t MOUSE_getStats(Mouse_t * pInst, MouseStats_t * pStats)
+{
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return 1U;
+    }
+
+    if (!pStats)
+    {
+        _log(LOG_LVL_ERROR, "%s() pStats NULL", __func__);
+        return 1U;
+    }
+
+    xSemaphoreTake(pInst->mutex, portMAX_DELAY);
+    *pStats = pInst->stats;
+    pStats->doneMissNb = pInst->doneMissNb;
+    xSemaphoreGive(pInst->mutex);
 
     return 0U;
 }
@@ -4,17 +4,127 @@
 
 #include <inttypes.h>
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "transport.h"
+#include "utils.h"
+
+// Absolute pointer coordinates range
+#define MOUSE_ABS_MIN 0
+#define MOUSE_ABS_MAX 32767
+#define MOUSE_ABS_CENTER (MOUSE_ABS_MAX / 2)
+
+// Gamepad axes range, [-MOUSE_GAMEPAD_AXIS_MAX, MOUSE_GAMEPAD_AXIS_MAX]
+#define MOUSE_GAMEPAD_AXIS_MAX 32767
+
+typedef enum MousePersonality_e
+{
+    // Relative / absolute mouse
+    MOUSE_PERSO_MOUSE = 0,
+    // Gamepad axes, curves left to the host
+    MOUSE_PERSO_GAMEPAD,
+    // Mouse and gamepad on the same interface
+    MOUSE_PERSO_COMBINED,
+    MOUSE_PERSO_NB,
+} MousePersonality_e;
+
+typedef enum MouseMode_e
+{
+    // Relative motion (standard mouse)
+    MOUSE_MODE_REL = 0,
+    // Absolute pointer position (digitizer like)
+    MOUSE_MODE_ABS,
+    MOUSE_MODE_NB,
+} MouseMode_e;
+
+// Report kinds, in turn order when several are pending
+typedef enum MouseReport_e
+{
+    MOUSE_REPORT_REL = 0,
+    MOUSE_REPORT_ABS,
+    MOUSE_REPORT_GAMEPAD,
+    MOUSE_REPORT_NB,
+} MouseReport_e;
+
+typedef struct MouseStats_t
+{
+    // Relative motion requested / sent, equal once flushed, totals wrap (compare differences)
+    Coord_t moveIn;
+    Coord_t moveOut;
+    uint32_t reportNb;
+    // Longest time relative motion waited in accumulator
+    uint32_t latencyMaxUs;
+    // Relative motion and scroll dropped at MOUSE_MOVE_ACC_MAX, not part of moveIn
+    uint32_t clipNb;
+    // MOUSE_move merged with motion not sent yet (endpoint busy)
+    uint32_t coalescedNb;
+    // Reports sent with a remainder left, total beyond int8
+    uint32_t splitNb;
+    // Reports sent from the transport completion callback, part of reportNb
+    uint32_t reportDoneNb;
+    // Completions that found the mutex held, left to the next MOUSE_flush
+    uint32_t doneMissNb;
+} MouseStats_t;
+
 typedef struct Mouse_t
 {
     uint32_t magic;
+    // Mouse task and transport completion callback both send
+    SemaphoreHandle_t mutex;
+    Transport_t * pTransport;
     uint8_t bEn;
+    MousePersonality_e perso;
+    MouseMode_e mode;
+    // Absolute position, in [MOUSE_ABS_MIN, MOUSE_ABS_MAX]
+    Coord_t absPos;
+    uint8_t bAbsDirty;
+    // Relative motion not sent yet, merged until the transport takes a report
+    Coord_t moveAcc;
+    int64_t pendingSinceUs;
+    // Scroll remainder, in 1 / MOUSE_SCROLL_RES_MULT detent (x : pan, y : wheel)
+    Coord_t scrollAcc;
+    // Gamepad state
+    Coord_t gamepad;
+    uint8_t gamepadBtn;
+    uint8_t bGamepadDirty;
+    int64_t lastSendUs;
+    // Kind of the last report sent, the next pending kind after it goes first
+    MouseReport_e lastReport;
+    MouseStats_t stats;
+    // Written by the completion callback without the mutex, stats.doneMissNb is filled from it
+    volatile uint32_t doneMissNb;
+    // Set by the transport on host reset, scroll backlog rounded under the mutex
+    volatile uint8_t bHostReset;
 } Mouse_t;
 
-Mouse_t * MOUSE_init(uint8_t bEn);
+Mouse_t * MOUSE_init(Transport_t * pTransport, uint8_t bEn, MousePersonality_e perso);
+
+// Changes report descriptor, the transport re-enumerates when it supports it
+void MOUSE_setPersonality(Mouse_t * pInst, MousePersonality_e perso);
+MousePersonality_e MOUSE_getPersonality(Mouse_t * pInst);
 
 void MOUSE_setEnabled(Mouse_t * pInst, uint8_t bEn);
 uint8_t MOUSE_getEnabled(Mouse_t * pInst);
 
-uint8_t MOUSE_move(Mouse_t * pInst, int8_t x, int8_t y);
+void MOUSE_setMode(Mouse_t * pInst, MouseMode_e mode);
+MouseMode_e MOUSE_getMode(Mouse_t * pInst);
+
+// Relative motion, integrated into absolute position in MOUSE_MODE_ABS, split over reports beyond int8
+uint8_t MOUSE_move(Mouse_t * pInst, int32_t x, int32_t y);
+
+// Absolute position, in [MOUSE_ABS_MIN, MOUSE_ABS_MAX], MOUSE_MODE_ABS only
+uint8_t MOUSE_moveAbs(Mouse_t * pInst, int32_t x, int32_t y);
+
+// wheel and pan in 1 / MOUSE_SCROLL_RES_MULT detent
+uint8_t MOUSE_scroll(Mouse_t * pInst, int16_t wheel, int16_t pan);
+
+// Gamepad axes, in [-MOUSE_GAMEPAD_AXIS_MAX, MOUSE_GAMEPAD_AXIS_MAX], gamepad personalities only
+uint8_t MOUSE_gamepad(Mouse_t * pInst, int16_t x, int16_t y, uint8_t buttons);
+
+// Send the next pending report, if the transport takes it, one per call and transport interval
+uint8_t MOUSE_flush(Mouse_t * pInst);
+
+uint8_t MOUSE_getStats(Mouse_t * pInst, MouseStats_t * pStats);
 
 #endif // MOUSE_H
@@ -0,0 +1,202 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "logger.h"
+#include "utils.h"
+
+#include "predict.h"
+
+static const uint32_t MAGIC = 561348;
+
+UTILS_INST_POOL(Predict_t, 1);
+
+static void __attribute__((format (printf, 2, 3))) _log(LogLevel_e lvl, const char * sFmt, ...);
+
+static void _log(LogLevel_e lvl, const char * sFmt, ...)
+{
+    va_list pArg;
+
+    va_start(pArg, sFmt);
+    LOGGER_log_va(MODULE_ID_PREDICT, lvl, sFmt, pArg);
+    va_end(pArg);
+}
+
+static int32_t sat32(int64_t val)
+{
+    if (val > INT32_MAX)
+    {
+        return INT32_MAX;
+    }
+
+    if (val < INT32_MIN)
+    {
+        return INT32_MIN;
+    }
+
+    return (int32_t) val;
+}
+
+// One axis alpha-beta step, return output extrapolated leadUs ahead, input units
+static int32_t axisUpdate(const PredictParams_t * pParams, int32_t * pPos, int32_t * pVel, int32_t in, uint32_t dtUs)
+{
+    int64_t pos = 0;
+    int64_t vel = *pVel;
+    int64_t res = 0;
+    int64_t out = 0;
+
+    // Predict to this sample, then correct with the residual
+    pos = (int64_t) *pPos + vel * dtUs / US_PER_MS;
+    res = (int64_t) in * (1 << PREDICT_STATE_SHIFT) - pos;
+
+    pos += res * pParams->alpha / PREDICT_GAIN_ONE;
+    if (dtUs)
+    {
+        vel += res * pParams->beta / PREDICT_GAIN_ONE * US_PER_MS / dtUs;
+    }
+
+    *pPos = sat32(pos);
+    *pVel = sat32(vel);
+
+    out = (int64_t) *pPos + (int64_t) *pVel * pParams->leadUs / US_PER_MS;
+
+    // Round to nearest
+    return sat32((out + (1 << (PREDICT_STATE_SHIFT - 1U))) >> PREDICT_STATE_SHIFT);
+}
+
+static int32_t clamp(int32_t val, int32_t min, int32_t max)
+{
+    if (val < min)
+    {
+        return min;
+    }
+
+    if (val > max)
+    {
+        return max;
+    }
+
+    return val;
+}
+
+static uint8_t paramsCheck(const PredictParams_t * pParams)
+{
+    // Stable alpha-beta : 0 < alpha <= 1, 0 < beta < 4 - 2 alpha
+    if ((pParams->alpha == 0U) || (pParams->alpha > PREDICT_GAIN_ONE))
+    {
+        return 1U;
+    }
+
+    if ((pParams->beta == 0U) || (pParams->beta >= 4U * PREDICT_GAIN_ONE - 2U * pParams->alpha))
+    {
+        return 1U;
+    }
+
+    return 0U;
+}
+
+Predict_t * PREDICT_init(const PredictParams_t * pParams, int32_t outMin, int32_t outMax)
+{
+    Predict_t * pInst = NULL;
+
+    LOGGER_setLevel(MODULE_ID_PREDICT, LOG_LVL_DEBUG);
+
+    _log(LOG_LVL_DEBUG, "%s()", __func__);
+
+    if (!pParams || paramsCheck(pParams))
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad parameters", __func__);
+        return NULL;
+    }
+
+    pInst = UTILS_INST_ALLOC(Predict_t);
+    if (!pInst)
+    {
+        _log(LOG_LVL_ERROR, "%s() Alloc %u Bytes for Predict_t FAILED", __func__, sizeof(Predict_t));
+        return NULL;
+    }
+
+    memset(pInst, 0, sizeof(Predict_t));
+
+    pInst->magic = MAGIC;
+    pInst->params = *pParams;
+    pInst->outMin = outMin;
+    pInst->outMax = outMax;
+
+    return pInst;
+}
+
+uint8_t PREDICT_setParams(Predict_t * pInst, const PredictParams_t * pParams)
+{
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return 1U;
+    }
+
+    if (!pParams || paramsCheck(pParams))
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad parameters", __func__);
+        return 1U;
+    }
+
+    pInst->params = *pParams;
+    pInst->bInit = 0U;
+
+    _log(LOG_LVL_INFO, "en = %u, alpha = %u/%u, beta = %u/%u, lead = %lu us",
+        pParams->bEn, pParams->alpha, PREDICT_GAIN_ONE, pParams->beta, PREDICT_GAIN_ONE, pParams->leadUs);
+
+    return 0U;
+}
+
+uint8_t PREDICT_getParams(Predict_t * pInst, PredictParams_t * pParams)
+{
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return 1U;
+    }
+
+    if (!pParams)
+    {
+        _log(LOG_LVL_ERROR, "%s() pParams NULL", __func__);
+        return 1U;
+    }
+
+    *pParams = pInst->params;
+
+    return 0U;
+}
+
+uint8_t PREDICT_update(Predict_t * pInst, const Coord_t * pIn, uint32_t dtUs, Coord_t * pOut)
+{
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return 1U;
+    }
+
+    if (!pIn || !pOut)
+    {
+        _log(LOG_LVL_ERROR, "%s() pIn or pOut NULL", __func__);
+        return 1U;
+    }
+
+    if (!pInst->params.bEn || !pInst->bInit)
+    {
+        // Disabled, or first sample : state starts at rest on the input
+        pInst->pos.x = sat32((int64_t) pIn->x * (1 << PREDICT_STATE_SHIFT));
+        pInst->pos.y = sat32((int64_t) pIn->y * (1 << PREDICT_STATE_SHIFT));
+        pInst->vel.x = 0;
+        pInst->vel.y = 0;
+        pInst->bInit = pInst->params.bEn;
+        *pOut = *pIn;
+        return 0U;
+    }
+
+    pOut->x = clamp(axisUpdate(&pInst->params, &pInst->pos.x, &pInst->vel.x, pIn->x, dtUs), pInst->outMin, pInst->outMax);
+    pOut->y = clamp(axisUpdate(&pInst->params, &pInst->pos.y, &pInst->vel.y, pIn->y, dtUs), pInst->outMin, pInst->outMax);
+
+    return 0U;
+}
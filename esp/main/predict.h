@@ -0,0 +1,52 @@
+
+#ifndef PREDICT_H
+#define PREDICT_H
+
+#include <inttypes.h>
+
+#include "utils.h"
+
+// Fixed point formats
+#define PREDICT_GAIN_SHIFT 8U
+#define PREDICT_GAIN_ONE (1 << PREDICT_GAIN_SHIFT)
+#define PREDICT_STATE_SHIFT 16U
+
+/**
+ * @brief Alpha-beta tuning
+ *
+ * alpha, beta are Q8 (PREDICT_GAIN_ONE = 1.0). Output is extrapolated leadUs
+ * after the input sample, to cancel the averaging delay and reach the report
+ * transmit time.
+ */
+typedef struct PredictParams_t
+{
+    uint8_t bEn;
+    uint16_t alpha;
+    uint16_t beta;
+    uint32_t leadUs;
+} PredictParams_t;
+
+typedef struct Predict_t
+{
+    uint32_t magic;
+    PredictParams_t params;
+    int32_t outMin;
+    int32_t outMax;
+    uint8_t bInit;
+    // Position, Q16 input units
+    Coord_t pos;
+    // Velocity, Q16 input units per ms
+    Coord_t vel;
+} Predict_t;
+
+Predict_t * PREDICT_init(const PredictParams_t * pParams, int32_t outMin, int32_t outMax);
+
+// Takes effect on next update, state restarts from next input
+uint8_t PREDICT_setParams(Predict_t * pInst, const PredictParams_t * pParams);
+
+uint8_t PREDICT_getParams(Predict_t * pInst, PredictParams_t * pParams);
+
+// New input sample dtUs after the previous one, pOut is pIn when disabled
+uint8_t PREDICT_update(Predict_t * pInst, const Coord_t * pIn, uint32_t dtUs, Coord_t * pOut);
+
+#endif // PREDICT_H
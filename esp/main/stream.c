@@ -0,0 +1,225 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sdkconfig.h"
+#include "tinyusb.h"
+
+#include "config.h"
+#include "logger.h"
+#include "utils.h"
+
+#include "stream.h"
+
+#if STREAM_EN
+#if !CONFIG_TINYUSB_CDC_ENABLED
+#error "STREAM_EN needs CONFIG_TINYUSB_CDC_ENABLED"
+#endif
+#include "class/cdc/cdc_device.h"
+#endif
+
+static const uint32_t MAGIC = 561348;
+
+UTILS_INST_POOL(Stream_t, 1);
+
+static void __attribute__((format (printf, 2, 3))) _log(LogLevel_e lvl, const char * sFmt, ...);
+
+static void _log(LogLevel_e lvl, const char * sFmt, ...)
+{
+    va_list pArg;
+
+    va_start(pArg, sFmt);
+    LOGGER_log_va(MODULE_ID_STREAM, lvl, sFmt, pArg);
+    va_end(pArg);
+}
+
+// CRC-8, poly 0x07, init 0x00
+static uint8_t crc8(const uint8_t * pData, uint8_t len)
+{
+    uint8_t crc = 0U;
+
+    for (uint8_t idx = 0U; idx < len; idx += 1U)
+    {
+        crc ^= pData[idx];
+        for (uint8_t bit = 0U; bit < 8U; bit += 1U)
+        {
+            crc = (crc & 0x80U) ? (uint8_t) ((crc << 1) ^ 0x07U) : (uint8_t) (crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+// COBS encode pIn, 0x00 terminated, return encoded size
+static uint8_t cobsEncode(const uint8_t * pIn, uint8_t len, uint8_t * pOut)
+{
+    uint8_t outIdx = 1U;
+    uint8_t codeIdx = 0U;
+    uint8_t code = 1U;
+
+    for (uint8_t inIdx = 0U; inIdx < len; inIdx += 1U)
+    {
+        if (pIn[inIdx] == 0U)
+        {
+            pOut[codeIdx] = code;
+            codeIdx = outIdx;
+            outIdx += 1U;
+            code = 1U;
+            continue;
+        }
+
+        pOut[outIdx] = pIn[inIdx];
+        outIdx += 1U;
+        code += 1U;
+
+        if (code == 0xFFU)
+        {
+            pOut[codeIdx] = code;
+            codeIdx = outIdx;
+            outIdx += 1U;
+            code = 1U;
+        }
+    }
+
+    pOut[codeIdx] = code;
+    pOut[outIdx] = 0x00U;
+
+    return outIdx + 1U;
+}
+
+// Build frame with every channel, return frame size
+static uint8_t frameBuild(Stream_t * pInst, uint32_t timestampUs, const int32_t * pVal)
+{
+    uint8_t size = 0U;
+    uint32_t acc = 0U;
+    uint8_t accBits = 0U;
+
+    pInst->pFrame[size++] = STREAM_SAMPLE_BITS;
+    pInst->pFrame[size++] = pInst->seq;
+    pInst->pFrame[size++] = (uint8_t) timestampUs;
+    pInst->pFrame[size++] = (uint8_t) (timestampUs >> 8);
+    pInst->pFrame[size++] = (uint8_t) (timestampUs >> 16);
+    pInst->pFrame[size++] = (uint8_t) (timestampUs >> 24);
+    pInst->pFrame[size++] = (uint8_t) ((1U << STREAM_CHAN_NB) - 1U);
+
+    // Samples, packed LSB first
+    for (uint8_t chan = 0U; chan < STREAM_CHAN_NB; chan += 1U)
+    {
+        acc |= ((uint32_t) pVal[chan] & ((1UL << STREAM_SAMPLE_BITS) - 1U)) << accBits;
+        accBits += STREAM_SAMPLE_BITS;
+
+        while (accBits >= 8U)
+        {
+            pInst->pFrame[size++] = (uint8_t) acc;
+            acc >>= 8;
+            accBits -= 8U;
+        }
+    }
+
+    if (accBits)
+    {
+        pInst->pFrame[size++] = (uint8_t) acc;
+    }
+
+    pInst->pFrame[size] = crc8(pInst->pFrame, size);
+    size += 1U;
+
+    return size;
+}
+
+static uint8_t isConnected(void)
+{
+#if STREAM_EN
+    // Host opened the port (DTR set)
+    return tud_cdc_n_connected(STREAM_CDC_ITF);
+#else
+    return 0U;
+#endif
+}
+
+// Queue frame, 0 if the CDC FIFO has no room
+static uint8_t frameWrite(const uint8_t * pFrame, uint8_t len)
+{
+#if STREAM_EN
+    if (tud_cdc_n_write_available(STREAM_CDC_ITF) < len)
+    {
+        return 0U;
+    }
+
+    tud_cdc_n_write(STREAM_CDC_ITF, pFrame, len);
+    // Goes out now if the endpoint is idle, else with the next transfer
+    tud_cdc_n_write_flush(STREAM_CDC_ITF);
+
+    return 1U;
+#else
+    (void) pFrame;
+    (void) len;
+
+    return 0U;
+#endif
+}
+
+Stream_t * STREAM_init(void)
+{
+    Stream_t * pInst = NULL;
+
+    LOGGER_setLevel(MODULE_ID_STREAM, LOG_LVL_DEBUG);
+
+    _log(LOG_LVL_DEBUG, "%s()", __func__);
+
+    pInst = UTILS_INST_ALLOC(Stream_t);
+    if (!pInst)
+    {
+        _log(LOG_LVL_ERROR, "%s() Alloc %u Bytes for Stream_t FAILED", __func__, sizeof(Stream_t));
+        return NULL;
+    }
+
+    memset(pInst, 0, sizeof(Stream_t));
+
+    pInst->magic = MAGIC;
+
+    return pInst;
+}
+
+uint8_t STREAM_push(Stream_t * pInst, uint32_t timestampUs, const Coord_t * pRaw)
+{
+    uint8_t size = 0U;
+    int32_t pVal[STREAM_CHAN_NB];
+
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return 1U;
+    }
+
+    if (!pRaw)
+    {
+        _log(LOG_LVL_ERROR, "%s() pRaw NULL", __func__);
+        return 1U;
+    }
+
+    if (!isConnected())
+    {
+        return 0U;
+    }
+
+    pVal[STREAM_CHAN_Y] = pRaw->y;
+    pVal[STREAM_CHAN_X] = pRaw->x;
+
+    size = frameBuild(pInst, timestampUs, pVal);
+    size = cobsEncode(pInst->pFrame, size, pInst->pFrameCobs);
+
+    // Sequence advances on drops too, so the host sees gaps
+    pInst->seq += 1U;
+
+    if (!frameWrite(pInst->pFrameCobs, size))
+    {
+        pInst->dropCnt += 1U;
+        return 0U;
+    }
+
+    pInst->frameCnt += 1U;
+
+    return 0U;
+}
@@ -0,0 +1,48 @@
+
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <inttypes.h>
+
+#include "utils.h"
+
+// CDC instance of the raw stream
+#define STREAM_CDC_ITF 0U
+
+// Sample width, ADC1 is configured for 13 bits
+#define STREAM_SAMPLE_BITS 13U
+
+// Frame channels, same order as the Arduino sketch so the host bridge reads both
+#define STREAM_CHAN_Y 0U
+#define STREAM_CHAN_X 1U
+#define STREAM_CHAN_NB 2U
+
+/**
+ * @brief Frame layout, see arduino/serial_frame.py
+ *
+ * bits u8, seq u8, timestamp u32 (us), channel mask u8, packed samples, CRC-8.
+ * COBS encoded, 0x00 delimited.
+ */
+#define STREAM_HDR_SIZE 7U
+#define STREAM_DATA_SIZE ((STREAM_CHAN_NB * STREAM_SAMPLE_BITS + 7U) / 8U)
+#define STREAM_FRAME_SIZE (STREAM_HDR_SIZE + STREAM_DATA_SIZE + 1U)
+// COBS overhead (1 Byte per 254) and delimiter
+#define STREAM_FRAME_COBS_SIZE (STREAM_FRAME_SIZE + STREAM_FRAME_SIZE / 254U + 2U)
+
+typedef struct Stream_t
+{
+    uint32_t magic;
+    uint8_t seq;
+    uint32_t frameCnt;
+    // Frames not sent, CDC FIFO full
+    uint32_t dropCnt;
+    uint8_t pFrame[STREAM_FRAME_SIZE];
+    uint8_t pFrameCobs[STREAM_FRAME_COBS_SIZE];
+} Stream_t;
+
+Stream_t * STREAM_init(void);
+
+// Send one raw acquisition, nothing is sent while the host port is closed
+uint8_t STREAM_push(Stream_t * pInst, uint32_t timestampUs, const Coord_t * pRaw);
+
+#endif // STREAM_H
@@ -0,0 +1,348 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sdkconfig.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "config.h"
+#include "logger.h"
+#include "utils.h"
+
+#include "sysmon.h"
+
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY && CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+#define SYSMON_CPU_EN 1
+#else
+#define SYSMON_CPU_EN 0
+#endif
+
+static const uint32_t MAGIC = 561348;
+
+UTILS_INST_POOL(Sysmon_t, 1);
+
+typedef struct SysmonTaskConf_t
+{
+    const char * sName;
+    uint32_t stackSize;
+} SysmonTaskConf_t;
+
+// Created by ESP-IDF, stack sizes from sdkconfig
+static const SysmonTaskConf_t SYSTEM_TASK_LIST[] =
+{
+    {"main", CONFIG_ESP_MAIN_TASK_STACK_SIZE},
+    {"IDLE", CONFIG_FREERTOS_IDLE_TASK_STACKSIZE},
+    {"esp_timer", CONFIG_ESP_TIMER_TASK_STACK_SIZE},
+#ifdef CONFIG_TINYUSB_TASK_STACK_SIZE
+    {"TinyUSB", CONFIG_TINYUSB_TASK_STACK_SIZE},
+#endif
+};
+
+static void __attribute__((format (printf, 2, 3))) _log(LogLevel_e lvl, const char * sFmt, ...);
+
+static void _log(LogLevel_e lvl, const char * sFmt, ...)
+{
+    va_list pArg;
+
+    va_start(pArg, sFmt);
+    LOGGER_log_va(MODULE_ID_SYSMON, lvl, sFmt, pArg);
+    va_end(pArg);
+}
+
+static uint8_t permilToPct(uint16_t val)
+{
+    return (uint8_t) ((val + 5U) / 10U);
+}
+
+#if SYSMON_CPU_EN
+static uint16_t permil(uint32_t part, uint32_t total)
+{
+    uint64_t val = 0U;
+
+    if (total == 0U)
+    {
+        return 0U;
+    }
+
+    val = (uint64_t) part * 1000U / total;
+
+    return (val > 1000U) ? 1000U : (uint16_t) val;
+}
+
+// Run time counter of a task in the last snapshot, 0 if not found
+static uint32_t runFind(const Sysmon_t * pInst, UBaseType_t stateNb, TaskHandle_t task, const char * sName)
+{
+    for (UBaseType_t idx = 0U; idx < stateNb; idx += 1U)
+    {
+        const TaskStatus_t * pState = &pInst->pTaskState[idx];
+
+        if ((task && (pState->xHandle == task)) || (sName && !strcmp(pState->pcTaskName, sName)))
+        {
+            return pState->ulRunTimeCounter;
+        }
+    }
+
+    return 0U;
+}
+#endif
+
+// Counter deltas since the previous call, the first call only primes them
+static void cpuSample(Sysmon_t * pInst)
+{
+#if SYSMON_CPU_EN
+    UBaseType_t stateNb = 0U;
+    uint32_t totalRun = 0U;
+    uint32_t totalDelta = 0U;
+    uint32_t idleDelta = 0U;
+    uint8_t bPrimed = (pInst->totalRunPrev != 0U);
+
+    stateNb = uxTaskGetSystemState(pInst->pTaskState, SYSMON_TASK_STATE_NB, &totalRun);
+    if (stateNb == 0U)
+    {
+        _log(LOG_LVL_WARN, "%s() uxTaskGetSystemState FAILED, more than %u tasks", __func__, SYSMON_TASK_STATE_NB);
+        return;
+    }
+
+    // Counters are 32 bits, unsigned deltas survive one wrap per period
+    totalDelta = totalRun - pInst->totalRunPrev;
+    pInst->totalRunPrev = totalRun;
+
+    for (UBaseType_t core = 0U; core < portNUM_PROCESSORS; core += 1U)
+    {
+        uint32_t run = runFind(pInst, stateNb, xTaskGetIdleTaskHandleForCPU(core), NULL);
+
+        idleDelta += run - pInst->pIdleRunPrev[core];
+        pInst->pIdleRunPrev[core] = run;
+    }
+
+    for (uint8_t idx = 0U; idx < pInst->taskNb; idx += 1U)
+    {
+        uint32_t run = runFind(pInst, stateNb, NULL, pInst->pTaskName[idx]);
+
+        // Not running, or just started : no meaningful delta yet
+        pInst->pTaskCpuPermil[idx] = (run && pInst->pTaskRunPrev[idx]) ? permil(run - pInst->pTaskRunPrev[idx], totalDelta) : 0U;
+        pInst->pTaskRunPrev[idx] = run;
+    }
+
+    if (!bPrimed)
+    {
+        return;
+    }
+
+    // Total counter is wall time, idle counters are per core
+    pInst->cpuLoadPermil = 1000U - permil(idleDelta, totalDelta * portNUM_PROCESSORS);
+    pInst->bCpuValid = 1U;
+#else
+    (void) pInst;
+#endif
+}
+
+Sysmon_t * SYSMON_init(uint32_t logPeriodMs, uint32_t cpuPeriodMs)
+{
+    Sysmon_t * pInst = NULL;
+
+    LOGGER_setLevel(MODULE_ID_SYSMON, LOG_LVL_DEBUG);
+
+    _log(LOG_LVL_DEBUG, "%s()", __func__);
+
+    pInst = UTILS_INST_ALLOC(Sysmon_t);
+    if (!pInst)
+    {
+        _log(LOG_LVL_ERROR, "%s() Alloc %u Bytes for Sysmon_t FAILED", __func__, sizeof(Sysmon_t));
+        return NULL;
+    }
+
+    memset(pInst, 0, sizeof(Sysmon_t));
+
+    pInst->magic = MAGIC;
+    pInst->logPeriodMs = logPeriodMs;
+    pInst->cpuPeriodMs = cpuPeriodMs;
+
+    for (uint8_t idx = 0U; idx < sizeof(SYSTEM_TASK_LIST) / sizeof(SYSTEM_TASK_LIST[0]); idx += 1U)
+    {
+        SYSMON_addTask(pInst, SYSTEM_TASK_LIST[idx].sName, SYSTEM_TASK_LIST[idx].stackSize);
+    }
+
+    // Minimum free heap from here on, boot time peaks excluded
+    if (heap_caps_monitor_local_minimum_free_size_start() != ESP_OK)
+    {
+        _log(LOG_LVL_WARN, "%s() heap_caps_monitor_local_minimum_free_size_start FAILED, minimum since boot", __func__);
+    }
+    pInst->heapFreeInit = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+
+    if (!SYSMON_CPU_EN)
+    {
+        _log(LOG_LVL_WARN, "%s() No CPU load, needs CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS and CONFIG_FREERTOS_USE_TRACE_FACILITY", __func__);
+    }
+    cpuSample(pInst);
+
+    return pInst;
+}
+
+uint8_t SYSMON_addTask(Sysmon_t * pInst, const char * sName, uint32_t stackSize)
+{
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return 1U;
+    }
+
+    if (!sName)
+    {
+        _log(LOG_LVL_ERROR, "%s() sName NULL", __func__);
+        return 1U;
+    }
+
+    if (pInst->taskNb >= SYSMON_TASK_NB_MAX)
+    {
+        _log(LOG_LVL_ERROR, "%s() %s : task table full (%u)", __func__, sName, SYSMON_TASK_NB_MAX);
+        return 1U;
+    }
+
+    pInst->pTaskName[pInst->taskNb] = sName;
+    pInst->pTaskStackSize[pInst->taskNb] = stackSize;
+    pInst->taskNb += 1U;
+
+    return 0U;
+}
+
+uint8_t SYSMON_getStats(Sysmon_t * pInst, SysmonStats_t * pStats)
+{
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return 1U;
+    }
+
+    if (!pStats)
+    {
+        _log(LOG_LVL_ERROR, "%s() pStats NULL", __func__);
+        return 1U;
+    }
+
+    memset(pStats, 0, sizeof(SysmonStats_t));
+
+    pStats->heapFree = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    pStats->heapFreeMin = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    pStats->heapFreeInit = pInst->heapFreeInit;
+    pStats->heapLargest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    pStats->cpuLoadPermil = pInst->cpuLoadPermil;
+    pStats->bCpuValid = pInst->bCpuValid;
+
+    pStats->taskNb = pInst->taskNb;
+    for (uint8_t idx = 0U; idx < pInst->taskNb; idx += 1U)
+    {
+        SysmonTaskStats_t * pTask = &pStats->pTask[idx];
+        TaskHandle_t task = xTaskGetHandle(pInst->pTaskName[idx]);
+
+        pTask->sName = pInst->pTaskName[idx];
+        pTask->stackSize = pInst->pTaskStackSize[idx];
+        pTask->cpuPermil = pInst->pTaskCpuPermil[idx];
+        if (task)
+        {
+            // ESP-IDF stack units are Bytes
+            pTask->stackFreeMin = uxTaskGetStackHighWaterMark(task);
+            pTask->bFound = 1U;
+        }
+    }
+
+    return 0U;
+}
+
+uint8_t SYSMON_getCpu(Sysmon_t * pInst, SysmonCpu_t * pCpu)
+{
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return 1U;
+    }
+
+    if (!pCpu)
+    {
+        _log(LOG_LVL_ERROR, "%s() pCpu NULL", __func__);
+        return 1U;
+    }
+
+    pCpu->taskNb = pInst->taskNb;
+    pCpu->load = pInst->bCpuValid ? permilToPct(pInst->cpuLoadPermil) : SYSMON_CPU_UNKNOWN;
+    for (uint8_t idx = 0U; idx < SYSMON_TASK_NB_MAX; idx += 1U)
+    {
+        pCpu->pTaskLoad[idx] = (pInst->bCpuValid && (idx < pInst->taskNb)) ? permilToPct(pInst->pTaskCpuPermil[idx]) : SYSMON_CPU_UNKNOWN;
+        pCpu->pTaskName[idx] = (idx < pInst->taskNb) ? pInst->pTaskName[idx] : NULL;
+    }
+
+    return 0U;
+}
+
+uint8_t SYSMON_log(Sysmon_t * pInst)
+{
+    SysmonStats_t stats;
+
+    if (SYSMON_getStats(pInst, &stats))
+    {
+        return 1U;
+    }
+
+    _log(LOG_LVL_INFO, "heap free %lu, min %lu (%ld since init), largest block %lu, %s allocation",
+        stats.heapFree, stats.heapFreeMin, (int32_t) (stats.heapFreeMin - stats.heapFreeInit), stats.heapLargest,
+        STATIC_ALLOC_EN ? "static" : "heap");
+
+    if (stats.bCpuValid)
+    {
+        _log(LOG_LVL_INFO, "cpu load %u.%u %%", stats.cpuLoadPermil / 10U, stats.cpuLoadPermil % 10U);
+    }
+
+    for (uint8_t idx = 0U; idx < stats.taskNb; idx += 1U)
+    {
+        const SysmonTaskStats_t * pTask = &stats.pTask[idx];
+
+        if (!pTask->bFound)
+        {
+            _log(LOG_LVL_INFO, "%-18s not running", pTask->sName);
+            continue;
+        }
+
+        _log(LOG_LVL_INFO, "%-18s stack %5lu, used max %5lu, free min %5lu, cpu %3u.%u %%",
+            pTask->sName, pTask->stackSize,
+            (pTask->stackSize > pTask->stackFreeMin) ? pTask->stackSize - pTask->stackFreeMin : 0U, pTask->stackFreeMin,
+            pTask->cpuPermil / 10U, pTask->cpuPermil % 10U);
+    }
+
+    return 0U;
+}
+
+uint8_t SYSMON_tick(Sysmon_t * pInst, uint32_t elapsedMs)
+{
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return 1U;
+    }
+
+    if (pInst->cpuPeriodMs)
+    {
+        pInst->cpuElapsedMs += elapsedMs;
+        if (pInst->cpuElapsedMs >= pInst->cpuPeriodMs)
+        {
+            cpuSample(pInst);
+            pInst->cpuElapsedMs = 0U;
+        }
+    }
+
+    if (pInst->logPeriodMs == 0U)
+    {
+        return 0U;
+    }
+
+    pInst->elapsedMs += elapsedMs;
+    if (pInst->elapsedMs < pInst->logPeriodMs)
+    {
+        return 0U;
+    }
+    pInst->elapsedMs = 0U;
+
+    return SYSMON_log(pInst);
+}
@@ -0,0 +1,97 @@
+
+#ifndef SYSMON_H
+#define SYSMON_H
+
+#include <inttypes.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// System tasks plus the ones added by the application
+#define SYSMON_TASK_NB_MAX 8U
+
+// Every task in the system, for the run time stats snapshot
+#define SYSMON_TASK_STATE_NB 16U
+
+// CPU load not measured yet, or run time stats not built in
+#define SYSMON_CPU_UNKNOWN 0xFFU
+
+typedef struct SysmonTaskStats_t
+{
+    const char * sName;
+    // Bytes, as passed to task creation
+    uint32_t stackSize;
+    // Bytes never used since task start (high water mark)
+    uint32_t stackFreeMin;
+    // Task running, stack figures valid
+    uint8_t bFound;
+    // Share of one core over the last CPU period, per mille
+    uint16_t cpuPermil;
+} SysmonTaskStats_t;
+
+typedef struct SysmonStats_t
+{
+    // Internal 8 bit capable heap, Bytes
+    uint32_t heapFree;
+    // Lowest free since SYSMON_init
+    uint32_t heapFreeMin;
+    // Free at SYSMON_init, end of initialization
+    uint32_t heapFreeInit;
+    uint32_t heapLargest;
+    // Busy (non idle) share averaged over cores, per mille, 0 until measured
+    uint16_t cpuLoadPermil;
+    uint8_t bCpuValid;
+    uint8_t taskNb;
+    SysmonTaskStats_t pTask[SYSMON_TASK_NB_MAX];
+} SysmonStats_t;
+
+// Compact CPU figures for telemetry, percent, SYSMON_CPU_UNKNOWN until measured
+typedef struct SysmonCpu_t
+{
+    uint8_t load;
+    uint8_t taskNb;
+    // Task table order, SYSMON_addTask after the system tasks
+    uint8_t pTaskLoad[SYSMON_TASK_NB_MAX];
+    // Same order, as passed to SYSMON_addTask, NULL past taskNb
+    const char * pTaskName[SYSMON_TASK_NB_MAX];
+} SysmonCpu_t;
+
+typedef struct Sysmon_t
+{
+    uint32_t magic;
+    uint32_t logPeriodMs;
+    uint32_t elapsedMs;
+    uint32_t heapFreeInit;
+    uint8_t taskNb;
+    const char * pTaskName[SYSMON_TASK_NB_MAX];
+    uint32_t pTaskStackSize[SYSMON_TASK_NB_MAX];
+    // CPU load from FreeRTOS run time counters, deltas over cpuPeriodMs
+    uint32_t cpuPeriodMs;
+    uint32_t cpuElapsedMs;
+    uint8_t bCpuValid;
+    uint32_t totalRunPrev;
+    uint32_t pTaskRunPrev[SYSMON_TASK_NB_MAX];
+    uint32_t pIdleRunPrev[portNUM_PROCESSORS];
+    // Written by the sampling task, single 16 bit stores
+    uint16_t cpuLoadPermil;
+    uint16_t pTaskCpuPermil[SYSMON_TASK_NB_MAX];
+    TaskStatus_t pTaskState[SYSMON_TASK_STATE_NB];
+} Sysmon_t;
+
+// Call once everything is initialized, heap minimum is tracked from there
+Sysmon_t * SYSMON_init(uint32_t logPeriodMs, uint32_t cpuPeriodMs);
+
+// Task looked up by name on each read, may be created later
+uint8_t SYSMON_addTask(Sysmon_t * pInst, const char * sName, uint32_t stackSize);
+
+uint8_t SYSMON_getStats(Sysmon_t * pInst, SysmonStats_t * pStats);
+
+// Any task, last measured values
+uint8_t SYSMON_getCpu(Sysmon_t * pInst, SysmonCpu_t * pCpu);
+
+uint8_t SYSMON_log(Sysmon_t * pInst);
+
+// Samples CPU load every cpuPeriodMs, logs every logPeriodMs (0 : never), elapsedMs since previous call
+uint8_t SYSMON_tick(Sysmon_t * pInst, uint32_t elapsedMs);
+
+#endif // SYSMON_H
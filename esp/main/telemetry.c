@@ -0,0 +1,198 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "logger.h"
+#include "utils.h"
+
+#include "telemetry.h"
+
+static const uint32_t MAGIC = 561348;
+
+UTILS_INST_POOL(Telemetry_t, 1);
+
+_Static_assert(sizeof(TelemetryPacket_t) == TELEMETRY_REPORT_LEN, "TelemetryPacket_t size");
+
+static void __attribute__((format (printf, 2, 3))) _log(LogLevel_e lvl, const char * sFmt, ...);
+
+static void _log(LogLevel_e lvl, const char * sFmt, ...)
+{
+    va_list pArg;
+
+    va_start(pArg, sFmt);
+    LOGGER_log_va(MODULE_ID_TELEM, lvl, sFmt, pArg);
+    va_end(pArg);
+}
+
+static int16_t sat16(int32_t val)
+{
+    if (val > INT16_MAX)
+    {
+        return INT16_MAX;
+    }
+
+    if (val < INT16_MIN)
+    {
+        return INT16_MIN;
+    }
+
+    return (int16_t) val;
+}
+
+static int8_t sat8(int32_t val)
+{
+    if (val > INT8_MAX)
+    {
+        return INT8_MAX;
+    }
+
+    if (val < INT8_MIN)
+    {
+        return INT8_MIN;
+    }
+
+    return (int8_t) val;
+}
+
+static uint16_t satU16(uint32_t val)
+{
+    return (val > UINT16_MAX) ? UINT16_MAX : (uint16_t) val;
+}
+
+Telemetry_t * TELEMETRY_init(Transport_t * pTransport, uint16_t period)
+{
+    Telemetry_t * pInst = NULL;
+
+    LOGGER_setLevel(MODULE_ID_TELEM, LOG_LVL_DEBUG);
+
+    _log(LOG_LVL_DEBUG, "%s()", __func__);
+
+    if (!pTransport)
+    {
+        _log(LOG_LVL_ERROR, "%s() pTransport NULL", __func__);
+        return NULL;
+    }
+
+    pInst = UTILS_INST_ALLOC(Telemetry_t);
+    if (!pInst)
+    {
+        _log(LOG_LVL_ERROR, "%s() Alloc %u Bytes for Telemetry_t FAILED", __func__, sizeof(Telemetry_t));
+        return NULL;
+    }
+
+    memset(pInst, 0, sizeof(Telemetry_t));
+
+    pInst->magic = MAGIC;
+    pInst->pTransport = pTransport;
+    pInst->period = period;
+
+    if (!TRANSPORT_hasAux(pTransport))
+    {
+        _log(LOG_LVL_INFO, "No telemetry channel on this transport, disabled");
+        pInst->period = 0U;
+    }
+
+    return pInst;
+}
+
+void TELEMETRY_setPeriod(Telemetry_t * pInst, uint16_t period)
+{
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return;
+    }
+
+    if ((period != 0U) && !TRANSPORT_hasAux(pInst->pTransport))
+    {
+        _log(LOG_LVL_WARN, "No telemetry channel on this transport");
+        return;
+    }
+
+    pInst->period = period;
+    pInst->cycleCnt = 0U;
+
+    _log(LOG_LVL_INFO, "Period %u cycles", period);
+}
+
+uint8_t TELEMETRY_update(Telemetry_t * pInst, const TelemetrySample_t * pSample)
+{
+    uint8_t seq = 0U;
+    TelemetryPacket_t packet;
+
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return 1U;
+    }
+
+    if (!pSample)
+    {
+        _log(LOG_LVL_ERROR, "%s() pSample NULL", __func__);
+        return 1U;
+    }
+
+    if (pInst->period == 0U)
+    {
+        return 0U;
+    }
+
+    pInst->cycleCnt += 1U;
+    if (pInst->cycleCnt < pInst->period)
+    {
+        return 0U;
+    }
+
+    pInst->cycleCnt = 0U;
+
+    // Sequence advances on drops too, so the host sees gaps
+    seq = pInst->seq;
+    pInst->seq += 1U;
+
+    if (!TRANSPORT_isAuxReady(pInst->pTransport))
+    {
+        // Host not polling (yet) or previous record still in flight
+        pInst->dropCnt += 1U;
+        return 0U;
+    }
+
+    memset(&packet, 0, sizeof(packet));
+
+    packet.version = TELEMETRY_VERSION;
+    packet.seq = seq;
+    packet.timestampUs = pSample->timestampUs;
+    packet.rawX = sat16(pSample->raw.x);
+    packet.rawY = sat16(pSample->raw.y);
+    packet.filtX = sat16(pSample->filt.x);
+    packet.filtY = sat16(pSample->filt.y);
+    packet.mouseX = sat8(pSample->mouse.x);
+    packet.mouseY = sat8(pSample->mouse.y);
+    packet.acqNb = pSample->acqNb;
+    packet.logQueueDepth = LOGGER_getQueueDepth();
+    packet.logDropCnt = satU16(LOGGER_getDropCnt());
+    packet.telemDropCnt = satU16(pInst->dropCnt);
+    packet.predX = sat16(pSample->pred.x);
+    packet.predY = sat16(pSample->pred.y);
+    packet.cpuLoad = pSample->cpu.load;
+    packet.cpuTaskNb = pSample->cpu.taskNb;
+    packet.cpuTaskIdx = SYSMON_CPU_UNKNOWN;
+    packet.cpuTaskLoad = SYSMON_CPU_UNKNOWN;
+    if ((pSample->cpu.taskNb > 0U) && (pSample->cpu.taskNb <= SYSMON_TASK_NB_MAX))
+    {
+        packet.cpuTaskIdx = seq % pSample->cpu.taskNb;
+        packet.cpuTaskLoad = pSample->cpu.pTaskLoad[packet.cpuTaskIdx];
+        if (pSample->cpu.pTaskName[packet.cpuTaskIdx])
+        {
+            strncpy(packet.cpuTaskName, pSample->cpu.pTaskName[packet.cpuTaskIdx], sizeof(packet.cpuTaskName));
+        }
+    }
+
+    if (TRANSPORT_sendAux(pInst->pTransport, &packet, sizeof(packet)))
+    {
+        pInst->dropCnt += 1U;
+        return 0U;
+    }
+
+    return 0U;
+}
@@ -0,0 +1,89 @@
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <inttypes.h>
+
+#include "sysmon.h"
+#include "transport.h"
+#include "utils.h"
+
+// HID instance of the vendor telemetry interface, USB transport
+#define TELEMETRY_HID_ITF 1U
+
+// Telemetry input report length, in Bytes
+#define TELEMETRY_REPORT_LEN 48U
+
+#define TELEMETRY_VERSION 4U
+
+// configMAX_TASK_NAME_LEN default, NUL padded, not terminated when full
+#define TELEMETRY_TASK_NAME_LEN 16U
+
+/**
+ * @brief Telemetry record, sent as TELEMETRY_REPORT_LEN Bytes little endian input report
+ *
+ * Layout is decoded by tools/telemetry_decode.py, keep both in sync.
+ */
+typedef struct __attribute__((packed)) TelemetryPacket_t
+{
+    uint8_t version;
+    uint8_t seq;
+    // Report time, esp_timer low 32 bits
+    uint32_t timestampUs;
+    int16_t rawX;
+    int16_t rawY;
+    int16_t filtX;
+    int16_t filtY;
+    int8_t mouseX;
+    int8_t mouseY;
+    // Controller acquisitions behind this report
+    uint16_t acqNb;
+    uint16_t logQueueDepth;
+    // Saturated at UINT16_MAX
+    uint16_t logDropCnt;
+    uint16_t telemDropCnt;
+    // Predictive stage output, filt when disabled
+    int16_t predX;
+    int16_t predY;
+    // Percent, SYSMON_CPU_UNKNOWN until measured
+    uint8_t cpuLoad;
+    // One task per record, seq modulo cpuTaskNb, sysmon table order
+    uint8_t cpuTaskIdx;
+    uint8_t cpuTaskLoad;
+    uint8_t cpuTaskNb;
+    // Name of cpuTaskIdx, the decoder does not rely on the sysmon table order
+    char cpuTaskName[TELEMETRY_TASK_NAME_LEN];
+} TelemetryPacket_t;
+
+// Report cycle values, as seen by the mouse task
+typedef struct TelemetrySample_t
+{
+    uint32_t timestampUs;
+    Coord_t raw;
+    Coord_t filt;
+    Coord_t pred;
+    Coord_t mouse;
+    uint16_t acqNb;
+    SysmonCpu_t cpu;
+} TelemetrySample_t;
+
+typedef struct Telemetry_t
+{
+    uint32_t magic;
+    // Records go through the transport telemetry channel
+    Transport_t * pTransport;
+    // Send 1 record every period report cycles (0 : disabled, always without a telemetry channel)
+    uint16_t period;
+    uint16_t cycleCnt;
+    uint8_t seq;
+    // Records not sent, endpoint busy
+    uint32_t dropCnt;
+} Telemetry_t;
+
+Telemetry_t * TELEMETRY_init(Transport_t * pTransport, uint16_t period);
+
+void TELEMETRY_setPeriod(Telemetry_t * pInst, uint16_t period);
+
+uint8_t TELEMETRY_update(Telemetry_t * pInst, const TelemetrySample_t * pSample);
+
+#endif // TELEMETRY_H
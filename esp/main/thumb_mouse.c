@@ -11,10 +11,18 @@
 #include "freertos/semphr.h"
 #include "freertos/task.h"
 
+#include "bootprof.h"
 #include "config.h"
 #include "logger.h"
 #include "controller.h"
+#include "hw_profile.h"
 #include "mouse.h"
+#include "transport.h"
+#include "telemetry.h"
+#include "stream.h"
+#include "predict.h"
+#include "monitor.h"
+#include "sysmon.h"
 
 #define GPIO_NUM_BTN_BOOT GPIO_NUM_0
 
@@ -23,10 +31,30 @@ static const uint32_t MOUSE_MOVE_PERIOD_US = US_PER_S / MOUSE_REPORT_FREQ_HZ;
 // Initial mouse state
 static const uint8_t MOUSE_STATE_INIT = 0U;
 
+// Under configMAX_TASK_NAME_LEN, sysmon looks it up by name
+#define MOUSE_TASK_NAME "mouseFromCtrl"
+
+// Main loop period
+static const uint32_t MAIN_LOOP_PERIOD_MS = 100U;
+
 static SemaphoreHandle_t g_semMoveMouse = NULL;
 
+#if STATIC_ALLOC_EN
+static StaticSemaphore_t g_semMoveMouseBuf;
+static StaticTask_t g_taskMoveMouseBuf;
+static StackType_t g_pTaskMoveMouseStack[MOUSE_TASK_STACK_SIZE];
+#endif
+
 static Controller_t * g_pCtrl = NULL;
+static Transport_t * g_pTransport = NULL;
 static Mouse_t * g_pMouse = NULL;
+static Telemetry_t * g_pTelem = NULL;
+static Predict_t * g_pPredict = NULL;
+static Monitor_t * g_pMonitor = NULL;
+static Sysmon_t * g_pSysmon = NULL;
+#if STREAM_EN
+static Stream_t * g_pStream = NULL;
+#endif
 
 static void __attribute__((format (printf, 2, 3))) _log(LogLevel_e lvl, const char * sFmt, ...);
 
@@ -140,6 +168,53 @@ static void _log(LogLevel_e lvl, const char * sFmt, ...)
 //     _log(LOG_LVL_DEBUG, "acqNb = %u", acqNb);
 // }
 
+#if STREAM_EN
+// Mouse task, from CONTROLLER_getJoy
+static void streamSample(uint32_t timestampUs, const Coord_t * pRaw, void * pArg)
+{
+    if (STREAM_push((Stream_t *) pArg, timestampUs, pRaw))
+    {
+        _log(LOG_LVL_ERROR, "%s() STREAM_push FAILED", __func__);
+    }
+}
+#endif
+
+// Accumulated controller values to gamepad axis
+static int16_t gamepadAxis(int32_t acc, uint16_t acqNb, int32_t outMax)
+{
+    int64_t val = (int64_t) acc * MOUSE_GAMEPAD_AXIS_MAX / ((int64_t) acqNb * outMax);
+
+    if (val > MOUSE_GAMEPAD_AXIS_MAX)
+    {
+        return MOUSE_GAMEPAD_AXIS_MAX;
+    }
+
+    if (val < -MOUSE_GAMEPAD_AXIS_MAX)
+    {
+        return -MOUSE_GAMEPAD_AXIS_MAX;
+    }
+
+    return (int16_t) val;
+}
+
+// Controller value to absolute pointer position, 64 bits as predicted values are not range limited here
+static int32_t absAxis(int32_t val, int32_t outMin, int32_t outMax)
+{
+    int64_t pos = ((int64_t) val - outMin) * MOUSE_ABS_MAX / (outMax - outMin);
+
+    if (pos < MOUSE_ABS_MIN)
+    {
+        return MOUSE_ABS_MIN;
+    }
+
+    if (pos > MOUSE_ABS_MAX)
+    {
+        return MOUSE_ABS_MAX;
+    }
+
+    return (int32_t) pos;
+}
+
 static void moveMouseFromCtrlMain(void *)
 {
     uint8_t uRet = 0U;
@@ -153,8 +228,16 @@ static void moveMouseFromCtrlMain(void *)
     memset(&coordCtrlJoy, 0, sizeof(coordCtrlJoy));
     Coord_t coordCtrlJoyAcc;
     memset(&coordCtrlJoyAcc, 0, sizeof(coordCtrlJoyAcc));
+    Coord_t coordCtrlPred;
+    memset(&coordCtrlPred, 0, sizeof(coordCtrlPred));
+    int64_t cycleUs = 0;
+    int64_t cyclePrevUs = esp_timer_get_time();
     Coord_t coordMouse;
     memset(&coordMouse, 0, sizeof(coordMouse));
+    TelemetrySample_t telemSample;
+    memset(&telemSample, 0, sizeof(telemSample));
+    MouseStats_t mouseStats;
+    memset(&mouseStats, 0, sizeof(mouseStats));
 
     while (true)
     {
@@ -162,31 +245,36 @@ static void moveMouseFromCtrlMain(void *)
         baseRet = xQueueSemaphoreTake(g_semMoveMouse, 5U / portTICK_PERIOD_MS);
         if (baseRet && ctrlJoyAcqNb)
         {
-            coordMouse.x = 0;
-            coordMouse.y = 0;
+            MONITOR_cycleStart(g_pMonitor);
+            BOOTPROF_mark(BOOTPROF_STAGE_FIRST_CYCLE);
 
             coordCtrlJoy.x = coordCtrlJoyAcc.x / ctrlJoyAcqNb;
             coordCtrlJoy.y = coordCtrlJoyAcc.y / ctrlJoyAcqNb;
 
-            if (coordCtrlJoy.x < X_OUT_CENTER - DEADZONE)
-            {
-                coordMouse.x = - (X_OUT_CENTER - coordCtrlJoy.x - DEADZONE) / 3;
-            }
-            else if (coordCtrlJoy.x > X_OUT_CENTER + DEADZONE)
+            // Extrapolate to the report transmit time, pass through when disabled
+            cycleUs = esp_timer_get_time();
+            uRet = PREDICT_update(g_pPredict, &coordCtrlJoy, (uint32_t) (cycleUs - cyclePrevUs), &coordCtrlPred);
+            if (uRet)
             {
-                coordMouse.x = (coordCtrlJoy.x - X_OUT_CENTER - DEADZONE) / 3;
+                _log(LOG_LVL_ERROR, "%s() PREDICT_update FAILED", __func__);
+                coordCtrlPred = coordCtrlJoy;
             }
+            cyclePrevUs = cycleUs;
 
-            if (coordCtrlJoy.y < Y_OUT_CENTER - DEADZONE)
+            CONTROLLER_toMotion(&coordCtrlPred, &coordMouse);
+
+            if ((MOUSE_ABS_SRC == MOUSE_ABS_SRC_DEFLECTION) && (MOUSE_getMode(g_pMouse) == MOUSE_MODE_ABS))
             {
-                coordMouse.y = - (Y_OUT_CENTER - coordCtrlJoy.y - DEADZONE) / 3;
+                // Joystick deflection is the pointer position
+                uRet = MOUSE_moveAbs(g_pMouse,
+                    absAxis(coordCtrlPred.x, X_OUT_MIN, X_OUT_MAX),
+                    absAxis(coordCtrlPred.y, Y_OUT_MIN, Y_OUT_MAX));
             }
-            else if (coordCtrlJoy.y > Y_OUT_CENTER + DEADZONE)
+            else
             {
-                coordMouse.y = (coordCtrlJoy.y - Y_OUT_CENTER - DEADZONE) / 3;
+                // Report range handled by the mouse module, large moves are split
+                uRet = MOUSE_move(g_pMouse, coordMouse.x, coordMouse.y);
             }
-
-            uRet = MOUSE_move(g_pMouse, (int8_t) coordMouse.x, (int8_t) coordMouse.y);
             if (uRet)
             {
                 _log(LOG_LVL_ERROR, "%s() MOUSE_move FAILED", __func__);
@@ -194,14 +282,57 @@ static void moveMouseFromCtrlMain(void *)
                 continue;
             }
 
+            // Same acquisitions feed the gamepad, from the accumulator to keep averaging resolution
+            uRet = MOUSE_gamepad(g_pMouse,
+                gamepadAxis(coordCtrlJoyAcc.x, ctrlJoyAcqNb, X_OUT_MAX),
+                gamepadAxis(coordCtrlJoyAcc.y, ctrlJoyAcqNb, Y_OUT_MAX),
+                0x00);
+            if (uRet)
+            {
+                _log(LOG_LVL_ERROR, "%s() MOUSE_gamepad FAILED", __func__);
+            }
+
+            telemSample.timestampUs = (uint32_t) esp_timer_get_time();
+            CONTROLLER_getRaw(g_pCtrl, &telemSample.raw);
+            telemSample.filt = coordCtrlJoy;
+            telemSample.pred = coordCtrlPred;
+            telemSample.mouse = coordMouse;
+            telemSample.acqNb = ctrlJoyAcqNb;
+            // Created after this task starts
+            if (!g_pSysmon || SYSMON_getCpu(g_pSysmon, &telemSample.cpu))
+            {
+                // No task, no name pointer to follow
+                memset(&telemSample.cpu, 0, sizeof(telemSample.cpu));
+                telemSample.cpu.load = SYSMON_CPU_UNKNOWN;
+            }
+
+            uRet = TELEMETRY_update(g_pTelem, &telemSample);
+            if (uRet)
+            {
+                _log(LOG_LVL_ERROR, "%s() TELEMETRY_update FAILED", __func__);
+            }
+
             if ((MOUSE_LOG_LOOP_NB < 0xFF) && (loopCnt == MOUSE_LOG_LOOP_NB))
             {
                 _log(LOG_LVL_DEBUG, "joy.x  =  %04ld, joy.y  =  %04ld", coordCtrlJoy.x, coordCtrlJoy.y);
                 _log(LOG_LVL_DEBUG, "mouse.x = %04ld, mouse.y = %04ld", coordMouse.x, coordMouse.y);
                 _log(LOG_LVL_DEBUG, "acqNb = %u", ctrlJoyAcqNb);
+                if (!MOUSE_getStats(g_pMouse, &mouseStats))
+                {
+                    // Backlog : moveIn - moveOut, exact across total wraps
+                    _log(LOG_LVL_DEBUG, "mouse backlog x = %ld, y = %ld, clipped %lu, latency max %lu us",
+                        (int32_t) ((uint32_t) mouseStats.moveIn.x - (uint32_t) mouseStats.moveOut.x),
+                        (int32_t) ((uint32_t) mouseStats.moveIn.y - (uint32_t) mouseStats.moveOut.y),
+                        mouseStats.clipNb, mouseStats.latencyMaxUs);
+                    _log(LOG_LVL_DEBUG, "mouse reports %lu (%lu on completion, %lu completions busy), coalesced %lu, split %lu",
+                        mouseStats.reportNb, mouseStats.reportDoneNb, mouseStats.doneMissNb, mouseStats.coalescedNb,
+                        mouseStats.splitNb);
+                }
                 loopCnt = 0U;
             }
 
+            MONITOR_cycleEnd(g_pMonitor, ctrlJoyAcqNb);
+
             ctrlJoyAcqNb = 0U;
             coordCtrlJoyAcc.x = 0;
             coordCtrlJoyAcc.y = 0;
@@ -209,6 +340,9 @@ static void moveMouseFromCtrlMain(void *)
             loopCnt += 1U;
         }
 
+        // Motion merged while the transport was busy goes out as soon as it is ready again
+        MOUSE_flush(g_pMouse);
+
         uRet = CONTROLLER_getJoy(g_pCtrl, &coordCtrlJoy);
         if (uRet)
         {
@@ -217,9 +351,13 @@ static void moveMouseFromCtrlMain(void *)
             continue;
         }
 
-        ctrlJoyAcqNb += 1U;
-        coordCtrlJoyAcc.x += coordCtrlJoy.x;
-        coordCtrlJoyAcc.y += coordCtrlJoy.y;
+        // Report cycles stalled for long : average of the first acquisitions, no wrap to 0
+        if (ctrlJoyAcqNb < UINT16_MAX)
+        {
+            ctrlJoyAcqNb += 1U;
+            coordCtrlJoyAcc.x += coordCtrlJoy.x;
+            coordCtrlJoyAcc.y += coordCtrlJoy.y;
+        }
 
         // vTaskDelay(10U / portTICK_PERIOD_MS);
     }
@@ -235,19 +373,63 @@ static void timerCb(void * pArg)
         return;
     }
 
+    MONITOR_timerFired(g_pMonitor);
+
     ret = xSemaphoreGiveFromISR(g_semMoveMouse, NULL);
     if (ret != pdTRUE)
     {
+        // Previous firing not taken yet, this cycle is lost
+        MONITOR_timerMissed(g_pMonitor);
         _log(LOG_LVL_ERROR, "%s() xSemaphoreGive FAILED", __func__);
         return;
     }
 }
 
-void app_main(void)
+static void loggerStart(void)
 {
     uint8_t ret = 0U;
+
+    ret = LOGGER_init(LOG_LVL_DEBUG);
+    if (ret)
+    {
+        _log(LOG_LVL_ERROR, "%s() LOGGER_init FAILED", __func__);
+        UTILS_hang();
+    }
+
+    LOGGER_setLevel(MODULE_ID_MAIN, LOG_LVL_DEBUG);
+    BOOTPROF_mark(BOOTPROF_STAGE_LOGGER);
+}
+
+// Transport and mouse, starts USB enumeration
+static void hidStart(void)
+{
+    _log(LOG_LVL_DEBUG, "%s() TRANSPORT_init", __func__);
+    g_pTransport = TRANSPORT_init(TRANSPORT_DFLT);
+    if (!g_pTransport)
+    {
+        _log(LOG_LVL_ERROR, "%s() TRANSPORT_init FAILED", __func__);
+        UTILS_hang();
+    }
+    BOOTPROF_mark(BOOTPROF_STAGE_TRANSPORT);
+
+    _log(LOG_LVL_DEBUG, "%s() MOUSE_init", __func__);
+    g_pMouse = MOUSE_init(g_pTransport, MOUSE_STATE_INIT, MOUSE_PERSONALITY_DFLT);
+    if (!g_pMouse)
+    {
+        _log(LOG_LVL_ERROR, "%s() MOUSE_init FAILED", __func__);
+        UTILS_hang();
+    }
+    BOOTPROF_mark(BOOTPROF_STAGE_MOUSE);
+}
+
+void app_main(void)
+{
     esp_err_t espRet = ESP_OK;
     int btnBootVal = 0;
+    uint32_t btnBootHoldMs = 0U;
+    uint32_t bootLogMs = 0U;
+    // 0 : not logged, 1 : partial, 2 : complete
+    uint8_t bootLogState = 0U;
 
     const gpio_config_t gpioConfBtnBoot =
     {
@@ -258,19 +440,27 @@ void app_main(void)
         .pull_down_en = true,
     };
 
+    const PredictParams_t predictParams =
+    {
+        .bEn = PREDICT_EN_DFLT,
+        .alpha = PREDICT_ALPHA_DFLT,
+        .beta = PREDICT_BETA_DFLT,
+        .leadUs = PREDICT_LEAD_US,
+    };
+
     esp_timer_handle_t timerMouse = NULL;
     esp_timer_create_args_t timerArg;
     memset(&timerArg, 0, sizeof(timerArg));
     TaskHandle_t task = NULL;
 
-    ret = LOGGER_init(LOG_LVL_DEBUG);
-    if (ret)
-    {
-        _log(LOG_LVL_ERROR, "%s() LOGGER_init FAILED", __func__);
-        UTILS_hang();
-    }
+    BOOTPROF_init();
 
-    LOGGER_setLevel(MODULE_ID_MAIN, LOG_LVL_DEBUG);
+#if FAST_BOOT_EN
+    // Host enumerates in the TinyUSB task while the rest initializes, logger last
+    hidStart();
+#else
+    loggerStart();
+#endif
 
     espRet = gpio_config(&gpioConfBtnBoot);
     if (espRet != ESP_OK)
@@ -278,24 +468,72 @@ void app_main(void)
         _log(LOG_LVL_ERROR, "%s() gpio_config FAILED", __func__);
         UTILS_hang();
     }
+    BOOTPROF_mark(BOOTPROF_STAGE_GPIO);
 
     _log(LOG_LVL_DEBUG, "%s() CONTROLLER_init", __func__);
-    g_pCtrl = CONTROLLER_init();
+    g_pCtrl = CONTROLLER_init(HW_PROFILE_get(HW_PROFILE_select()));
     if (!g_pCtrl)
     {
         _log(LOG_LVL_ERROR, "%s() CONTROLLER_init FAILED", __func__);
         UTILS_hang();
     }
+    BOOTPROF_mark(BOOTPROF_STAGE_CTRL);
 
-    _log(LOG_LVL_DEBUG, "%s() MOUSE_init", __func__);
-    g_pMouse = MOUSE_init(MOUSE_STATE_INIT);
-    if (!g_pMouse)
+#if !FAST_BOOT_EN
+    hidStart();
+#endif
+
+    _log(LOG_LVL_DEBUG, "%s() TELEMETRY_init", __func__);
+    g_pTelem = TELEMETRY_init(g_pTransport, TELEMETRY_PERIOD_DFLT);
+    if (!g_pTelem)
     {
-        _log(LOG_LVL_ERROR, "%s() MOUSE_init FAILED", __func__);
+        _log(LOG_LVL_ERROR, "%s() TELEMETRY_init FAILED", __func__);
+        UTILS_hang();
+    }
+    BOOTPROF_mark(BOOTPROF_STAGE_TELEM);
+
+    _log(LOG_LVL_DEBUG, "%s() MONITOR_init", __func__);
+    g_pMonitor = MONITOR_init(MOUSE_MOVE_PERIOD_US, MONITOR_OVERRUN_TOL_US);
+    if (!g_pMonitor)
+    {
+        _log(LOG_LVL_ERROR, "%s() MONITOR_init FAILED", __func__);
+        UTILS_hang();
+    }
+    MONITOR_armCapture(g_pMonitor, MONITOR_CAPTURE_TH_US);
+    BOOTPROF_mark(BOOTPROF_STAGE_MONITOR);
+
+    _log(LOG_LVL_DEBUG, "%s() PREDICT_init", __func__);
+    g_pPredict = PREDICT_init(&predictParams, X_OUT_MIN, X_OUT_MAX);
+    if (!g_pPredict)
+    {
+        _log(LOG_LVL_ERROR, "%s() PREDICT_init FAILED", __func__);
+        UTILS_hang();
+    }
+    BOOTPROF_mark(BOOTPROF_STAGE_PREDICT);
+
+#if STREAM_EN
+    _log(LOG_LVL_DEBUG, "%s() STREAM_init", __func__);
+    g_pStream = STREAM_init();
+    if (!g_pStream)
+    {
+        _log(LOG_LVL_ERROR, "%s() STREAM_init FAILED", __func__);
+        UTILS_hang();
+    }
+
+    // Every ADC acquisition, at the full sampling rate
+    if (CONTROLLER_setSampleCb(g_pCtrl, streamSample, g_pStream))
+    {
+        _log(LOG_LVL_ERROR, "%s() CONTROLLER_setSampleCb FAILED", __func__);
         UTILS_hang();
     }
+    BOOTPROF_mark(BOOTPROF_STAGE_STREAM);
+#endif
 
+#if STATIC_ALLOC_EN
+    g_semMoveMouse = xSemaphoreCreateBinaryStatic(&g_semMoveMouseBuf);
+#else
     g_semMoveMouse = xSemaphoreCreateBinary();
+#endif
     if (!g_semMoveMouse)
     {
         _log(LOG_LVL_ERROR, "%s() xSemaphoreCreateBinary FAILED", __func__);
@@ -303,12 +541,18 @@ void app_main(void)
     }
 
     _log(LOG_LVL_DEBUG, "%s() Create moveMouseFromCtrl task", __func__);
-    xTaskCreate(moveMouseFromCtrlMain, "moveMouseFromCtrl", 0x1000U, NULL, configMAX_PRIORITIES - 5U, &task);
+#if STATIC_ALLOC_EN
+    task = xTaskCreateStatic(moveMouseFromCtrlMain, MOUSE_TASK_NAME, MOUSE_TASK_STACK_SIZE, NULL, configMAX_PRIORITIES - 5U,
+        g_pTaskMoveMouseStack, &g_taskMoveMouseBuf);
+#else
+    xTaskCreate(moveMouseFromCtrlMain, MOUSE_TASK_NAME, MOUSE_TASK_STACK_SIZE, NULL, configMAX_PRIORITIES - 5U, &task);
+#endif
     if (!task)
     {
         _log(LOG_LVL_ERROR, "%s() xTaskCreate FAILED", __func__);
         UTILS_hang();
     }
+    BOOTPROF_mark(BOOTPROF_STAGE_TASK);
 
     timerArg.callback = &timerCb;
     timerArg.arg = NULL;
@@ -328,6 +572,23 @@ void app_main(void)
         UTILS_hang();
     }
 
+#if FAST_BOOT_EN
+    loggerStart();
+#endif
+    BOOTPROF_mark(BOOTPROF_STAGE_INIT_DONE);
+
+    // Last, nothing should allocate from here on
+    _log(LOG_LVL_DEBUG, "%s() SYSMON_init", __func__);
+    g_pSysmon = SYSMON_init(SYSMON_LOG_PERIOD_MS, SYSMON_CPU_PERIOD_MS);
+    if (!g_pSysmon)
+    {
+        _log(LOG_LVL_ERROR, "%s() SYSMON_init FAILED", __func__);
+        UTILS_hang();
+    }
+    SYSMON_addTask(g_pSysmon, "loggerMain", LOGGER_TASK_STACK_SIZE);
+    SYSMON_addTask(g_pSysmon, MOUSE_TASK_NAME, MOUSE_TASK_STACK_SIZE);
+    SYSMON_log(g_pSysmon);
+
     _log(LOG_LVL_DEBUG, "%s() Loop start", __func__);
     while (true)
     {
@@ -339,12 +600,51 @@ void app_main(void)
             if (btnBootVal)
             {
                 // Boot button state is ON
+                btnBootHoldMs = 0U;
+            }
+            else if (btnBootHoldMs < MODE_SWITCH_PRESS_MS)
+            {
+                // Boot button short press released
 
                 // Mouse state change
                 MOUSE_setEnabled(g_pMouse, 1U - MOUSE_getEnabled(g_pMouse));
             }
         }
+        else if (btnBootVal && (btnBootHoldMs < MODE_SWITCH_PRESS_MS))
+        {
+            btnBootHoldMs += MAIN_LOOP_PERIOD_MS;
+
+            if (btnBootHoldMs >= MODE_SWITCH_PRESS_MS)
+            {
+                // Boot button long press
+
+                // Mouse mode change
+                if (MOUSE_getMode(g_pMouse) == MOUSE_MODE_ABS)
+                {
+                    MOUSE_setMode(g_pMouse, MOUSE_MODE_REL);
+                }
+                else
+                {
+                    MOUSE_setMode(g_pMouse, MOUSE_MODE_ABS);
+                }
+            }
+        }
+
+        SYSMON_tick(g_pSysmon, MAIN_LOOP_PERIOD_MS);
+
+        // Boot timings at the first report, what is reached so far on timeout, complete once it comes
+        bootLogMs += MAIN_LOOP_PERIOD_MS;
+        if ((bootLogState < 2U) && BOOTPROF_isMarked(BOOTPROF_STAGE_FIRST_REPORT))
+        {
+            BOOTPROF_log();
+            bootLogState = 2U;
+        }
+        else if ((bootLogState == 0U) && (bootLogMs >= BOOTPROF_LOG_TIMEOUT_MS))
+        {
+            BOOTPROF_log();
+            bootLogState = 1U;
+        }
 
-        vTaskDelay(100U / portTICK_PERIOD_MS);
+        vTaskDelay(MAIN_LOOP_PERIOD_MS / portTICK_PERIOD_MS);
     }
 }
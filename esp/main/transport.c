@@ -0,0 +1,210 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bootprof.h"
+#include "logger.h"
+#include "utils.h"
+
+#include "transport.h"
+
+static const uint32_t MAGIC = 561348;
+
+UTILS_INST_POOL(Transport_t, 1);
+
+static const TransportOps_t * OPS_LIST[TRANSPORT_ID_NB] =
+{
+    &TRANSPORT_OPS_USB,
+    &TRANSPORT_OPS_BLE,
+    &TRANSPORT_OPS_LOOPBACK,
+};
+
+static void __attribute__((format (printf, 2, 3))) _log(LogLevel_e lvl, const char * sFmt, ...);
+
+static void _log(LogLevel_e lvl, const char * sFmt, ...)
+{
+    va_list pArg;
+
+    va_start(pArg, sFmt);
+    LOGGER_log_va(MODULE_ID_TRANSPORT, lvl, sFmt, pArg);
+    va_end(pArg);
+}
+
+Transport_t * TRANSPORT_init(TransportId_e id)
+{
+    Transport_t * pInst = NULL;
+
+    LOGGER_setLevel(MODULE_ID_TRANSPORT, LOG_LVL_DEBUG);
+
+    _log(LOG_LVL_DEBUG, "%s()", __func__);
+
+    if (id >= TRANSPORT_ID_NB)
+    {
+        _log(LOG_LVL_ERROR, "%s() id out of range (%u >= %u)", __func__, id, TRANSPORT_ID_NB);
+        return NULL;
+    }
+
+    pInst = UTILS_INST_ALLOC(Transport_t);
+    if (!pInst)
+    {
+        _log(LOG_LVL_ERROR, "%s() Alloc %u Bytes for Transport_t FAILED", __func__, sizeof(Transport_t));
+        return NULL;
+    }
+
+    pInst->magic = MAGIC;
+    pInst->id = id;
+    pInst->pOps = OPS_LIST[id];
+
+    _log(LOG_LVL_INFO, "Transport %s", pInst->pOps->sName);
+
+    return pInst;
+}
+
+uint8_t TRANSPORT_start(Transport_t * pInst, const TransportConf_t * pConf)
+{
+    uint8_t uRet = 0U;
+
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return 1U;
+    }
+
+    if (!pConf || !pConf->pReportDesc)
+    {
+        _log(LOG_LVL_ERROR, "%s() pConf NULL", __func__);
+        return 1U;
+    }
+
+    uRet = pInst->pOps->start(pConf);
+    if (uRet)
+    {
+        _log(LOG_LVL_ERROR, "%s() %s start FAILED", __func__, pInst->pOps->sName);
+        return 1U;
+    }
+
+    return 0U;
+}
+
+uint8_t TRANSPORT_setReportDesc(Transport_t * pInst, const uint8_t * pDesc, uint16_t len)
+{
+    uint8_t uRet = 0U;
+
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return 1U;
+    }
+
+    if (!pDesc)
+    {
+        _log(LOG_LVL_ERROR, "%s() pDesc NULL", __func__);
+        return 1U;
+    }
+
+    uRet = pInst->pOps->setReportDesc(pDesc, len);
+    if (uRet)
+    {
+        _log(LOG_LVL_ERROR, "%s() %s setReportDesc FAILED", __func__, pInst->pOps->sName);
+        return 1U;
+    }
+
+    return 0U;
+}
+
+uint8_t TRANSPORT_isReady(Transport_t * pInst)
+{
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return 0U;
+    }
+
+    return pInst->pOps->isReady();
+}
+
+uint8_t TRANSPORT_send(Transport_t * pInst, uint8_t reportId, const void * pReport, uint16_t len)
+{
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return 1U;
+    }
+
+    if (!pReport)
+    {
+        _log(LOG_LVL_ERROR, "%s() pReport NULL", __func__);
+        return 1U;
+    }
+
+    if (pInst->pOps->send(reportId, pReport, len))
+    {
+        return 1U;
+    }
+
+    BOOTPROF_mark(BOOTPROF_STAGE_FIRST_REPORT);
+
+    return 0U;
+}
+
+uint32_t TRANSPORT_getIntervalUs(Transport_t * pInst)
+{
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return 0U;
+    }
+
+    return pInst->pOps->getIntervalUs();
+}
+
+uint8_t TRANSPORT_hasAux(Transport_t * pInst)
+{
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return 0U;
+    }
+
+    return (pInst->pOps->isAuxReady != NULL) && (pInst->pOps->sendAux != NULL);
+}
+
+uint8_t TRANSPORT_isAuxReady(Transport_t * pInst)
+{
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return 0U;
+    }
+
+    if (!pInst->pOps->isAuxReady)
+    {
+        return 0U;
+    }
+
+    return pInst->pOps->isAuxReady();
+}
+
+uint8_t TRANSPORT_sendAux(Transport_t * pInst, const void * pReport, uint16_t len)
+{
+    if (!pInst || pInst->magic != MAGIC)
+    {
+        _log(LOG_LVL_ERROR, "%s() Bad instance pointer", __func__);
+        return 1U;
+    }
+
+    if (!pReport)
+    {
+        _log(LOG_LVL_ERROR, "%s() pReport NULL", __func__);
+        return 1U;
+    }
+
+    if (!pInst->pOps->sendAux)
+    {
+        _log(LOG_LVL_ERROR, "%s() %s has no telemetry channel", __func__, pInst->pOps->sName);
+        return 1U;
+    }
+
+    return pInst->pOps->sendAux(pReport, len);
+}
@@ -0,0 +1,81 @@
+
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <inttypes.h>
+
+typedef enum TransportId_e
+{
+    TRANSPORT_ID_USB = 0,
+    TRANSPORT_ID_BLE,
+    // Reports are counted and dropped, for bench runs without a host
+    TRANSPORT_ID_LOOPBACK,
+    TRANSPORT_ID_NB,
+} TransportId_e;
+
+typedef struct TransportConf_t
+{
+    const uint8_t * pReportDesc;
+    uint16_t reportDescLen;
+    // Feature reports, called from the transport stack context
+    uint16_t (*getFeature)(uint8_t reportId, uint8_t * pBuf, uint16_t len);
+    void (*setFeature)(uint8_t reportId, const uint8_t * pBuf, uint16_t len);
+    // Previous report delivered, next one can go, called from the transport stack context (NULL : none)
+    void (*sendDone)(void);
+    // Host gone or enumerating again, state set by the host is lost, called from the transport stack context (NULL : none)
+    void (*hostReset)(void);
+} TransportConf_t;
+
+/**
+ * @brief Transport backend
+ *
+ * Backends are single instance, state lives in the backend file.
+ * Every function returns 0 on success, except isReady, isAuxReady and getIntervalUs.
+ */
+typedef struct TransportOps_t
+{
+    const char * sName;
+    uint8_t (*start)(const TransportConf_t * pConf);
+    // Report descriptor change, re-enumerates when supported
+    uint8_t (*setReportDesc)(const uint8_t * pDesc, uint16_t len);
+    // Report can be sent now
+    uint8_t (*isReady)(void);
+    uint8_t (*send)(uint8_t reportId, const void * pReport, uint16_t len);
+    // Minimum time between reports (BLE connection interval), 0 : none
+    uint32_t (*getIntervalUs)(void);
+    // Telemetry channel beside the reports (USB vendor HID interface), NULL : backend has none
+    uint8_t (*isAuxReady)(void);
+    uint8_t (*sendAux)(const void * pReport, uint16_t len);
+} TransportOps_t;
+
+extern const TransportOps_t TRANSPORT_OPS_USB;
+extern const TransportOps_t TRANSPORT_OPS_BLE;
+extern const TransportOps_t TRANSPORT_OPS_LOOPBACK;
+
+typedef struct Transport_t
+{
+    uint32_t magic;
+    TransportId_e id;
+    const TransportOps_t * pOps;
+} Transport_t;
+
+Transport_t * TRANSPORT_init(TransportId_e id);
+
+uint8_t TRANSPORT_start(Transport_t * pInst, const TransportConf_t * pConf);
+
+uint8_t TRANSPORT_setReportDesc(Transport_t * pInst, const uint8_t * pDesc, uint16_t len);
+
+uint8_t TRANSPORT_isReady(Transport_t * pInst);
+
+uint8_t TRANSPORT_send(Transport_t * pInst, uint8_t reportId, const void * pReport, uint16_t len);
+
+uint32_t TRANSPORT_getIntervalUs(Transport_t * pInst);
+
+// Telemetry channel, only some backends have one
+uint8_t TRANSPORT_hasAux(Transport_t * pInst);
+
+uint8_t TRANSPORT_isAuxReady(Transport_t * pInst);
+
+uint8_t TRANSPORT_sendAux(Transport_t * pInst, const void * pReport, uint16_t len);
+
+#endif // TRANSPORT_H
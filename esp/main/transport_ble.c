@@ -0,0 +1,301 @@
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "sdkconfig.h"
+
+#include "config.h"
+#include "logger.h"
+
+#include "transport.h"
+
+static void __attribute__((format (printf, 2, 3))) _log(LogLevel_e lvl, const char * sFmt, ...);
+
+static void _log(LogLevel_e lvl, const char * sFmt, ...)
+{
+    va_list pArg;
+
+    va_start(pArg, sFmt);
+    LOGGER_log_va(MODULE_ID_TRANSPORT, lvl, sFmt, pArg);
+    va_end(pArg);
+}
+
+#if CONFIG_BT_BLE_ENABLED
+
+#include "esp_bt.h"
+#include "esp_bt_main.h"
+#include "esp_gap_ble_api.h"
+#include "esp_gatts_api.h"
+#include "esp_hidd.h"
+#include "esp_hidd_gatts.h"
+#include "nvs_flash.h"
+
+// BLE connection interval unit
+#define CONN_INT_UNIT_US 1250U
+
+static const uint16_t HID_SERVICE_UUID = 0x1812;
+
+static esp_ble_adv_params_t g_advParams =
+{
+    .adv_int_min = 0x20,
+    .adv_int_max = 0x30,
+    .adv_type = ADV_TYPE_IND,
+    .own_addr_type = BLE_ADDR_TYPE_PUBLIC,
+    .channel_map = ADV_CHNL_ALL,
+    .adv_filter_policy = ADV_FILTER_ALLOW_SCAN_ANY_CON_ANY,
+};
+
+static esp_hid_raw_report_map_t g_reportMap;
+
+static esp_hid_device_config_t g_hidConf =
+{
+    .vendor_id = 0x303A,
+    .product_id = 0x8000,
+    .version = 0x0100,
+    .device_name = BLE_DEVICE_NAME,
+    .manufacturer_name = "TinyUSB",
+    .serial_number = "123456",
+    .report_maps = &g_reportMap,
+    .report_maps_len = 1,
+};
+
+static TransportConf_t g_conf;
+static esp_hidd_dev_t * g_pDev = NULL;
+static volatile uint8_t g_bConnected = 0U;
+// Negotiated connection interval, reports are merged in between
+static volatile uint32_t g_intervalUs = BLE_CONN_INTERVAL_DFLT_US;
+
+static void advStart(void)
+{
+    esp_err_t espRet = esp_ble_gap_start_advertising(&g_advParams);
+    if (espRet != ESP_OK)
+    {
+        _log(LOG_LVL_ERROR, "%s() esp_ble_gap_start_advertising FAILED", __func__);
+    }
+}
+
+static void gapCb(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t * pParam)
+{
+    switch (event)
+    {
+        case ESP_GAP_BLE_ADV_DATA_SET_COMPLETE_EVT:
+            advStart();
+            break;
+
+        case ESP_GAP_BLE_SEC_REQ_EVT:
+            esp_ble_gap_security_rsp(pParam->ble_security.ble_req.bd_addr, true);
+            break;
+
+        case ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT:
+            g_intervalUs = (uint32_t) pParam->update_conn_params.conn_int * CONN_INT_UNIT_US;
+            _log(LOG_LVL_INFO, "Connection interval %" PRIu32 " us", g_intervalUs);
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void hiddCb(void * pHandlerArg, esp_event_base_t base, int32_t id, void * pEventData)
+{
+    esp_hidd_event_data_t * pParam = (esp_hidd_event_data_t *) pEventData;
+
+    (void) pHandlerArg;
+    (void) base;
+
+    switch ((esp_hidd_event_t) id)
+    {
+        case ESP_HIDD_START_EVENT:
+            advStart();
+            break;
+
+        case ESP_HIDD_CONNECT_EVENT:
+            _log(LOG_LVL_INFO, "Connected");
+            g_intervalUs = BLE_CONN_INTERVAL_DFLT_US;
+            g_bConnected = 1U;
+            break;
+
+        case ESP_HIDD_DISCONNECT_EVENT:
+            _log(LOG_LVL_INFO, "Disconnected");
+            g_bConnected = 0U;
+            if (g_conf.hostReset)
+            {
+                g_conf.hostReset();
+            }
+            advStart();
+            break;
+
+        case ESP_HIDD_FEATURE_EVENT:
+            if (g_conf.setFeature)
+            {
+                g_conf.setFeature(pParam->feature.report_id, pParam->feature.data, pParam->feature.length);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+static uint8_t start(const TransportConf_t * pConf)
+{
+    esp_err_t espRet = ESP_OK;
+    esp_bt_controller_config_t btConf = BT_CONTROLLER_INIT_CONFIG_DEFAULT();
+    esp_ble_auth_req_t authReq = ESP_LE_AUTH_BOND;
+    esp_ble_io_cap_t ioCap = ESP_IO_CAP_NONE;
+    uint8_t keyMask = ESP_BLE_ENC_KEY_MASK | ESP_BLE_ID_KEY_MASK;
+    uint16_t appearance = ESP_HID_APPEARANCE_MOUSE;
+
+    esp_ble_adv_data_t advData =
+    {
+        .set_scan_rsp = false,
+        .include_name = true,
+        .include_txpower = true,
+        .min_interval = 0x0006,
+        .max_interval = 0x0010,
+        .appearance = appearance,
+        .service_uuid_len = sizeof(HID_SERVICE_UUID),
+        .p_service_uuid = (uint8_t *) &HID_SERVICE_UUID,
+        .flag = ESP_BLE_ADV_FLAG_GEN_DISC | ESP_BLE_ADV_FLAG_BREDR_NOT_SPT,
+    };
+
+    g_conf = *pConf;
+    g_reportMap.data = g_conf.pReportDesc;
+    g_reportMap.len = g_conf.reportDescLen;
+
+    // Bonding keys
+    espRet = nvs_flash_init();
+    if ((espRet == ESP_ERR_NVS_NO_FREE_PAGES) || (espRet == ESP_ERR_NVS_NEW_VERSION_FOUND))
+    {
+        nvs_flash_erase();
+        espRet = nvs_flash_init();
+    }
+    if (espRet != ESP_OK)
+    {
+        _log(LOG_LVL_ERROR, "%s() nvs_flash_init FAILED", __func__);
+        return 1U;
+    }
+
+    _log(LOG_LVL_DEBUG, "%s() Init BLE", __func__);
+
+    esp_bt_controller_mem_release(ESP_BT_MODE_CLASSIC_BT);
+
+    if ((esp_bt_controller_init(&btConf) != ESP_OK)
+        || (esp_bt_controller_enable(ESP_BT_MODE_BLE) != ESP_OK)
+        || (esp_bluedroid_init() != ESP_OK)
+        || (esp_bluedroid_enable() != ESP_OK))
+    {
+        _log(LOG_LVL_ERROR, "%s() BT stack init FAILED", __func__);
+        return 1U;
+    }
+
+    esp_ble_gap_set_security_param(ESP_BLE_SM_AUTHEN_REQ_MODE, &authReq, sizeof(authReq));
+    esp_ble_gap_set_security_param(ESP_BLE_SM_IOCAP_MODE, &ioCap, sizeof(ioCap));
+    esp_ble_gap_set_security_param(ESP_BLE_SM_SET_INIT_KEY, &keyMask, sizeof(keyMask));
+    esp_ble_gap_set_security_param(ESP_BLE_SM_SET_RSP_KEY, &keyMask, sizeof(keyMask));
+
+    if ((esp_ble_gap_register_callback(gapCb) != ESP_OK)
+        || (esp_ble_gatts_register_callback(esp_hidd_gatts_event_handler) != ESP_OK))
+    {
+        _log(LOG_LVL_ERROR, "%s() BLE callbacks registration FAILED", __func__);
+        return 1U;
+    }
+
+    esp_ble_gap_set_device_name(BLE_DEVICE_NAME);
+    esp_ble_gap_config_adv_data(&advData);
+
+    espRet = esp_hidd_dev_init(&g_hidConf, ESP_HID_TRANSPORT_BLE, hiddCb, &g_pDev);
+    if (espRet != ESP_OK)
+    {
+        _log(LOG_LVL_ERROR, "%s() esp_hidd_dev_init FAILED", __func__);
+        return 1U;
+    }
+
+    return 0U;
+}
+
+static uint8_t setReportDesc(const uint8_t * pDesc, uint16_t len)
+{
+    (void) pDesc;
+    (void) len;
+
+    // Report map is part of the bonded GATT database, peers would need to pair again
+    _log(LOG_LVL_ERROR, "%s() Not supported over BLE", __func__);
+
+    return 1U;
+}
+
+static uint8_t isReady(void)
+{
+    return g_bConnected;
+}
+
+static uint8_t send(uint8_t reportId, const void * pReport, uint16_t len)
+{
+    esp_err_t espRet = esp_hidd_dev_input_set(g_pDev, 0U, reportId, (uint8_t *) pReport, len);
+    if (espRet != ESP_OK)
+    {
+        return 1U;
+    }
+
+    return 0U;
+}
+
+static uint32_t getIntervalUs(void)
+{
+    return g_intervalUs;
+}
+
+#else // CONFIG_BT_BLE_ENABLED
+
+static uint8_t start(const TransportConf_t * pConf)
+{
+    (void) pConf;
+
+    _log(LOG_LVL_ERROR, "%s() BLE not enabled (CONFIG_BT_BLE_ENABLED) or not supported by target", __func__);
+
+    return 1U;
+}
+
+static uint8_t setReportDesc(const uint8_t * pDesc, uint16_t len)
+{
+    (void) pDesc;
+    (void) len;
+
+    return 1U;
+}
+
+static uint8_t isReady(void)
+{
+    return 0U;
+}
+
+static uint8_t send(uint8_t reportId, const void * pReport, uint16_t len)
+{
+    (void) reportId;
+    (void) pReport;
+    (void) len;
+
+    return 1U;
+}
+
+static uint32_t getIntervalUs(void)
+{
+    return 0U;
+}
+
+#endif // CONFIG_BT_BLE_ENABLED
+
+const TransportOps_t TRANSPORT_OPS_BLE =
+{
+    .sName = "ble",
+    .start = start,
+    .setReportDesc = setReportDesc,
+    .isReady = isReady,
+    .send = send,
+    .getIntervalUs = getIntervalUs,
+    // No telemetry channel
+    .isAuxReady = NULL,
+    .sendAux = NULL,
+};
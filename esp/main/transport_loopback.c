@@ -0,0 +1,64 @@
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#include "esp_timer.h"
+
+#include "config.h"
+
+#include "transport.h"
+
+// Last report "sent", reports are dropped
+static int64_t g_lastSendUs = 0;
+
+static uint8_t start(const TransportConf_t * pConf)
+{
+    (void) pConf;
+
+    g_lastSendUs = 0;
+
+    return 0U;
+}
+
+static uint8_t setReportDesc(const uint8_t * pDesc, uint16_t len)
+{
+    (void) pDesc;
+    (void) len;
+
+    return 0U;
+}
+
+static uint8_t isReady(void)
+{
+    // Busy until the simulated connection event
+    return (esp_timer_get_time() - g_lastSendUs) >= TRANSPORT_LOOPBACK_INTERVAL_US;
+}
+
+static uint8_t send(uint8_t reportId, const void * pReport, uint16_t len)
+{
+    (void) reportId;
+    (void) pReport;
+    (void) len;
+
+    g_lastSendUs = esp_timer_get_time();
+
+    return 0U;
+}
+
+static uint32_t getIntervalUs(void)
+{
+    return TRANSPORT_LOOPBACK_INTERVAL_US;
+}
+
+const TransportOps_t TRANSPORT_OPS_LOOPBACK =
+{
+    .sName = "loopback",
+    .start = start,
+    .setReportDesc = setReportDesc,
+    .isReady = isReady,
+    .send = send,
+    .getIntervalUs = getIntervalUs,
+    // No telemetry channel
+    .isAuxReady = NULL,
+    .sendAux = NULL,
+};
@@ -0,0 +1,294 @@
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "tinyusb.h"
+#include "class/hid/hid_device.h"
+
+#include "bootprof.h"
+#include "config.h"
+#include "logger.h"
+#include "telemetry.h"
+
+#include "transport.h"
+
+/************* TinyUSB descriptors ****************/
+
+#define TUSB_DESC_TOTAL_LEN      (TUD_CONFIG_DESC_LEN + CFG_TUD_HID * TUD_HID_DESC_LEN + STREAM_EN * TUD_CDC_DESC_LEN)
+
+#define HID_ITF_MOUSE 0U
+
+// Raw stream CDC-ACM interfaces (communication and data) follow the HID ones
+#define ITF_NUM_CDC   CFG_TUD_HID
+#define ITF_NUM_TOTAL (CFG_TUD_HID + 2U * STREAM_EN)
+
+#define CDC_EP_SIZE 64U
+
+// Vendor usage page for the telemetry interface
+#define HID_USAGE_PAGE_TELEMETRY 0xFF00
+#define HID_USAGE_TELEMETRY      0x01
+
+// Time left to the host to notice a disconnection, on descriptor change
+#define RECONNECT_DELAY_MS 100U
+
+/**
+ * @brief Telemetry report descriptor
+ *
+ * Vendor defined, TELEMETRY_REPORT_LEN Bytes input report without report ID
+ */
+const uint8_t hid_telemetry_report_descriptor[] = {
+    HID_USAGE_PAGE_N   ( HID_USAGE_PAGE_TELEMETRY, 2              ) ,
+    HID_USAGE          ( HID_USAGE_TELEMETRY                      ) ,
+    HID_COLLECTION     ( HID_COLLECTION_APPLICATION               ) ,
+        HID_USAGE          ( HID_USAGE_TELEMETRY                      ) ,
+        HID_LOGICAL_MIN    ( 0x00                                     ) ,
+        HID_LOGICAL_MAX_N  ( 0xff, 2                                  ) ,
+        HID_REPORT_SIZE    ( 8                                        ) ,
+        HID_REPORT_COUNT   ( TELEMETRY_REPORT_LEN                     ) ,
+        HID_INPUT          ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE   ) ,
+    HID_COLLECTION_END
+};
+
+/**
+ * @brief String descriptor
+ */
+const char* hid_string_descriptor[7] = {
+    // array of pointer to string descriptors
+    (char[]){0x09, 0x04},  // 0: is supported language is English (0x0409)
+    "TinyUSB",             // 1: Manufacturer
+    "TinyUSB Device",      // 2: Product
+    "123456",              // 3: Serials, should use chip ID
+    "Example HID interface",  // 4: HID
+    "Telemetry interface",    // 5: Telemetry HID
+    "Raw stream interface",   // 6: Raw stream CDC
+};
+
+/**
+ * @brief Configuration descriptor
+ *
+ * 1 configuration, mouse HID interface and telemetry HID interface (CFG_TUD_HID = 2),
+ * raw stream CDC-ACM interface when STREAM_EN.
+ * Only the mouse interface report descriptor length is not known at build time.
+ */
+#define HID_CONFIGURATION_DESCRIPTOR(reportDescLen) \
+    /* Configuration number, interface count, string index, total length, attribute, power in mA */ \
+    TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, TUSB_DESC_TOTAL_LEN, TUSB_DESC_CONFIG_ATT_REMOTE_WAKEUP, 100), \
+    /* Interface number, string index, boot protocol, report descriptor len, EP In address, size & polling interval */ \
+    TUD_HID_DESCRIPTOR(HID_ITF_MOUSE, 4, false, reportDescLen, 0x81, 16, 10), \
+    TUD_HID_DESCRIPTOR(TELEMETRY_HID_ITF, 5, false, sizeof(hid_telemetry_report_descriptor), 0x82, TELEMETRY_REPORT_LEN, 1)
+
+#define CDC_CONFIGURATION_DESCRIPTOR \
+    /* Interface number, string index, EP notification address and size, EP data address (out, in) and size */ \
+    TUD_CDC_DESCRIPTOR(ITF_NUM_CDC, 6, 0x83, 8, 0x04, 0x84, CDC_EP_SIZE)
+
+// Configuration descriptor handed to TinyUSB, rewritten on report descriptor change
+static uint8_t hid_configuration_descriptor[TUSB_DESC_TOTAL_LEN];
+
+static TransportConf_t g_conf;
+
+/********* TinyUSB HID callbacks ***************/
+
+// Invoked when received GET HID REPORT DESCRIPTOR request
+// Application return pointer to descriptor, whose contents must exist long enough for transfer to complete
+uint8_t const *tud_hid_descriptor_report_cb(uint8_t instance)
+{
+    if (instance == TELEMETRY_HID_ITF)
+    {
+        return hid_telemetry_report_descriptor;
+    }
+
+    return g_conf.pReportDesc;
+}
+
+// Invoked when received GET_REPORT control request
+// Application must fill buffer report's content and return its length.
+// Return zero will cause the stack to STALL request
+uint16_t tud_hid_get_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type, uint8_t* buffer, uint16_t reqlen)
+{
+    if ((instance != HID_ITF_MOUSE) || (report_type != HID_REPORT_TYPE_FEATURE) || !g_conf.getFeature)
+    {
+        return 0;
+    }
+
+    if (!buffer)
+    {
+        return 0;
+    }
+
+    return g_conf.getFeature(report_id, buffer, reqlen);
+}
+
+// Invoked when received SET_REPORT control request or
+// received data on OUT endpoint ( Report ID = 0, Type = 0 )
+void tud_hid_set_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type, uint8_t const* buffer, uint16_t bufsize)
+{
+    if ((instance != HID_ITF_MOUSE) || (report_type != HID_REPORT_TYPE_FEATURE) || !g_conf.setFeature)
+    {
+        return;
+    }
+
+    if (!buffer)
+    {
+        return;
+    }
+
+    g_conf.setFeature(report_id, buffer, bufsize);
+}
+
+// Invoked when sent REPORT successfully to host
+// Telemetry records are paced by the mouse task, only the mouse interface is notified
+void tud_hid_report_complete_cb(uint8_t instance, uint8_t const* report, uint16_t len)
+{
+    (void) report;
+    (void) len;
+
+    if ((instance != HID_ITF_MOUSE) || !g_conf.sendDone)
+    {
+        return;
+    }
+
+    g_conf.sendDone();
+}
+
+/********* TinyUSB device callbacks ***************/
+
+// Invoked when device is mounted (configured by the host)
+// Also after a bus reset, features are set again by the host after this
+void tud_mount_cb(void)
+{
+    BOOTPROF_mark(BOOTPROF_STAGE_USB_MOUNT);
+
+    if (g_conf.hostReset)
+    {
+        g_conf.hostReset();
+    }
+}
+
+// Invoked when device is unmounted
+void tud_umount_cb(void)
+{
+    if (g_conf.hostReset)
+    {
+        g_conf.hostReset();
+    }
+}
+
+/************* TinyUSB ****************/
+
+static void __attribute__((format (printf, 2, 3))) _log(LogLevel_e lvl, const char * sFmt, ...);
+
+static void _log(LogLevel_e lvl, const char * sFmt, ...)
+{
+    va_list pArg;
+
+    va_start(pArg, sFmt);
+    LOGGER_log_va(MODULE_ID_TRANSPORT, lvl, sFmt, pArg);
+    va_end(pArg);
+}
+
+static void configDescBuild(uint16_t reportDescLen)
+{
+    const uint8_t configDesc[] = {
+        HID_CONFIGURATION_DESCRIPTOR(reportDescLen),
+#if STREAM_EN
+        CDC_CONFIGURATION_DESCRIPTOR,
+#endif
+    };
+
+    _Static_assert(sizeof(configDesc) == sizeof(hid_configuration_descriptor), "configuration descriptor size");
+
+    memcpy(hid_configuration_descriptor, configDesc, sizeof(hid_configuration_descriptor));
+}
+
+static uint8_t start(const TransportConf_t * pConf)
+{
+    int ret = 0;
+
+    const tinyusb_config_t usbConf =
+    {
+        .device_descriptor = NULL,
+        .string_descriptor = hid_string_descriptor,
+        .string_descriptor_count = sizeof(hid_string_descriptor) / sizeof(hid_string_descriptor[0]),
+        .external_phy = false,
+        .configuration_descriptor = hid_configuration_descriptor,
+    };
+
+    g_conf = *pConf;
+    configDescBuild(g_conf.reportDescLen);
+
+    _log(LOG_LVL_DEBUG, "%s() Init USB", __func__);
+
+    ret = tinyusb_driver_install(&usbConf);
+    if (ret != ESP_OK)
+    {
+        _log(LOG_LVL_ERROR, "%s() tinyusb_driver_install FAILED", __func__);
+        return 1U;
+    }
+
+    return 0U;
+}
+
+static uint8_t setReportDesc(const uint8_t * pDesc, uint16_t len)
+{
+    // Descriptors change, host must enumerate again
+    tud_disconnect();
+    g_conf.pReportDesc = pDesc;
+    g_conf.reportDescLen = len;
+    configDescBuild(len);
+    vTaskDelay(RECONNECT_DELAY_MS / portTICK_PERIOD_MS);
+    tud_connect();
+
+    return 0U;
+}
+
+static uint8_t isReady(void)
+{
+    return tud_hid_n_ready(HID_ITF_MOUSE);
+}
+
+static uint8_t send(uint8_t reportId, const void * pReport, uint16_t len)
+{
+    if (!tud_hid_n_report(HID_ITF_MOUSE, reportId, pReport, len))
+    {
+        return 1U;
+    }
+
+    return 0U;
+}
+
+static uint32_t getIntervalUs(void)
+{
+    // Endpoint readiness already paces reports
+    return 0U;
+}
+
+static uint8_t isAuxReady(void)
+{
+    return tud_hid_n_ready(TELEMETRY_HID_ITF);
+}
+
+static uint8_t sendAux(const void * pReport, uint16_t len)
+{
+    if (!tud_hid_n_report(TELEMETRY_HID_ITF, 0U, pReport, len))
+    {
+        return 1U;
+    }
+
+    return 0U;
+}
+
+const TransportOps_t TRANSPORT_OPS_USB =
+{
+    .sName = "usb",
+    .start = start,
+    .setReportDesc = setReportDesc,
+    .isReady = isReady,
+    .send = send,
+    .getIntervalUs = getIntervalUs,
+    .isAuxReady = isAuxReady,
+    .sendAux = sendAux,
+};
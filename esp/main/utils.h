@@ -3,6 +3,9 @@
 #define UTILS_H
 
 #include <inttypes.h>
+#include <stdlib.h>
+
+#include "config.h"
 
 static const uint32_t MS_PER_S = 1000U;
 static const uint32_t US_PER_MS = 1000U;
@@ -16,6 +19,29 @@ typedef struct Coord_t
     int32_t y;
 } Coord_t;
 
+/**
+ * @brief Long lived instances
+ *
+ * STATIC_ALLOC_EN : UTILS_INST_POOL reserves nb instances in .bss, handed out
+ * by UTILS_INST_ALLOC and never released. Otherwise heap. Init time only, not
+ * thread safe.
+ */
+#if STATIC_ALLOC_EN
+#define UTILS_INST_POOL(type, nb) \
+    static type g_pInstPool[nb]; \
+    static uint8_t g_instPoolNb = 0U
+#define UTILS_INST_ALLOC(type) \
+    ((g_instPoolNb < sizeof(g_pInstPool) / sizeof(g_pInstPool[0])) ? &g_pInstPool[g_instPoolNb++] : NULL)
+#define UTILS_INST_FREE(pInst) ((void) (pInst))
+#else
+#define UTILS_INST_POOL(type, nb) \
+    _Static_assert((nb) > 0U, #type " pool size")
+// Alignment of the type, some carry DMA / SIMD aligned buffers
+#define UTILS_INST_ALLOC(type) \
+    ((type *) aligned_alloc(_Alignof(type), sizeof(type)))
+#define UTILS_INST_FREE(pInst) free(pInst)
+#endif
+
 void UTILS_hang(void);
 
 #endif // UTILS_H
@@ -0,0 +1,280 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "driver/adc.h"
+#include "driver/gpio.h"
+#include "esp_private/esp_clk.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "nvs.h"
+#include "nvs_flash.h"
+
+#include "utils.h"
+
+#include "fakes.h"
+
+struct QueueDefinition
+{
+    uint8_t bHeld;
+};
+
+static int64_t g_timeUs = 0;
+static FakeAdcRead_t g_adcRead = NULL;
+static void * g_pAdcArg = NULL;
+static uint32_t g_adcReadNb = 0U;
+static esp_reset_reason_t g_resetReason = ESP_RST_POWERON;
+static uint64_t g_rtcUs = 0U;
+static uint32_t g_pLogNb[LOG_LVL_NB];
+static uint32_t g_mutexBusyNb = 0U;
+
+void FAKE_reset(void)
+{
+    g_timeUs = 0;
+    g_adcRead = NULL;
+    g_pAdcArg = NULL;
+    g_adcReadNb = 0U;
+    g_resetReason = ESP_RST_POWERON;
+    g_rtcUs = 0U;
+    memset(g_pLogNb, 0, sizeof(g_pLogNb));
+    g_mutexBusyNb = 0U;
+}
+
+void FAKE_setTimeUs(int64_t us)
+{
+    g_timeUs = us;
+}
+
+void FAKE_advanceUs(int64_t us)
+{
+    g_timeUs += us;
+}
+
+void FAKE_setAdc(FakeAdcRead_t read, void * pArg)
+{
+    g_adcRead = read;
+    g_pAdcArg = pArg;
+}
+
+uint32_t FAKE_getAdcReadNb(void)
+{
+    return g_adcReadNb;
+}
+
+void FAKE_setResetReason(esp_reset_reason_t reason)
+{
+    g_resetReason = reason;
+}
+
+void FAKE_setRtcUs(uint64_t us)
+{
+    g_rtcUs = us;
+}
+
+uint32_t FAKE_getLogNb(LogLevel_e lvl)
+{
+    return g_pLogNb[lvl];
+}
+
+uint32_t FAKE_getMutexBusyNb(void)
+{
+    return g_mutexBusyNb;
+}
+
+/********* ESP-IDF ***************/
+
+int64_t esp_timer_get_time(void)
+{
+    return g_timeUs;
+}
+
+uint64_t esp_clk_rtc_time(void)
+{
+    return g_rtcUs;
+}
+
+esp_reset_reason_t esp_reset_reason(void)
+{
+    return g_resetReason;
+}
+
+esp_err_t adc1_config_width(adc_bits_width_t width_bit)
+{
+    return ESP_OK;
+}
+
+esp_err_t adc1_config_channel_atten(adc1_channel_t channel, adc_atten_t atten)
+{
+    return ESP_OK;
+}
+
+int adc1_get_raw(adc1_channel_t channel)
+{
+    g_adcReadNb++;
+
+    if (!g_adcRead)
+    {
+        return -1;
+    }
+
+    return g_adcRead((int) channel, g_pAdcArg);
+}
+
+esp_err_t gpio_config(const gpio_config_t * pGPIOConfig)
+{
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num)
+{
+    return 1;
+}
+
+esp_err_t nvs_flash_init(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void)
+{
+    return ESP_OK;
+}
+
+// Empty partition, nothing stored
+esp_err_t nvs_open(const char * namespace_name, nvs_open_mode_t open_mode, nvs_handle_t * out_handle)
+{
+    return ESP_ERR_NVS_NOT_FOUND;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+}
+
+esp_err_t nvs_get_u8(nvs_handle_t handle, const char * key, uint8_t * out_value)
+{
+    return ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_set_u8(nvs_handle_t handle, const char * key, uint8_t value)
+{
+    return ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    return ESP_ERR_NVS_NOT_FOUND;
+}
+
+/********* FreeRTOS ***************/
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return calloc(1, sizeof(struct QueueDefinition));
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t * pxMutexBuffer)
+{
+    _Static_assert(sizeof(StaticSemaphore_t) >= sizeof(struct QueueDefinition), "StaticSemaphore_t size");
+
+    memset(pxMutexBuffer, 0, sizeof(*pxMutexBuffer));
+
+    return (SemaphoreHandle_t) pxMutexBuffer;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t xSemaphore)
+{
+    free(xSemaphore);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t xSemaphore, TickType_t xBlockTime)
+{
+    if (xSemaphore->bHeld)
+    {
+        if (xBlockTime == 0U)
+        {
+            g_mutexBusyNb++;
+            return pdFALSE;
+        }
+
+        // Nothing else runs to give it back
+        fprintf(stderr, "xSemaphoreTake() blocking take on a held mutex, deadlock on target\n");
+        abort();
+    }
+
+    xSemaphore->bHeld = 1U;
+
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t xSemaphore)
+{
+    if (!xSemaphore->bHeld)
+    {
+        return pdFALSE;
+    }
+
+    xSemaphore->bHeld = 0U;
+
+    return pdTRUE;
+}
+
+void vTaskDelay(TickType_t xTicksToDelay)
+{
+    g_timeUs += (int64_t) xTicksToDelay * portTICK_PERIOD_MS * 1000;
+}
+
+/********* Application ***************/
+
+void LOGGER_setLevel(ModuleId_e moduleId, LogLevel_e lvl)
+{
+}
+
+void LOGGER_log_va(ModuleId_e moduleId, LogLevel_e lvl, const char * sFmt, va_list pArg)
+{
+    if (lvl < LOG_LVL_NB)
+    {
+        g_pLogNb[lvl]++;
+    }
+
+    if (getenv("TEST_HOST_VERBOSE"))
+    {
+        fprintf(stderr, "[%u:%u] ", moduleId, lvl);
+        vfprintf(stderr, sFmt, pArg);
+        fprintf(stderr, "\n");
+    }
+}
+
+void LOGGER_log(ModuleId_e moduleId, LogLevel_e lvl, const char * sFmt, ...)
+{
+    va_list pArg;
+
+    va_start(pArg, sFmt);
+    LOGGER_log_va(moduleId, lvl, sFmt, pArg);
+    va_end(pArg);
+}
+
+// Instances are never freed, on target either
+const char * __asan_default_options(void);
+
+const char * __asan_default_options(void)
+{
+    return "detect_leaks=0";
+}
+
+uint16_t LOGGER_getQueueDepth(void)
+{
+    return 0U;
+}
+
+uint32_t LOGGER_getDropCnt(void)
+{
+    return 0U;
+}
+
+void UTILS_hang(void)
+{
+    fprintf(stderr, "UTILS_hang()\n");
+    abort();
+}
@@ -0,0 +1,37 @@
+
+#ifndef FAKES_H
+#define FAKES_H
+
+#include <inttypes.h>
+
+#include "esp_system.h"
+#include "logger.h"
+
+/**
+ * @brief Host stand-ins for the ESP-IDF and FreeRTOS services used by main/
+ *
+ * Single threaded : time only moves with FAKE_advanceUs, a mutex taken with
+ * a timeout while held fails the test (it would block forever on target).
+ */
+
+// Raw ADC sample for a channel, -1 : read error
+typedef int (*FakeAdcRead_t)(int chan, void * pArg);
+
+void FAKE_reset(void);
+
+void FAKE_setTimeUs(int64_t us);
+void FAKE_advanceUs(int64_t us);
+
+void FAKE_setAdc(FakeAdcRead_t read, void * pArg);
+uint32_t FAKE_getAdcReadNb(void);
+
+void FAKE_setResetReason(esp_reset_reason_t reason);
+void FAKE_setRtcUs(uint64_t us);
+
+// Logged lines per level, printed with TEST_HOST_VERBOSE set in the environment
+uint32_t FAKE_getLogNb(LogLevel_e lvl);
+
+// Zero timeout takes refused because the mutex was held
+uint32_t FAKE_getMutexBusyNb(void);
+
+#endif // FAKES_H
@@ -0,0 +1,140 @@
+
+#include <string.h>
+
+#include "mock_transport.h"
+
+MockEndpoint_t g_mock;
+
+void MOCK_reset(void)
+{
+    memset(&g_mock, 0, sizeof(g_mock));
+    g_mock.bConnected = 1U;
+    g_mock.bHold = 1U;
+    g_mock.bAuxReady = 1U;
+}
+
+uint8_t MOCK_complete(void)
+{
+    if (!g_mock.bBusy)
+    {
+        return 0U;
+    }
+
+    g_mock.bBusy = 0U;
+
+    if (g_mock.conf.sendDone)
+    {
+        g_mock.conf.sendDone();
+    }
+
+    return 1U;
+}
+
+static uint8_t start(const TransportConf_t * pConf)
+{
+    g_mock.conf = *pConf;
+    g_mock.bStarted = 1U;
+
+    return 0U;
+}
+
+static uint8_t setReportDesc(const uint8_t * pDesc, uint16_t len)
+{
+    g_mock.conf.pReportDesc = pDesc;
+    g_mock.conf.reportDescLen = len;
+    g_mock.setReportDescNb++;
+
+    if (g_mock.onSetReportDesc)
+    {
+        g_mock.onSetReportDesc();
+    }
+
+    return 0U;
+}
+
+static uint8_t isReady(void)
+{
+    return g_mock.bStarted && g_mock.bConnected && !g_mock.bBusy;
+}
+
+static uint8_t send(uint8_t reportId, const void * pReport, uint16_t len)
+{
+    if (!isReady() || (len > MOCK_REPORT_LEN_MAX))
+    {
+        return 1U;
+    }
+
+    memcpy(g_mock.pLast, pReport, len);
+    g_mock.lastLen = len;
+    g_mock.sendNb++;
+    g_mock.pReportNb[reportId]++;
+    g_mock.bBusy = g_mock.bHold;
+
+    if (g_mock.onReport)
+    {
+        g_mock.onReport(reportId, pReport, len, g_mock.pOnReportArg);
+    }
+
+    if (g_mock.bCompleteInSend)
+    {
+        MOCK_complete();
+    }
+
+    return 0U;
+}
+
+static uint32_t getIntervalUs(void)
+{
+    return g_mock.intervalUs;
+}
+
+static uint8_t isAuxReady(void)
+{
+    return g_mock.bStarted && g_mock.bConnected && g_mock.bAuxReady;
+}
+
+static uint8_t sendAux(const void * pReport, uint16_t len)
+{
+    if (!isAuxReady() || (len > MOCK_REPORT_LEN_MAX))
+    {
+        return 1U;
+    }
+
+    memcpy(g_mock.pAuxLast, pReport, len);
+    g_mock.auxLastLen = len;
+    g_mock.auxNb++;
+
+    return 0U;
+}
+
+const TransportOps_t TRANSPORT_OPS_USB =
+{
+    .sName = "mock usb",
+    .start = start,
+    .setReportDesc = setReportDesc,
+    .isReady = isReady,
+    .send = send,
+    .getIntervalUs = getIntervalUs,
+    .isAuxReady = isAuxReady,
+    .sendAux = sendAux,
+};
+
+const TransportOps_t TRANSPORT_OPS_BLE =
+{
+    .sName = "mock ble",
+    .start = start,
+    .setReportDesc = setReportDesc,
+    .isReady = isReady,
+    .send = send,
+    .getIntervalUs = getIntervalUs,
+};
+
+const TransportOps_t TRANSPORT_OPS_LOOPBACK =
+{
+    .sName = "mock loopback",
+    .start = start,
+    .setReportDesc = setReportDesc,
+    .isReady = isReady,
+    .send = send,
+    .getIntervalUs = getIntervalUs,
+};
@@ -0,0 +1,55 @@
+
+#ifndef MOCK_TRANSPORT_H
+#define MOCK_TRANSPORT_H
+
+#include <inttypes.h>
+
+#include "transport.h"
+
+#define MOCK_REPORT_LEN_MAX 64U
+
+// Sent report, as the host would receive it
+typedef void (*MockOnReport_t)(uint8_t reportId, const uint8_t * pReport, uint16_t len, void * pArg);
+
+/**
+ * @brief Mock endpoint behind every TRANSPORT_OPS_*
+ *
+ * bHold : a report keeps the endpoint busy until MOCK_complete (USB),
+ * otherwise isReady only follows bConnected (BLE, paced by intervalUs).
+ */
+typedef struct MockEndpoint_t
+{
+    // As given to start, callbacks of the module under test
+    TransportConf_t conf;
+    uint8_t bStarted;
+    uint8_t bConnected;
+    uint8_t bHold;
+    uint8_t bBusy;
+    // Completion runs from inside send, the stack preempting the sender
+    uint8_t bCompleteInSend;
+    uint32_t intervalUs;
+    uint32_t sendNb;
+    uint32_t setReportDescNb;
+    uint32_t pReportNb[256];
+    uint8_t pLast[MOCK_REPORT_LEN_MAX];
+    uint16_t lastLen;
+    MockOnReport_t onReport;
+    void * pOnReportArg;
+    // Runs inside setReportDesc, while the host enumerates again
+    void (*onSetReportDesc)(void);
+    // Telemetry channel, usb only like the real backends
+    uint8_t bAuxReady;
+    uint32_t auxNb;
+    uint8_t pAuxLast[MOCK_REPORT_LEN_MAX];
+    uint16_t auxLastLen;
+} MockEndpoint_t;
+
+extern MockEndpoint_t g_mock;
+
+// Connected, USB like, no interval, telemetry channel ready
+void MOCK_reset(void);
+
+// Report delivered, endpoint free again, runs the sendDone callback, 1 if a report was in flight
+uint8_t MOCK_complete(void);
+
+#endif // MOCK_TRANSPORT_H
@@ -0,0 +1,10 @@
+// Host build stand-in, TinyUSB CDC declarations used by main/
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+bool tud_cdc_n_connected(uint8_t itf);
+uint32_t tud_cdc_n_write_available(uint8_t itf);
+uint32_t tud_cdc_n_write(uint8_t itf, void const * buffer, uint32_t bufsize);
+uint32_t tud_cdc_n_write_flush(uint8_t itf);
@@ -0,0 +1,5 @@
+// Host build stand-in
+#pragma once
+
+#include "class/hid/hid_device.h"
+#include "tinyusb.h"
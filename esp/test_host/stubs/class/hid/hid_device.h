@@ -0,0 +1,106 @@
+// Host build stand-in, TinyUSB 0.15 HID declarations used by main/
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum
+{
+    HID_REPORT_TYPE_INVALID = 0,
+    HID_REPORT_TYPE_INPUT,
+    HID_REPORT_TYPE_OUTPUT,
+    HID_REPORT_TYPE_FEATURE,
+} hid_report_type_t;
+
+// Report descriptor items, same encoding as TinyUSB hid.h
+#define HID_U16_LE(x) (uint8_t) ((x) & 0xff), (uint8_t) (((x) >> 8) & 0xff)
+
+#define HID_REPORT_DATA_0(data)
+#define HID_REPORT_DATA_1(data) , (uint8_t) (data)
+#define HID_REPORT_DATA_2(data) , HID_U16_LE(data)
+
+#define HID_REPORT_ITEM(data, tag, type, size) \
+    (((tag) << 4) | ((type) << 2) | (size)) HID_REPORT_DATA_##size(data)
+
+#define RI_TYPE_MAIN   0
+#define RI_TYPE_GLOBAL 1
+#define RI_TYPE_LOCAL  2
+
+#define RI_MAIN_INPUT          8
+#define RI_MAIN_OUTPUT         9
+#define RI_MAIN_COLLECTION     10
+#define RI_MAIN_FEATURE        11
+#define RI_MAIN_COLLECTION_END 12
+
+#define RI_GLOBAL_USAGE_PAGE   0
+#define RI_GLOBAL_LOGICAL_MIN  1
+#define RI_GLOBAL_LOGICAL_MAX  2
+#define RI_GLOBAL_PHYSICAL_MIN 3
+#define RI_GLOBAL_PHYSICAL_MAX 4
+#define RI_GLOBAL_REPORT_SIZE  7
+#define RI_GLOBAL_REPORT_ID    8
+#define RI_GLOBAL_REPORT_COUNT 9
+
+#define RI_LOCAL_USAGE     0
+#define RI_LOCAL_USAGE_MIN 1
+#define RI_LOCAL_USAGE_MAX 2
+
+#define HID_INPUT(x)          HID_REPORT_ITEM(x, RI_MAIN_INPUT, RI_TYPE_MAIN, 1)
+#define HID_OUTPUT(x)         HID_REPORT_ITEM(x, RI_MAIN_OUTPUT, RI_TYPE_MAIN, 1)
+#define HID_COLLECTION(x)     HID_REPORT_ITEM(x, RI_MAIN_COLLECTION, RI_TYPE_MAIN, 1)
+#define HID_FEATURE(x)        HID_REPORT_ITEM(x, RI_MAIN_FEATURE, RI_TYPE_MAIN, 1)
+#define HID_COLLECTION_END    HID_REPORT_ITEM(x, RI_MAIN_COLLECTION_END, RI_TYPE_MAIN, 0)
+
+#define HID_USAGE_PAGE(x)        HID_REPORT_ITEM(x, RI_GLOBAL_USAGE_PAGE, RI_TYPE_GLOBAL, 1)
+#define HID_USAGE_PAGE_N(x, n)   HID_REPORT_ITEM(x, RI_GLOBAL_USAGE_PAGE, RI_TYPE_GLOBAL, n)
+#define HID_LOGICAL_MIN(x)       HID_REPORT_ITEM(x, RI_GLOBAL_LOGICAL_MIN, RI_TYPE_GLOBAL, 1)
+#define HID_LOGICAL_MIN_N(x, n)  HID_REPORT_ITEM(x, RI_GLOBAL_LOGICAL_MIN, RI_TYPE_GLOBAL, n)
+#define HID_LOGICAL_MAX(x)       HID_REPORT_ITEM(x, RI_GLOBAL_LOGICAL_MAX, RI_TYPE_GLOBAL, 1)
+#define HID_LOGICAL_MAX_N(x, n)  HID_REPORT_ITEM(x, RI_GLOBAL_LOGICAL_MAX, RI_TYPE_GLOBAL, n)
+#define HID_PHYSICAL_MIN(x)      HID_REPORT_ITEM(x, RI_GLOBAL_PHYSICAL_MIN, RI_TYPE_GLOBAL, 1)
+#define HID_PHYSICAL_MIN_N(x, n) HID_REPORT_ITEM(x, RI_GLOBAL_PHYSICAL_MIN, RI_TYPE_GLOBAL, n)
+#define HID_PHYSICAL_MAX(x)      HID_REPORT_ITEM(x, RI_GLOBAL_PHYSICAL_MAX, RI_TYPE_GLOBAL, 1)
+#define HID_PHYSICAL_MAX_N(x, n) HID_REPORT_ITEM(x, RI_GLOBAL_PHYSICAL_MAX, RI_TYPE_GLOBAL, n)
+#define HID_REPORT_SIZE(x)       HID_REPORT_ITEM(x, RI_GLOBAL_REPORT_SIZE, RI_TYPE_GLOBAL, 1)
+#define HID_REPORT_ID(x)         HID_REPORT_ITEM(x, RI_GLOBAL_REPORT_ID, RI_TYPE_GLOBAL, 1),
+#define HID_REPORT_COUNT(x)      HID_REPORT_ITEM(x, RI_GLOBAL_REPORT_COUNT, RI_TYPE_GLOBAL, 1)
+
+#define HID_USAGE(x)        HID_REPORT_ITEM(x, RI_LOCAL_USAGE, RI_TYPE_LOCAL, 1)
+#define HID_USAGE_N(x, n)   HID_REPORT_ITEM(x, RI_LOCAL_USAGE, RI_TYPE_LOCAL, n)
+#define HID_USAGE_MIN(x)    HID_REPORT_ITEM(x, RI_LOCAL_USAGE_MIN, RI_TYPE_LOCAL, 1)
+#define HID_USAGE_MIN_N(x, n) HID_REPORT_ITEM(x, RI_LOCAL_USAGE_MIN, RI_TYPE_LOCAL, n)
+#define HID_USAGE_MAX(x)    HID_REPORT_ITEM(x, RI_LOCAL_USAGE_MAX, RI_TYPE_LOCAL, 1)
+#define HID_USAGE_MAX_N(x, n) HID_REPORT_ITEM(x, RI_LOCAL_USAGE_MAX, RI_TYPE_LOCAL, n)
+
+#define HID_DATA     (0 << 0)
+#define HID_CONSTANT (1 << 0)
+#define HID_ARRAY    (0 << 1)
+#define HID_VARIABLE (1 << 1)
+#define HID_ABSOLUTE (0 << 2)
+#define HID_RELATIVE (1 << 2)
+
+#define HID_COLLECTION_PHYSICAL    0
+#define HID_COLLECTION_APPLICATION 1
+#define HID_COLLECTION_LOGICAL     2
+
+#define HID_USAGE_PAGE_DESKTOP  0x01
+#define HID_USAGE_PAGE_BUTTON   0x09
+#define HID_USAGE_PAGE_CONSUMER  0x0c
+#define HID_USAGE_PAGE_DIGITIZER 0x0d
+#define HID_USAGE_PAGE_VENDOR    0xff00
+
+#define HID_USAGE_DESKTOP_POINTER               0x01
+#define HID_USAGE_DESKTOP_MOUSE                 0x02
+#define HID_USAGE_DESKTOP_JOYSTICK              0x04
+#define HID_USAGE_DESKTOP_GAMEPAD               0x05
+#define HID_USAGE_DESKTOP_X                     0x30
+#define HID_USAGE_DESKTOP_Y                     0x31
+#define HID_USAGE_DESKTOP_WHEEL                 0x38
+#define HID_USAGE_DESKTOP_RESOLUTION_MULTIPLIER 0x48
+#define HID_USAGE_CONSUMER_AC_PAN               0x0238
+
+bool tud_hid_ready(void);
+bool tud_hid_n_ready(uint8_t instance);
+bool tud_hid_report(uint8_t report_id, void const * report, uint16_t len);
+bool tud_hid_n_report(uint8_t instance, uint8_t report_id, void const * report, uint16_t len);
+void tud_hid_report_complete_cb(uint8_t instance, uint8_t const * report, uint16_t len);
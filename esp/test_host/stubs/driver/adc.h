@@ -0,0 +1,29 @@
+// Host build stand-in, legacy ADC1 driver used by main/
+#pragma once
+
+#include "esp_err.h"
+
+typedef enum
+{
+    ADC1_CHANNEL_0 = 0,
+    ADC1_CHANNEL_1,
+    ADC1_CHANNEL_2,
+    ADC1_CHANNEL_3,
+    ADC1_CHANNEL_4,
+    ADC1_CHANNEL_MAX,
+} adc1_channel_t;
+
+typedef enum
+{
+    ADC_WIDTH_BIT_13 = 4,
+} adc_bits_width_t;
+
+typedef enum
+{
+    ADC_ATTEN_DB_0 = 0,
+} adc_atten_t;
+
+esp_err_t adc1_config_width(adc_bits_width_t width_bit);
+esp_err_t adc1_config_channel_atten(adc1_channel_t channel, adc_atten_t atten);
+// -1 on error
+int adc1_get_raw(adc1_channel_t channel);
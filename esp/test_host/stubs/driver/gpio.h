@@ -0,0 +1,34 @@
+// Host build stand-in, GPIO driver declarations used by main/
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+typedef enum
+{
+    GPIO_NUM_0 = 0,
+    GPIO_NUM_1,
+    GPIO_NUM_2,
+    GPIO_NUM_3,
+    GPIO_NUM_4,
+    GPIO_NUM_5,
+} gpio_num_t;
+
+#define BIT64(nr) (1ULL << (nr))
+
+#define GPIO_MODE_INPUT   1
+#define GPIO_INTR_DISABLE 0
+
+typedef struct
+{
+    uint64_t pin_bit_mask;
+    int mode;
+    int pull_up_en;
+    int pull_down_en;
+    int intr_type;
+} gpio_config_t;
+
+esp_err_t gpio_config(const gpio_config_t * pGPIOConfig);
+int gpio_get_level(gpio_num_t gpio_num);
@@ -0,0 +1,6 @@
+// Host build stand-in, ESP-IDF private API
+#pragma once
+
+#include <stdint.h>
+
+uint64_t esp_clk_rtc_time(void);
@@ -0,0 +1,45 @@
+// Host build stand-in, FreeRTOS types and port settings used by main/
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint8_t StackType_t;
+
+#define pdTRUE  1
+#define pdFALSE 0
+#define pdPASS  pdTRUE
+
+#define portMAX_DELAY ((TickType_t) 0xffffffffUL)
+#define portTICK_PERIOD_MS 5U
+#define portNUM_PROCESSORS 1
+#define configMAX_PRIORITIES 25
+#define configSTACK_DEPTH_TYPE uint32_t
+#define pdMS_TO_TICKS(xTimeInMs) ((TickType_t) (xTimeInMs) / portTICK_PERIOD_MS)
+
+// Single threaded host build, critical sections are no-ops
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(pMux)     (void) (pMux)
+#define portEXIT_CRITICAL(pMux)      (void) (pMux)
+#define portENTER_CRITICAL_ISR(pMux) (void) (pMux)
+#define portEXIT_CRITICAL_ISR(pMux)  (void) (pMux)
+#define portYIELD_FROM_ISR(xSwitch)  (void) (xSwitch)
+
+typedef struct
+{
+    void * pDummy[24];
+} StaticTask_t;
+
+typedef struct
+{
+    void * pDummy[12];
+} StaticQueue_t;
+
+typedef StaticQueue_t StaticSemaphore_t;
+
+#include "freertos/task.h"
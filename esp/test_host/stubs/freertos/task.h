@@ -0,0 +1,51 @@
+// Host build stand-in
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct tskTaskControlBlock * TaskHandle_t;
+typedef void (*TaskFunction_t)(void * pvParameters);
+
+typedef enum
+{
+    eRunning = 0,
+    eReady,
+    eBlocked,
+    eSuspended,
+    eDeleted,
+    eInvalid,
+} eTaskState;
+
+typedef struct
+{
+    TaskHandle_t xHandle;
+    const char * pcTaskName;
+    UBaseType_t xTaskNumber;
+    eTaskState eCurrentState;
+    UBaseType_t uxCurrentPriority;
+    UBaseType_t uxBasePriority;
+    uint32_t ulRunTimeCounter;
+    StackType_t * pxStackBase;
+    configSTACK_DEPTH_TYPE usStackHighWaterMark;
+    BaseType_t xCoreID;
+} TaskStatus_t;
+
+BaseType_t xTaskCreate(TaskFunction_t pxTaskCode, const char * pcName, uint32_t usStackDepth, void * pvParameters,
+    UBaseType_t uxPriority, TaskHandle_t * pxCreatedTask);
+TaskHandle_t xTaskCreateStatic(TaskFunction_t pxTaskCode, const char * pcName, uint32_t ulStackDepth, void * pvParameters,
+    UBaseType_t uxPriority, StackType_t * puxStackBuffer, StaticTask_t * pxTaskBuffer);
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pxTaskCode, const char * pcName, uint32_t usStackDepth,
+    void * pvParameters, UBaseType_t uxPriority, TaskHandle_t * pxCreatedTask, BaseType_t xCoreID);
+void vTaskDelete(TaskHandle_t xTaskToDelete);
+void vTaskDelay(TickType_t xTicksToDelay);
+TickType_t xTaskGetTickCount(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+const char * pcTaskGetName(TaskHandle_t xTaskToQuery);
+UBaseType_t uxTaskGetNumberOfTasks(void);
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait);
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify);
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t * pxHigherPriorityTaskWoken);
+TaskHandle_t xTaskGetHandle(const char * pcNameToQuery);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t xTask);
+UBaseType_t uxTaskGetSystemState(TaskStatus_t * pxTaskStatusArray, UBaseType_t uxArraySize, uint32_t * pulTotalRunTime);
+TaskHandle_t xTaskGetIdleTaskHandleForCPU(UBaseType_t cpuid);
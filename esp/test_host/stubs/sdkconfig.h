@@ -0,0 +1,10 @@
+// Host build stand-in, values from ../sdkconfig that main/ depends on
+#pragma once
+
+#define CONFIG_IDF_TARGET_ESP32S2 1
+#define CONFIG_ESP_MAIN_TASK_STACK_SIZE 3584
+#define CONFIG_FREERTOS_IDLE_TASK_STACKSIZE 1536
+#define CONFIG_ESP_TIMER_TASK_STACK_SIZE 3584
+#define CONFIG_TINYUSB_TASK_STACK_SIZE 4096
+#define CONFIG_FREERTOS_USE_TRACE_FACILITY 1
+#define CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS 1
@@ -0,0 +1,59 @@
+// Host build stand-in, esp_tinyusb declarations used by main/
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "class/hid/hid_device.h"
+
+#define CFG_TUD_HID 2
+
+// Descriptor templates, same layout as TinyUSB usbd.h
+#define TUD_CONFIG_DESC_LEN 9
+#define TUD_HID_DESC_LEN    (9 + 9 + 7)
+#define TUD_CDC_DESC_LEN    (8 + 9 + 5 + 5 + 4 + 5 + 7 + 9 + 7 + 7)
+
+#define TUSB_DESC_CONFIG_ATT_REMOTE_WAKEUP (1U << 5)
+
+#define TUD_CONFIG_DESCRIPTOR(config_num, _itfcount, _stridx, _total_len, _attribute, _power_ma) \
+    9, 0x02, HID_U16_LE(_total_len), _itfcount, config_num, _stridx, (1U << 7) | (_attribute), (_power_ma) / 2
+
+#define TUD_HID_DESCRIPTOR(_itfnum, _stridx, _boot_protocol, _report_desc_len, _epin, _epsize, _ep_interval) \
+    9, 0x04, _itfnum, 0, 1, 0x03, (uint8_t) ((_boot_protocol) ? 1 : 0), _boot_protocol, _stridx, \
+    9, 0x21, HID_U16_LE(0x0111), 0, 1, 0x22, HID_U16_LE(_report_desc_len), \
+    7, 0x05, _epin, 0x03, HID_U16_LE(_epsize), _ep_interval
+
+#define TUD_CDC_DESCRIPTOR(_itfnum, _stridx, _ep_notif, _ep_notif_size, _epout, _epin, _epsize) \
+    8, 0x0b, _itfnum, 2, 0x02, 0x02, 0x00, 0, \
+    9, 0x04, _itfnum, 0, 1, 0x02, 0x02, 0x00, _stridx, \
+    5, 0x24, 0x00, HID_U16_LE(0x0120), \
+    5, 0x24, 0x01, 0, (uint8_t) ((_itfnum) + 1), \
+    4, 0x24, 0x02, 2, \
+    5, 0x24, 0x06, _itfnum, (uint8_t) ((_itfnum) + 1), \
+    7, 0x05, _ep_notif, 0x03, HID_U16_LE(_ep_notif_size), 16, \
+    9, 0x04, (uint8_t) ((_itfnum) + 1), 0, 2, 0x0a, 0x00, 0x00, 0, \
+    7, 0x05, _epout, 0x02, HID_U16_LE(_epsize), 0, \
+    7, 0x05, _epin, 0x02, HID_U16_LE(_epsize), 0
+
+#define HID_ITF_PROTOCOL_NONE     0
+#define HID_ITF_PROTOCOL_KEYBOARD 1
+#define HID_ITF_PROTOCOL_MOUSE    2
+
+typedef struct
+{
+    const void * device_descriptor;
+    const char ** string_descriptor;
+    int string_descriptor_count;
+    bool external_phy;
+    const uint8_t * configuration_descriptor;
+    bool self_powered;
+    int vbus_monitor_io;
+} tinyusb_config_t;
+
+esp_err_t tinyusb_driver_install(const tinyusb_config_t * config);
+
+bool tud_mounted(void);
+bool tud_ready(void);
+bool tud_connect(void);
+bool tud_disconnect(void);
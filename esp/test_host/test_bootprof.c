@@ -0,0 +1,62 @@
+
+#include "bootprof.h"
+
+#include "fakes.h"
+#include "test_host.h"
+
+static void boot(esp_reset_reason_t reason, uint64_t rtcUs, int64_t timerUs)
+{
+    FAKE_reset();
+    FAKE_setResetReason(reason);
+    FAKE_setRtcUs(rtcUs);
+    FAKE_setTimeUs(timerUs);
+    BOOTPROF_init();
+}
+
+static void testPowerOn(void)
+{
+    // 250 ms in ROM, bootloader and startup, esp_timer started 20 ms before app_main
+    boot(ESP_RST_POWERON, 250000U, 20000);
+    CHECK_EQ(BOOTPROF_getUs(BOOTPROF_STAGE_APP_START), 250000U);
+
+    FAKE_advanceUs(1500);
+    BOOTPROF_mark(BOOTPROF_STAGE_LOGGER);
+    CHECK_EQ(BOOTPROF_getUs(BOOTPROF_STAGE_LOGGER), 251500U);
+
+    // Kept once
+    FAKE_advanceUs(1000);
+    BOOTPROF_mark(BOOTPROF_STAGE_LOGGER);
+    CHECK_EQ(BOOTPROF_getUs(BOOTPROF_STAGE_LOGGER), 251500U);
+    CHECK(!BOOTPROF_isMarked(BOOTPROF_STAGE_GPIO));
+    CHECK_EQ(BOOTPROF_getUs(BOOTPROF_STAGE_NB), 0U);
+
+    BOOTPROF_log();
+    CHECK_EQ(FAKE_getLogNb(LOG_LVL_ERROR), 0U);
+}
+
+static void testOtherReset(esp_reset_reason_t reason)
+{
+    // RTC counter still running from an earlier power on, not used
+    boot(reason, 3600000000ULL, 20000);
+    CHECK_EQ(BOOTPROF_getUs(BOOTPROF_STAGE_APP_START), 20000U);
+
+    FAKE_advanceUs(1500);
+    BOOTPROF_mark(BOOTPROF_STAGE_LOGGER);
+    CHECK_EQ(BOOTPROF_getUs(BOOTPROF_STAGE_LOGGER), 21500U);
+
+    BOOTPROF_log();
+}
+
+int main(void)
+{
+    testPowerOn();
+    testOtherReset(ESP_RST_SW);
+    testOtherReset(ESP_RST_DEEPSLEEP);
+    testOtherReset(ESP_RST_PANIC);
+    // Previous boot offset not kept
+    testPowerOn();
+
+    printf("OK\n");
+
+    return 0;
+}
@@ -0,0 +1,208 @@
+
+#include <string.h>
+#include <time.h>
+
+#include "fir.h"
+
+#include "test_host.h"
+
+#define STREAM_NB 4096U
+
+// Golden model : direct convolution over the whole input, coefficient 0 on the newest sample
+static int16_t golden(const int16_t * pCoef, uint16_t tapNb, const int16_t * pIn, uint32_t newest)
+{
+    int64_t acc = 0;
+
+    for (uint32_t tap = 0U; (tap < tapNb) && (tap <= newest); tap++)
+    {
+        acc += (int64_t) pCoef[tap] * pIn[newest - tap];
+    }
+
+    // Round half up, then saturate
+    acc = (acc + (1 << (FIR_COEF_SHIFT - 1U))) >> FIR_COEF_SHIFT;
+    if (acc > INT16_MAX)
+    {
+        return INT16_MAX;
+    }
+    if (acc < INT16_MIN)
+    {
+        return INT16_MIN;
+    }
+
+    return (int16_t) acc;
+}
+
+static void testDesign(void)
+{
+    int16_t pCoef[FIR_TAP_MAX];
+
+    for (uint16_t tapNb = 0U; tapNb <= FIR_TAP_MAX + 1U; tapNb++)
+    {
+        // Nothing to filter without decimation
+        CHECK_EQ(FIR_REF_design(pCoef, tapNb, 0U), 1U);
+        CHECK_EQ(FIR_REF_design(pCoef, tapNb, 1U), 1U);
+
+        for (uint16_t decim = 2U; decim <= 16U; decim++)
+        {
+            int32_t sum = 0;
+            uint8_t ret = FIR_REF_design(pCoef, tapNb, decim);
+
+            if ((tapNb < 2U) || (tapNb > FIR_TAP_MAX))
+            {
+                // Single tap would be unity, 32768 is out of Q15
+                CHECK_EQ(ret, 1U);
+                continue;
+            }
+
+            CHECK_EQ(ret, 0U);
+
+            for (uint16_t tap = 0U; tap < tapNb; tap++)
+            {
+                sum += pCoef[tap];
+                CHECK_EQ(pCoef[tap], pCoef[tapNb - 1U - tap]);
+                CHECK(pCoef[tap] <= pCoef[(tapNb - 1U) / 2U]);
+            }
+
+            CHECK_EQ(sum, FIR_COEF_ONE);
+            CHECK(pCoef[(tapNb - 1U) / 2U] > 0);
+        }
+    }
+
+    CHECK_EQ(FIR_REF_design(NULL, 8U, 2U), 1U);
+}
+
+// Blocks of random length (multiples of decim), output compared with the golden model
+static void streamCheck(const int16_t * pCoef, uint16_t tapNb, uint16_t decim, const int16_t * pIn, uint32_t * pRng)
+{
+    FirRef_t ref;
+    int16_t pOut[STREAM_NB];
+    uint32_t inIdx = 0U;
+    uint32_t outIdx = 0U;
+
+    CHECK_EQ(FIR_REF_init(&ref, pCoef, tapNb, decim), 0U);
+
+    while (inIdx + decim <= STREAM_NB)
+    {
+        uint32_t blockNb = TEST_randRange(pRng, 0, 8) * decim;
+
+        if (inIdx + blockNb > STREAM_NB)
+        {
+            blockNb = (STREAM_NB - inIdx) / decim * decim;
+        }
+
+        CHECK_EQ(FIR_REF_decimate(&ref, &pIn[inIdx], (uint16_t) blockNb, &pOut[outIdx]), blockNb / decim);
+        inIdx += blockNb;
+        outIdx += blockNb / decim;
+    }
+
+    for (uint32_t k = 0U; k < outIdx; k++)
+    {
+        CHECK_EQ(pOut[k], golden(pCoef, tapNb, pIn, (k + 1U) * decim - 1U));
+    }
+}
+
+static void testEquivalence(uint32_t seed)
+{
+    uint32_t rng = TEST_seed(seed);
+    static int16_t pIn[STREAM_NB];
+    int16_t pCoef[FIR_TAP_MAX];
+
+    for (uint32_t run = 0U; run < 400U; run++)
+    {
+        uint16_t tapNb = (uint16_t) TEST_randRange(&rng, 2, FIR_TAP_MAX);
+        uint16_t decim = (uint16_t) TEST_randRange(&rng, 2, 16);
+        uint32_t kind = run % 4U;
+
+        for (uint32_t i = 0U; i < STREAM_NB; i++)
+        {
+            switch (kind)
+            {
+                case 0U:
+                    // Full scale noise, rounding and saturation
+                    pIn[i] = (int16_t) TEST_rand(&rng);
+                    break;
+                case 1U:
+                    // Step to full scale
+                    pIn[i] = (i < STREAM_NB / 2U) ? INT16_MIN : INT16_MAX;
+                    break;
+                case 2U:
+                    // Impulses
+                    pIn[i] = (TEST_rand(&rng) % 64U == 0U) ? INT16_MAX : 0;
+                    break;
+                default:
+                    // ADC like, 13 bits around mid scale
+                    pIn[i] = (int16_t) (4096 + TEST_randRange(&rng, -300, 300));
+                    break;
+            }
+        }
+
+        // Designed taps, then arbitrary ones (gain above 1, saturating)
+        CHECK_EQ(FIR_REF_design(pCoef, tapNb, decim), 0U);
+        streamCheck(pCoef, tapNb, decim, pIn, &rng);
+
+        for (uint16_t tap = 0U; tap < tapNb; tap++)
+        {
+            pCoef[tap] = (int16_t) TEST_rand(&rng);
+        }
+        streamCheck(pCoef, tapNb, decim, pIn, &rng);
+    }
+}
+
+static void testDcGain(void)
+{
+    int16_t pCoef[FIR_TAP_MAX];
+    int16_t pIn[FIR_TAP_MAX * 2U];
+    int16_t pOut[FIR_TAP_MAX * 2U];
+    FirRef_t ref;
+    uint16_t outNb = 0U;
+
+    // Controller setting : 2 * ACQ_NB taps, decimation ACQ_NB
+    CHECK_EQ(FIR_REF_design(pCoef, 20U, 10U), 0U);
+    CHECK_EQ(FIR_REF_init(&ref, pCoef, 20U, 10U), 0U);
+
+    for (uint32_t i = 0U; i < 60U; i++)
+    {
+        pIn[i] = 8191;
+    }
+
+    outNb = FIR_REF_decimate(&ref, pIn, 60U, pOut);
+    CHECK_EQ(outNb, 6U);
+    // Exact once the delay line is full
+    CHECK_EQ(pOut[outNb - 1U], 8191);
+}
+
+static void bench(void)
+{
+    static int16_t pIn[STREAM_NB];
+    int16_t pOut[STREAM_NB];
+    int16_t pCoef[FIR_TAP_MAX];
+    FirRef_t ref;
+    struct timespec start;
+    struct timespec end;
+    double spanS = 0.0;
+
+    CHECK_EQ(FIR_REF_design(pCoef, 20U, 10U), 0U);
+    CHECK_EQ(FIR_REF_init(&ref, pCoef, 20U, 10U), 0U);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t loop = 0U; loop < 200U; loop++)
+    {
+        FIR_REF_decimate(&ref, pIn, STREAM_NB / 10U * 10U, pOut);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    spanS = (double) (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("ref : %.0f samples/s on the host (20 taps, decimation 10)\n", 200.0 * (STREAM_NB / 10U * 10U) / spanS);
+}
+
+int main(void)
+{
+    testDesign();
+    testEquivalence(3U);
+    testDcGain();
+    bench();
+
+    printf("OK\n");
+
+    return 0;
+}
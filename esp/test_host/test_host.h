@@ -0,0 +1,61 @@
+
+#ifndef TEST_HOST_H
+#define TEST_HOST_H
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Stops the test at the first failure, with the values compared
+#define CHECK(cond) \
+    do \
+    { \
+        if (!(cond)) \
+        { \
+            fprintf(stderr, "%s:%d: CHECK(%s) FAILED\n", __FILE__, __LINE__, #cond); \
+            exit(1); \
+        } \
+    } while (0)
+
+#define CHECK_EQ(a, b) \
+    do \
+    { \
+        long long _a = (long long) (a); \
+        long long _b = (long long) (b); \
+        if (_a != _b) \
+        { \
+            fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) FAILED, %lld != %lld\n", __FILE__, __LINE__, #a, #b, _a, _b); \
+            exit(1); \
+        } \
+    } while (0)
+
+// Reproducible pseudo random sequence (xorshift32), seed from TEST_SEED when set
+static inline uint32_t TEST_seed(uint32_t dflt)
+{
+    const char * sSeed = getenv("TEST_SEED");
+    uint32_t seed = sSeed ? (uint32_t) strtoul(sSeed, NULL, 0) : dflt;
+
+    printf("seed %" PRIu32 "\n", seed);
+
+    return seed ? seed : 1U;
+}
+
+static inline uint32_t TEST_rand(uint32_t * pState)
+{
+    uint32_t x = *pState;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *pState = x;
+
+    return x;
+}
+
+// Uniform in [min, max]
+static inline int32_t TEST_randRange(uint32_t * pState, int32_t min, int32_t max)
+{
+    return min + (int32_t) (TEST_rand(pState) % ((uint32_t) (max - min) + 1U));
+}
+
+#endif // TEST_HOST_H
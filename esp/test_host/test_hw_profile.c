@@ -0,0 +1,89 @@
+
+#include "config.h"
+#include "hw_profile.h"
+
+#include "fakes.h"
+#include "test_host.h"
+
+static void testList(void)
+{
+    for (HwProfileId_e id = HW_PROFILE_ID_ADA; id < HW_PROFILE_ID_NB; id += 1)
+    {
+        const HwProfile_t * pProfile = HW_PROFILE_get(id);
+
+        CHECK(pProfile == &HW_PROFILE_LIST[id]);
+        CHECK_EQ(HW_PROFILE_check(pProfile), 0U);
+    }
+
+    CHECK(HW_PROFILE_get(HW_PROFILE_ID_NB) == NULL);
+    CHECK_EQ(HW_PROFILE_check(NULL), 1U);
+    CHECK_EQ(HW_PROFILE_select(), HW_PROFILE_DFLT);
+}
+
+// Any calibration HW_PROFILE_AXIS_CHECK accepts maps correctly
+static void testRandom(uint32_t seed)
+{
+    uint32_t rng = TEST_seed(seed);
+
+    for (uint32_t i = 0U; i < 2000U; i++)
+    {
+        int32_t dz = TEST_randRange(&rng, 0, 400);
+        int32_t center = TEST_randRange(&rng, dz / 2 + 1, HW_PROFILE_RAW_MAX - dz / 2 - 1);
+        int32_t min = TEST_randRange(&rng, 0, center - dz / 2 - 1);
+        int32_t max = TEST_randRange(&rng, center + dz / 2 + 1, HW_PROFILE_RAW_MAX);
+        int8_t sign = (TEST_rand(&rng) & 1U) ? 1 : -1;
+        const HwProfile_t profile =
+        {
+            .sName = "random",
+            .x = HW_PROFILE_AXIS(0U, min, center, max, dz, sign),
+            .y = HW_PROFILE_AXIS(1U, min, center, max, dz, -sign),
+        };
+
+        CHECK(HW_PROFILE_AXIS_VALID(min, center, max, dz, sign));
+        if (HW_PROFILE_check(&profile))
+        {
+            printf("min %d, center %d, max %d, deadzone %d\n", min, center, max, dz);
+            CHECK(0);
+        }
+
+        // Opposite signs mirror each other
+        for (int32_t raw = 0; raw <= HW_PROFILE_RAW_MAX; raw += 97)
+        {
+            CHECK_EQ(HW_PROFILE_map(&profile.x, raw) + HW_PROFILE_map(&profile.y, raw), 2 * HW_PROFILE_OUT_CENTER);
+        }
+    }
+}
+
+static void testBroken(void)
+{
+    HwProfile_t profile = HW_PROFILE_LIST[HW_PROFILE_ID_ADA];
+    uint32_t errNb = FAKE_getLogNb(LOG_LVL_ERROR);
+
+    // Slope too steep, the end point overshoots the output range
+    profile.y.highSlope *= 2;
+    CHECK_EQ(HW_PROFILE_check(&profile), 1U);
+
+    // Calibration edited without deriving the slope again
+    profile = HW_PROFILE_LIST[HW_PROFILE_ID_ADA];
+    profile.x.max += 400;
+    CHECK_EQ(HW_PROFILE_check(&profile), 1U);
+
+    profile = HW_PROFILE_LIST[HW_PROFILE_ID_ADA];
+    profile.x.lowSlope = 0;
+    CHECK_EQ(HW_PROFILE_check(&profile), 1U);
+
+    CHECK_EQ(FAKE_getLogNb(LOG_LVL_ERROR), errNb + 3U);
+}
+
+int main(void)
+{
+    FAKE_reset();
+
+    testList();
+    testRandom(4U);
+    testBroken();
+
+    printf("OK\n");
+
+    return 0;
+}
@@ -0,0 +1,179 @@
+
+#include <string.h>
+
+#include "config.h"
+#include "mouse.h"
+
+#include "fakes.h"
+#include "mock_transport.h"
+#include "test_host.h"
+
+#define REPORT_ID_MOUSE 2U
+
+typedef struct Capture_t
+{
+    uint32_t nb;
+    int64_t x;
+    int64_t y;
+} Capture_t;
+
+static Capture_t g_cap;
+
+static void onReport(uint8_t reportId, const uint8_t * pReport, uint16_t len, void * pArg)
+{
+    if (reportId != REPORT_ID_MOUSE)
+    {
+        return;
+    }
+
+    g_cap.nb++;
+    g_cap.x += (int8_t) pReport[1];
+    g_cap.y += (int8_t) pReport[2];
+}
+
+static Mouse_t * setup(void)
+{
+    Transport_t * pTransport = NULL;
+    Mouse_t * pMouse = NULL;
+
+    FAKE_reset();
+    FAKE_setTimeUs(1000000);
+    MOCK_reset();
+    g_mock.onReport = onReport;
+    memset(&g_cap, 0, sizeof(g_cap));
+
+    pTransport = TRANSPORT_init(TRANSPORT_ID_USB);
+    CHECK(pTransport);
+    pMouse = MOUSE_init(pTransport, 1U, MOUSE_PERSO_MOUSE);
+    CHECK(pMouse);
+
+    return pMouse;
+}
+
+static MouseStats_t statsGet(Mouse_t * pMouse)
+{
+    MouseStats_t stats;
+
+    CHECK_EQ(MOUSE_getStats(pMouse, &stats), 0U);
+    CHECK_EQ(stats.moveOut.x, g_cap.x);
+    CHECK_EQ(stats.moveOut.y, g_cap.y);
+
+    return stats;
+}
+
+// Motion merged while the endpoint is busy goes out from the completion, no MOUSE_flush
+static void testCoalesced(void)
+{
+    MouseStats_t stats;
+    Mouse_t * pMouse = setup();
+
+    CHECK_EQ(MOUSE_move(pMouse, 5, -5), 0U);
+    CHECK_EQ(g_cap.nb, 1U);
+
+    CHECK_EQ(MOUSE_move(pMouse, 3, 1), 0U);
+    CHECK_EQ(MOUSE_move(pMouse, 4, 2), 0U);
+    stats = statsGet(pMouse);
+    CHECK_EQ(g_cap.nb, 1U);
+    CHECK_EQ(stats.coalescedNb, 1U);
+    CHECK_EQ(stats.reportDoneNb, 0U);
+
+    CHECK_EQ(MOCK_complete(), 1U);
+    stats = statsGet(pMouse);
+    CHECK_EQ(g_cap.nb, 2U);
+    CHECK_EQ(g_cap.x, 12);
+    CHECK_EQ(g_cap.y, -2);
+    CHECK_EQ(stats.moveIn.x, stats.moveOut.x);
+    CHECK_EQ(stats.moveIn.y, stats.moveOut.y);
+    CHECK_EQ(stats.reportDoneNb, 1U);
+
+    // Nothing left, the endpoint stays idle
+    CHECK_EQ(MOCK_complete(), 1U);
+    stats = statsGet(pMouse);
+    CHECK_EQ(g_cap.nb, 2U);
+    CHECK_EQ(stats.reportDoneNb, 1U);
+    CHECK_EQ(MOCK_complete(), 0U);
+    CHECK_EQ(stats.doneMissNb, 0U);
+}
+
+// Random motion, completions only, each completion sending what built up
+static void testCompletions(uint32_t seed)
+{
+    uint32_t rng = TEST_seed(seed);
+    MouseStats_t stats;
+    Mouse_t * pMouse = setup();
+    uint32_t doneNb = 0U;
+    uint32_t loopNb = 0U;
+
+    for (uint32_t i = 0U; i < 50000U; i++)
+    {
+        if (TEST_rand(&rng) & 1U)
+        {
+            CHECK_EQ(MOUSE_move(pMouse, TEST_randRange(&rng, -300, 300), TEST_randRange(&rng, -300, 300)), 0U);
+        }
+        else
+        {
+            doneNb = statsGet(pMouse).reportDoneNb;
+            if (MOCK_complete())
+            {
+                // Advances when the completion found something to send
+                stats = statsGet(pMouse);
+                CHECK_EQ(stats.reportDoneNb - doneNb, g_mock.bBusy ? 1U : 0U);
+            }
+        }
+        FAKE_advanceUs(TEST_randRange(&rng, 0, 2000));
+    }
+
+    while (MOCK_complete())
+    {
+        CHECK(++loopNb < 1000U);
+    }
+
+    stats = statsGet(pMouse);
+    CHECK_EQ(stats.moveIn.x, stats.moveOut.x);
+    CHECK_EQ(stats.moveIn.y, stats.moveOut.y);
+    CHECK(stats.reportDoneNb > 0U);
+    CHECK_EQ(stats.reportNb, g_cap.nb);
+    CHECK_EQ(stats.doneMissNb, 0U);
+    printf("%" PRIu32 " reports, %" PRIu32 " from completions, %" PRIu32 " coalesced\n",
+        stats.reportNb, stats.reportDoneNb, stats.coalescedNb);
+}
+
+// Completion runs while the sender holds the mutex : counted, not blocking, sent by the next flush
+static void testCompleteInSend(void)
+{
+    MouseStats_t stats;
+    Mouse_t * pMouse = setup();
+    uint32_t loopNb = 0U;
+
+    g_mock.bCompleteInSend = 1U;
+
+    CHECK_EQ(MOUSE_move(pMouse, 1000, 0), 0U);
+    stats = statsGet(pMouse);
+    CHECK_EQ(g_cap.nb, 1U);
+    CHECK_EQ(stats.doneMissNb, 1U);
+    CHECK_EQ(FAKE_getMutexBusyNb(), 1U);
+    CHECK_EQ(stats.reportDoneNb, 0U);
+
+    while (g_cap.x != 1000)
+    {
+        CHECK_EQ(MOUSE_flush(pMouse), 0U);
+        CHECK(++loopNb < 100U);
+    }
+
+    stats = statsGet(pMouse);
+    CHECK_EQ(stats.moveIn.x, stats.moveOut.x);
+    CHECK_EQ(g_cap.nb, (1000U + 126U) / 127U);
+    CHECK_EQ(stats.doneMissNb, g_cap.nb);
+    CHECK_EQ(stats.reportDoneNb, 0U);
+}
+
+int main(void)
+{
+    testCoalesced();
+    testCompletions(5U);
+    testCompleteInSend();
+
+    printf("OK\n");
+
+    return 0;
+}
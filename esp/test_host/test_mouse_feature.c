@@ -0,0 +1,369 @@
+
+#include <string.h>
+
+#include "config.h"
+#include "mouse.h"
+
+#include "fakes.h"
+#include "mock_transport.h"
+#include "test_host.h"
+
+#define REPORT_ID_MOUSE   2U
+#define REPORT_ID_ABS     3U
+#define REPORT_ID_GAMEPAD 4U
+
+#define USAGE_PAGE_DESKTOP 0x01U
+#define USAGE_RES_MULT     0x48U
+
+// Scroll units per detent
+#define DETENT ((int16_t) MOUSE_SCROLL_RES_MULT)
+
+// Report sizes, per report ID, as a host parses the descriptor
+typedef struct DescInfo_t
+{
+    uint32_t pInBits[256];
+    uint32_t pFeatureBits[256];
+    // Resolution multiplier fields, 2 bits, physical 1..MOUSE_SCROLL_RES_MULT
+    uint32_t resMultNb;
+} DescInfo_t;
+
+typedef struct RelCapture_t
+{
+    uint32_t nb;
+    int32_t wheel;
+    int32_t pan;
+} RelCapture_t;
+
+static void descParse(const uint8_t * pDesc, uint16_t len, DescInfo_t * pInfo)
+{
+    uint32_t usagePage = 0U;
+    uint32_t reportSize = 0U;
+    uint32_t reportCount = 0U;
+    uint32_t reportId = 0U;
+    int32_t phyMin = 0;
+    int32_t phyMax = 0;
+    uint8_t bResMultUsage = 0U;
+    int32_t depth = 0;
+    uint16_t i = 0U;
+
+    memset(pInfo, 0, sizeof(*pInfo));
+
+    while (i < len)
+    {
+        uint8_t prefix = pDesc[i];
+        uint8_t size = (prefix & 0x03U) == 3U ? 4U : (prefix & 0x03U);
+        uint8_t type = (prefix >> 2) & 0x03U;
+        uint8_t tag = prefix >> 4;
+        uint32_t data = 0U;
+        int32_t sData = 0;
+
+        CHECK(i + 1U + size <= len);
+
+        for (uint8_t k = 0U; k < size; k++)
+        {
+            data |= (uint32_t) pDesc[i + 1U + k] << (8U * k);
+        }
+
+        sData = (size == 1U) ? (int8_t) data : (size == 2U) ? (int16_t) data : (int32_t) data;
+        i += 1U + size;
+
+        if (type == 0U)
+        {
+            if (tag == 8U)
+            {
+                pInfo->pInBits[reportId] += reportSize * reportCount;
+            }
+            else if (tag == 11U)
+            {
+                pInfo->pFeatureBits[reportId] += reportSize * reportCount;
+                if (bResMultUsage)
+                {
+                    CHECK_EQ(reportSize * reportCount, 2U);
+                    CHECK_EQ(phyMin, 1);
+                    CHECK_EQ(phyMax, MOUSE_SCROLL_RES_MULT);
+                    pInfo->resMultNb++;
+                }
+            }
+            else if (tag == 10U)
+            {
+                depth++;
+            }
+            else if (tag == 12U)
+            {
+                depth--;
+                CHECK(depth >= 0);
+            }
+
+            bResMultUsage = 0U;
+        }
+        else if (type == 1U)
+        {
+            switch (tag)
+            {
+                case 0U: usagePage = data; break;
+                case 3U: phyMin = sData; break;
+                case 4U: phyMax = sData; break;
+                case 7U: reportSize = data; break;
+                case 8U: reportId = data; CHECK((reportId > 0U) && (reportId < 256U)); break;
+                case 9U: reportCount = data; break;
+                default: break;
+            }
+        }
+        else if ((type == 2U) && (tag == 0U))
+        {
+            if ((usagePage == USAGE_PAGE_DESKTOP) && (data == USAGE_RES_MULT))
+            {
+                bResMultUsage = 1U;
+            }
+        }
+    }
+
+    CHECK_EQ(depth, 0);
+}
+
+static void onReport(uint8_t reportId, const uint8_t * pReport, uint16_t len, void * pArg)
+{
+    RelCapture_t * pCap = pArg;
+
+    if (reportId != REPORT_ID_MOUSE)
+    {
+        return;
+    }
+
+    CHECK_EQ(len, 5U);
+    pCap->nb++;
+    pCap->wheel += (int8_t) pReport[3];
+    pCap->pan += (int8_t) pReport[4];
+}
+
+static uint8_t featureGet(void)
+{
+    uint8_t buf[4] = { 0xAA, 0xAA, 0xAA, 0xAA };
+
+    CHECK_EQ(g_mock.conf.getFeature(REPORT_ID_MOUSE, buf, sizeof(buf)), 1U);
+
+    return buf[0];
+}
+
+static void featureSet(uint8_t val)
+{
+    g_mock.conf.setFeature(REPORT_ID_MOUSE, &val, 1U);
+}
+
+static Mouse_t * setup(MousePersonality_e perso, RelCapture_t * pCap)
+{
+    Transport_t * pTransport = NULL;
+    Mouse_t * pMouse = NULL;
+
+    FAKE_reset();
+    MOCK_reset();
+    // Always ready, one report per scroll call
+    g_mock.bHold = 0U;
+    g_mock.onReport = onReport;
+    g_mock.pOnReportArg = pCap;
+    memset(pCap, 0, sizeof(*pCap));
+
+    pTransport = TRANSPORT_init(TRANSPORT_ID_USB);
+    CHECK(pTransport);
+    pMouse = MOUSE_init(pTransport, 1U, perso);
+    CHECK(pMouse);
+    CHECK(g_mock.conf.getFeature && g_mock.conf.setFeature && g_mock.conf.hostReset);
+
+    return pMouse;
+}
+
+static void testDescriptors(void)
+{
+    RelCapture_t cap;
+    DescInfo_t info;
+
+    setup(MOUSE_PERSO_MOUSE, &cap);
+    descParse(g_mock.conf.pReportDesc, g_mock.conf.reportDescLen, &info);
+    CHECK_EQ(info.pInBits[REPORT_ID_MOUSE], 5U * 8U);
+    CHECK_EQ(info.pFeatureBits[REPORT_ID_MOUSE], 8U * 1U);
+    CHECK_EQ(info.resMultNb, 2U);
+    CHECK_EQ(info.pInBits[REPORT_ID_ABS], 5U * 8U);
+    CHECK_EQ(info.pInBits[REPORT_ID_GAMEPAD], 0U);
+
+    setup(MOUSE_PERSO_GAMEPAD, &cap);
+    descParse(g_mock.conf.pReportDesc, g_mock.conf.reportDescLen, &info);
+    CHECK_EQ(info.pInBits[REPORT_ID_GAMEPAD], 5U * 8U);
+    CHECK_EQ(info.pFeatureBits[REPORT_ID_MOUSE], 0U);
+    CHECK_EQ(info.resMultNb, 0U);
+
+    setup(MOUSE_PERSO_COMBINED, &cap);
+    descParse(g_mock.conf.pReportDesc, g_mock.conf.reportDescLen, &info);
+    CHECK_EQ(info.pInBits[REPORT_ID_MOUSE], 5U * 8U);
+    CHECK_EQ(info.pFeatureBits[REPORT_ID_MOUSE], 8U * 1U);
+    CHECK_EQ(info.pInBits[REPORT_ID_ABS], 5U * 8U);
+    CHECK_EQ(info.pInBits[REPORT_ID_GAMEPAD], 5U * 8U);
+}
+
+static void testFeatureRoundTrip(void)
+{
+    RelCapture_t cap;
+    uint8_t buf[1] = { 0xAA };
+    uint8_t val = 0x05U;
+
+    setup(MOUSE_PERSO_MOUSE, &cap);
+
+    CHECK_EQ(featureGet(), 0x00U);
+
+    for (uint32_t i = 0U; i < 16U; i++)
+    {
+        featureSet((uint8_t) i);
+        CHECK_EQ(featureGet(), i);
+    }
+
+    // Padding bits are not stored
+    featureSet(0xFFU);
+    CHECK_EQ(featureGet(), 0x0FU);
+
+    // Other report IDs and short requests are not ours
+    CHECK_EQ(g_mock.conf.getFeature(REPORT_ID_ABS, buf, sizeof(buf)), 0U);
+    CHECK_EQ(g_mock.conf.getFeature(REPORT_ID_MOUSE, buf, 0U), 0U);
+    g_mock.conf.setFeature(REPORT_ID_ABS, &val, 1U);
+    g_mock.conf.setFeature(REPORT_ID_MOUSE, &val, 0U);
+    CHECK_EQ(featureGet(), 0x0FU);
+}
+
+static void testWheelScale(void)
+{
+    RelCapture_t cap;
+    Mouse_t * pMouse = setup(MOUSE_PERSO_MOUSE, &cap);
+
+    // Default : 1 unit per detent, remainder kept
+    CHECK_EQ(MOUSE_scroll(pMouse, 3 * DETENT, -2 * DETENT), 0U);
+    CHECK_EQ(cap.wheel, 3);
+    CHECK_EQ(cap.pan, -2);
+
+    CHECK_EQ(MOUSE_scroll(pMouse, DETENT - 1, 0), 0U);
+    CHECK_EQ(cap.wheel, 3);
+    CHECK_EQ(MOUSE_scroll(pMouse, 1, 0), 0U);
+    CHECK_EQ(cap.wheel, 4);
+
+    // Wheel multiplier only : wheel in 1 / MOUSE_SCROLL_RES_MULT detent, pan still in detents
+    featureSet(0x01U);
+    memset(&cap, 0, sizeof(cap));
+    CHECK_EQ(MOUSE_scroll(pMouse, 5, DETENT), 0U);
+    CHECK_EQ(cap.wheel, 5);
+    CHECK_EQ(cap.pan, 1);
+
+    // Both
+    featureSet(0x05U);
+    memset(&cap, 0, sizeof(cap));
+    CHECK_EQ(MOUSE_scroll(pMouse, -7, 3), 0U);
+    CHECK_EQ(cap.wheel, -7);
+    CHECK_EQ(cap.pan, 3);
+}
+
+static void testReset(void)
+{
+    RelCapture_t cap;
+    Mouse_t * pMouse = setup(MOUSE_PERSO_MOUSE, &cap);
+
+    // Unplug, bus reset : next host starts from 1 unit per detent
+    featureSet(0x05U);
+    g_mock.conf.hostReset();
+    CHECK_EQ(featureGet(), 0x00U);
+
+    CHECK_EQ(MOUSE_scroll(pMouse, 5, 0), 0U);
+    CHECK_EQ(cap.nb, 0U);
+    CHECK_EQ(MOUSE_scroll(pMouse, DETENT - 5, 0), 0U);
+    CHECK_EQ(cap.wheel, 1);
+
+    // Personality change enumerates again
+    featureSet(0x05U);
+    MOUSE_setPersonality(pMouse, MOUSE_PERSO_COMBINED);
+    CHECK_EQ(g_mock.setReportDescNb, 1U);
+    CHECK_EQ(featureGet(), 0x00U);
+
+    // Same personality, nothing re-enumerated, feature kept
+    featureSet(0x05U);
+    MOUSE_setPersonality(pMouse, MOUSE_PERSO_COMBINED);
+    CHECK_EQ(g_mock.setReportDescNb, 1U);
+    CHECK_EQ(featureGet(), 0x05U);
+
+    // Hi-res backlog left at reset : whole detents go out, sub-detent units are dropped
+    featureSet(0x05U);
+    memset(&cap, 0, sizeof(cap));
+    CHECK_EQ(MOUSE_scroll(pMouse, 4 * DETENT + 9 + 127, 0), 0U);
+    CHECK_EQ(cap.wheel, 127);
+    g_mock.conf.hostReset();
+    CHECK_EQ(MOUSE_flush(pMouse), 0U);
+    CHECK_EQ(cap.wheel, 127 + 4);
+    CHECK_EQ(pMouse->scrollAcc.y, 0);
+
+    // No stale offset on the next host scroll
+    CHECK_EQ(MOUSE_scroll(pMouse, DETENT - 9, 0), 0U);
+    CHECK_EQ(cap.wheel, 127 + 4);
+    CHECK_EQ(pMouse->scrollAcc.y, DETENT - 9);
+
+    // Same on a personality change, sub-detent backlog no longer pending
+    featureSet(0x05U);
+    CHECK_EQ(MOUSE_scroll(pMouse, 127 + 3, -(127 + 3 * DETENT + 2)), 0U);
+    MOUSE_setPersonality(pMouse, MOUSE_PERSO_MOUSE);
+    CHECK_EQ(MOUSE_flush(pMouse), 0U);
+    CHECK_EQ(pMouse->scrollAcc.y, 0);
+    CHECK_EQ(pMouse->scrollAcc.x, 0);
+}
+
+static uint32_t g_descMissNb = 0U;
+
+// Completion from the stack task during re-enumeration, must find the mouse state locked
+static void onSetReportDesc(void)
+{
+    uint32_t busyNb = FAKE_getMutexBusyNb();
+
+    g_mock.conf.sendDone();
+    g_descMissNb += FAKE_getMutexBusyNb() - busyNb;
+}
+
+static void testPersonalityLocked(void)
+{
+    RelCapture_t cap;
+    MouseStats_t stats;
+    Mouse_t * pMouse = setup(MOUSE_PERSO_COMBINED, &cap);
+
+    g_descMissNb = 0U;
+    g_mock.onSetReportDesc = onSetReportDesc;
+
+    // Endpoint busy, motion and gamepad pending across the change
+    g_mock.bHold = 1U;
+    CHECK_EQ(MOUSE_move(pMouse, 10, 0), 0U);
+    CHECK_EQ(MOUSE_move(pMouse, 300, -20), 0U);
+    CHECK_EQ(MOUSE_gamepad(pMouse, 100, 0, 0U), 0U);
+    CHECK_EQ(MOUSE_scroll(pMouse, 7, 0), 0U);
+
+    MOUSE_setPersonality(pMouse, MOUSE_PERSO_GAMEPAD);
+    CHECK_EQ(g_descMissNb, 1U);
+
+    // Relative backlog dropped, out of moveIn too, gamepad still pending
+    CHECK_EQ(MOUSE_getStats(pMouse, &stats), 0U);
+    CHECK_EQ(pMouse->moveAcc.x, 0);
+    CHECK_EQ(pMouse->scrollAcc.y, 0);
+    CHECK_EQ(stats.moveIn.x, stats.moveOut.x);
+    CHECK_EQ(stats.moveIn.y, stats.moveOut.y);
+    CHECK_EQ(pMouse->bGamepadDirty, 1U);
+
+    // Gamepad pending dropped on the way back to a mouse only descriptor
+    CHECK_EQ(MOUSE_gamepad(pMouse, 200, 0, 0U), 0U);
+    MOUSE_setPersonality(pMouse, MOUSE_PERSO_MOUSE);
+    CHECK_EQ(g_descMissNb, 2U);
+    CHECK_EQ(pMouse->bGamepadDirty, 0U);
+
+    g_mock.onSetReportDesc = NULL;
+}
+
+int main(void)
+{
+    testDescriptors();
+    testFeatureRoundTrip();
+    testWheelScale();
+    testReset();
+    testPersonalityLocked();
+
+    printf("OK\n");
+
+    return 0;
+}
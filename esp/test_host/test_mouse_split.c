@@ -0,0 +1,324 @@
+
+#include <string.h>
+
+#include "esp_timer.h"
+
+#include "config.h"
+#include "mouse.h"
+
+#include "fakes.h"
+#include "mock_transport.h"
+#include "test_host.h"
+
+#define REPORT_ID_MOUSE   2U
+#define REPORT_ID_GAMEPAD 4U
+
+#define BLE_INTERVAL_US 7500U
+
+// Relative reports as the host sees them
+typedef struct RelCapture_t
+{
+    uint32_t nb;
+    int64_t x;
+    int64_t y;
+    int64_t lastUs;
+    // Shortest time between two reports of any kind
+    int64_t gapMinUs;
+} RelCapture_t;
+
+static RelCapture_t g_cap;
+
+static void onReport(uint8_t reportId, const uint8_t * pReport, uint16_t len, void * pArg)
+{
+    int64_t nowUs = esp_timer_get_time();
+
+    if ((g_mock.sendNb > 1U) && (nowUs - g_cap.lastUs < g_cap.gapMinUs))
+    {
+        g_cap.gapMinUs = nowUs - g_cap.lastUs;
+    }
+    g_cap.lastUs = nowUs;
+
+    if (reportId != REPORT_ID_MOUSE)
+    {
+        return;
+    }
+
+    CHECK_EQ(len, 5U);
+    // clamp8 keeps -128 out, symmetric range
+    CHECK(((int8_t) pReport[1] >= -127) && ((int8_t) pReport[2] >= -127));
+    g_cap.nb++;
+    g_cap.x += (int8_t) pReport[1];
+    g_cap.y += (int8_t) pReport[2];
+}
+
+static Mouse_t * setup(MousePersonality_e perso, TransportId_e id)
+{
+    Transport_t * pTransport = NULL;
+    Mouse_t * pMouse = NULL;
+
+    FAKE_reset();
+    FAKE_setTimeUs(1000000);
+    MOCK_reset();
+    g_mock.onReport = onReport;
+    memset(&g_cap, 0, sizeof(g_cap));
+    g_cap.gapMinUs = INT64_MAX;
+
+    if (id == TRANSPORT_ID_BLE)
+    {
+        // Always ready while connected, paced by the connection interval
+        g_mock.bHold = 0U;
+        g_mock.intervalUs = BLE_INTERVAL_US;
+    }
+
+    pTransport = TRANSPORT_init(id);
+    CHECK(pTransport);
+    pMouse = MOUSE_init(pTransport, 1U, perso);
+    CHECK(pMouse);
+
+    return pMouse;
+}
+
+static MouseStats_t statsGet(Mouse_t * pMouse)
+{
+    MouseStats_t stats;
+
+    CHECK_EQ(MOUSE_getStats(pMouse, &stats), 0U);
+
+    // Backlog is what was taken and not sent yet
+    CHECK_EQ((int32_t) ((uint32_t) stats.moveIn.x - (uint32_t) stats.moveOut.x), pMouse->moveAcc.x);
+    CHECK_EQ((int32_t) ((uint32_t) stats.moveIn.y - (uint32_t) stats.moveOut.y), pMouse->moveAcc.y);
+    CHECK((pMouse->moveAcc.x >= -MOUSE_MOVE_ACC_MAX) && (pMouse->moveAcc.x <= MOUSE_MOVE_ACC_MAX));
+    CHECK((pMouse->moveAcc.y >= -MOUSE_MOVE_ACC_MAX) && (pMouse->moveAcc.y <= MOUSE_MOVE_ACC_MAX));
+    CHECK_EQ(stats.moveOut.x, g_cap.x);
+    CHECK_EQ(stats.moveOut.y, g_cap.y);
+
+    return stats;
+}
+
+static void testSplitUsb(void)
+{
+    MouseStats_t stats;
+    Mouse_t * pMouse = setup(MOUSE_PERSO_MOUSE, TRANSPORT_ID_USB);
+
+    // First part goes at once, the endpoint is then busy until the host polls
+    CHECK_EQ(MOUSE_move(pMouse, 1000, -700), 0U);
+    CHECK_EQ(g_cap.nb, 1U);
+    CHECK_EQ(g_cap.x, 127);
+    CHECK_EQ(g_cap.y, -127);
+
+    // Each completion sends the next part
+    while (MOCK_complete())
+    {
+        FAKE_advanceUs(1000);
+    }
+
+    stats = statsGet(pMouse);
+    CHECK_EQ(g_cap.x, 1000);
+    CHECK_EQ(g_cap.y, -700);
+    CHECK_EQ(g_cap.nb, (1000U + 126U) / 127U);
+    CHECK_EQ(stats.reportNb, g_cap.nb);
+    CHECK_EQ(stats.splitNb, g_cap.nb - 1U);
+    CHECK_EQ(stats.clipNb, 0U);
+    CHECK_EQ(stats.coalescedNb, 0U);
+}
+
+static void testLatency(void)
+{
+    MouseStats_t stats;
+    Mouse_t * pMouse = setup(MOUSE_PERSO_MOUSE, TRANSPORT_ID_USB);
+
+    // Sent at once
+    CHECK_EQ(MOUSE_move(pMouse, 300, 0), 0U);
+    CHECK_EQ(statsGet(pMouse).latencyMaxUs, 0U);
+
+    // Remainder waits for the endpoint, counted from the previous part
+    FAKE_advanceUs(1000);
+    CHECK_EQ(MOCK_complete(), 1U);
+    CHECK_EQ(statsGet(pMouse).latencyMaxUs, 1000U);
+
+    FAKE_advanceUs(3000);
+    CHECK_EQ(MOCK_complete(), 1U);
+    stats = statsGet(pMouse);
+    CHECK_EQ(stats.latencyMaxUs, 3000U);
+    CHECK_EQ(g_cap.x, 300);
+
+    // Last part delivered, nothing left
+    CHECK_EQ(MOCK_complete(), 1U);
+    CHECK_EQ(g_cap.nb, 3U);
+
+    // Motion arriving while busy waits from its own arrival, merged with later motion
+    g_mock.bBusy = 1U;
+    CHECK_EQ(MOUSE_move(pMouse, 1, 0), 0U);
+    FAKE_advanceUs(6000);
+    CHECK_EQ(MOUSE_move(pMouse, 2, 0), 0U);
+    FAKE_advanceUs(4000);
+    CHECK_EQ(MOCK_complete(), 1U);
+    stats = statsGet(pMouse);
+    CHECK_EQ(g_cap.nb, 4U);
+    CHECK_EQ(g_cap.x, 303);
+    CHECK_EQ(stats.latencyMaxUs, 10000U);
+    CHECK_EQ(stats.coalescedNb, 1U);
+}
+
+static void testPacingBle(void)
+{
+    MouseStats_t stats;
+    Mouse_t * pMouse = setup(MOUSE_PERSO_MOUSE, TRANSPORT_ID_BLE);
+    uint32_t cycleNb = 0U;
+
+    // One part per connection interval, not a back to back burst
+    CHECK_EQ(MOUSE_move(pMouse, 1000, 0), 0U);
+    CHECK_EQ(g_cap.nb, 1U);
+
+    FAKE_advanceUs(BLE_INTERVAL_US - 1U);
+    CHECK_EQ(MOUSE_flush(pMouse), 0U);
+    CHECK_EQ(g_cap.nb, 1U);
+
+    while (g_cap.x != 1000)
+    {
+        FAKE_advanceUs(1000);
+        CHECK_EQ(MOUSE_flush(pMouse), 0U);
+        CHECK(++cycleNb < 1000U);
+    }
+
+    stats = statsGet(pMouse);
+    CHECK_EQ(g_cap.nb, (1000U + 126U) / 127U);
+    CHECK_EQ(stats.splitNb, g_cap.nb - 1U);
+    CHECK(g_cap.gapMinUs >= BLE_INTERVAL_US);
+}
+
+static void testTurnsBle(void)
+{
+    Mouse_t * pMouse = setup(MOUSE_PERSO_COMBINED, TRANSPORT_ID_BLE);
+    int64_t moveX = 0;
+
+    // Gamepad changing every cycle, motion still goes out
+    for (int16_t i = 1; i <= 200; i++)
+    {
+        CHECK_EQ(MOUSE_move(pMouse, 3, 0), 0U);
+        moveX += 3;
+        CHECK_EQ(MOUSE_gamepad(pMouse, i, -i, 0U), 0U);
+        CHECK_EQ(MOUSE_flush(pMouse), 0U);
+        FAKE_advanceUs(BLE_INTERVAL_US);
+    }
+
+    CHECK(g_cap.gapMinUs >= BLE_INTERVAL_US);
+    CHECK(g_mock.pReportNb[REPORT_ID_GAMEPAD] >= 90U);
+    CHECK(g_cap.nb >= 90U);
+
+    for (uint32_t i = 0U; i < 4U; i++)
+    {
+        CHECK_EQ(MOUSE_flush(pMouse), 0U);
+        FAKE_advanceUs(BLE_INTERVAL_US);
+    }
+
+    CHECK_EQ(g_cap.x, moveX);
+    statsGet(pMouse);
+}
+
+// Scroll below one detent (low resolution, host never set the multiplier) holds no other report back
+static void testSubDetentBle(void)
+{
+    Mouse_t * pMouse = setup(MOUSE_PERSO_COMBINED, TRANSPORT_ID_BLE);
+    uint32_t gamepadNb = 0U;
+
+    CHECK_EQ(MOUSE_scroll(pMouse, 5, 0), 0U);
+    CHECK_EQ(g_mock.sendNb, 0U);
+
+    for (int16_t i = 1; i <= 99; i++)
+    {
+        FAKE_advanceUs(BLE_INTERVAL_US);
+        CHECK_EQ(MOUSE_gamepad(pMouse, i, 0, 0U), 0U);
+    }
+
+    CHECK_EQ(g_mock.pReportNb[REPORT_ID_GAMEPAD], 99U);
+    CHECK_EQ(g_cap.nb, 0U);
+
+    // Completes the detent, goes out as one wheel unit
+    gamepadNb = g_mock.pReportNb[REPORT_ID_GAMEPAD];
+    FAKE_advanceUs(BLE_INTERVAL_US);
+    CHECK_EQ(MOUSE_scroll(pMouse, (int16_t) MOUSE_SCROLL_RES_MULT - 5, 0), 0U);
+    CHECK_EQ(g_cap.nb, 1U);
+    CHECK_EQ((int8_t) g_mock.pLast[3], 1);
+    CHECK_EQ(pMouse->scrollAcc.y, 0);
+
+    FAKE_advanceUs(BLE_INTERVAL_US);
+    CHECK_EQ(MOUSE_gamepad(pMouse, 0, 0, 0U), 0U);
+    CHECK_EQ(g_mock.pReportNb[REPORT_ID_GAMEPAD], gamepadNb + 1U);
+}
+
+// Random motion, endpoint polling and timing, motion conserved at every step
+static void testRandom(TransportId_e id, uint32_t seed)
+{
+    uint32_t rng = TEST_seed(seed);
+    Mouse_t * pMouse = setup(MOUSE_PERSO_MOUSE, id);
+    MouseStats_t stats;
+    int64_t reqX = 0;
+    int64_t reqY = 0;
+    uint32_t loopNb = 0U;
+
+    for (uint32_t i = 0U; i < 200000U; i++)
+    {
+        uint32_t op = TEST_rand(&rng) % 8U;
+
+        if (op < 4U)
+        {
+            int32_t range = (op == 0U) ? 5000 : 200;
+            int32_t x = TEST_randRange(&rng, -range, range);
+            int32_t y = TEST_randRange(&rng, -range, range);
+
+            reqX += x;
+            reqY += y;
+            CHECK_EQ(MOUSE_move(pMouse, x, y), 0U);
+        }
+        else if (op < 6U)
+        {
+            MOCK_complete();
+        }
+        else if (op == 6U)
+        {
+            CHECK_EQ(MOUSE_flush(pMouse), 0U);
+        }
+
+        FAKE_advanceUs(TEST_randRange(&rng, 0, 3000));
+        statsGet(pMouse);
+    }
+
+    // Drain
+    while ((pMouse->moveAcc.x != 0) || (pMouse->moveAcc.y != 0))
+    {
+        FAKE_advanceUs(BLE_INTERVAL_US);
+        MOCK_complete();
+        CHECK_EQ(MOUSE_flush(pMouse), 0U);
+        CHECK(++loopNb < 1000U);
+    }
+
+    stats = statsGet(pMouse);
+    CHECK_EQ(stats.moveIn.x, stats.moveOut.x);
+    CHECK_EQ(stats.moveIn.y, stats.moveOut.y);
+
+    // Only what the backlog bound refused is missing
+    CHECK((stats.clipNb == 0U) == ((g_cap.x == reqX) && (g_cap.y == reqY)));
+    if (id == TRANSPORT_ID_BLE)
+    {
+        CHECK(g_cap.gapMinUs >= BLE_INTERVAL_US);
+    }
+    printf("%s : %" PRIu32 " reports, %" PRIu32 " split, %" PRIu32 " coalesced, %" PRIu32 " clipped, latency max %" PRIu32 " us\n",
+        (id == TRANSPORT_ID_BLE) ? "ble" : "usb", stats.reportNb, stats.splitNb, stats.coalescedNb, stats.clipNb,
+        stats.latencyMaxUs);
+}
+
+int main(void)
+{
+    testSplitUsb();
+    testLatency();
+    testPacingBle();
+    testTurnsBle();
+    testSubDetentBle();
+    testRandom(TRANSPORT_ID_USB, 1U);
+    testRandom(TRANSPORT_ID_BLE, 2U);
+
+    printf("OK\n");
+
+    return 0;
+}
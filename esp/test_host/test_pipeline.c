@@ -0,0 +1,393 @@
+
+#include <string.h>
+#include <time.h>
+
+#include "esp_timer.h"
+
+#include "config.h"
+#include "controller.h"
+#include "hw_profile.h"
+#include "mouse.h"
+#include "predict.h"
+
+#include "fakes.h"
+#include "mock_transport.h"
+#include "test_host.h"
+
+#define REPORT_ID_MOUSE 2U
+
+// Largest |motion| CONTROLLER_toMotion gives from the output range
+#define MOTION_MAX ((X_OUT_MAX - X_OUT_CENTER - DEADZONE) / 3)
+
+typedef enum AdcKind_e
+{
+    // Uniform over the whole raw range
+    ADC_KIND_UNIFORM = 0,
+    // Stick moved by hand
+    ADC_KIND_WALK,
+    // Stick held against a stop
+    ADC_KIND_RAIL,
+    // Released, noise around the calibrated center
+    ADC_KIND_CENTER,
+    ADC_KIND_NB,
+} AdcKind_e;
+
+typedef struct AdcStream_t
+{
+    uint32_t rng;
+    AdcKind_e kind;
+    const HwProfile_t * pProfile;
+    int32_t pWalk[2];
+    int32_t pRail[2];
+    // ADC_KIND_RAIL side changes now and then
+    uint8_t bRailSwitch;
+    // Read failures per 1000 reads, -1 or beyond the 13 bits range
+    uint32_t errPermil;
+} AdcStream_t;
+
+typedef struct Capture_t
+{
+    int64_t x;
+    int64_t y;
+} Capture_t;
+
+static Capture_t g_cap;
+
+static void onReport(uint8_t reportId, const uint8_t * pReport, uint16_t len, void * pArg)
+{
+    if (reportId != REPORT_ID_MOUSE)
+    {
+        return;
+    }
+
+    // int8 fields, clamp8 keeps -128 out
+    CHECK(((int8_t) pReport[1] >= -127) && ((int8_t) pReport[2] >= -127));
+    g_cap.x += (int8_t) pReport[1];
+    g_cap.y += (int8_t) pReport[2];
+}
+
+static int adcRead(int chan, void * pArg)
+{
+    AdcStream_t * pStream = pArg;
+    const HwAxis_t * pAxis = (chan == pStream->pProfile->x.chan) ? &pStream->pProfile->x : &pStream->pProfile->y;
+    uint8_t idx = (chan == pStream->pProfile->x.chan) ? 0U : 1U;
+    int32_t raw = 0;
+
+    if ((TEST_rand(&pStream->rng) % 1000U) < pStream->errPermil)
+    {
+        return (TEST_rand(&pStream->rng) & 1U) ? -1 : HW_PROFILE_RAW_MAX + 1 + TEST_randRange(&pStream->rng, 0, 1000);
+    }
+
+    switch (pStream->kind)
+    {
+        case ADC_KIND_UNIFORM:
+            raw = TEST_randRange(&pStream->rng, 0, HW_PROFILE_RAW_MAX);
+            break;
+
+        case ADC_KIND_WALK:
+            raw = pStream->pWalk[idx] + TEST_randRange(&pStream->rng, -200, 200);
+            raw = (raw < 0) ? 0 : ((raw > HW_PROFILE_RAW_MAX) ? HW_PROFILE_RAW_MAX : raw);
+            pStream->pWalk[idx] = raw;
+            break;
+
+        case ADC_KIND_RAIL:
+            if (pStream->bRailSwitch && ((TEST_rand(&pStream->rng) % 500U) == 0U))
+            {
+                pStream->pRail[idx] = (pStream->pRail[idx] == 0) ? HW_PROFILE_RAW_MAX : 0;
+            }
+            raw = pStream->pRail[idx];
+            break;
+
+        default:
+            raw = pAxis->center + TEST_randRange(&pStream->rng, -pAxis->deadzone / 2, pAxis->deadzone / 2);
+            break;
+    }
+
+    return raw;
+}
+
+// Raw samples as the stream gets them, one per acquisition
+typedef struct SampleSink_t
+{
+    uint32_t nb;
+    int64_t lastUs;
+} SampleSink_t;
+
+static void onSample(uint32_t timestampUs, const Coord_t * pRaw, void * pArg)
+{
+    SampleSink_t * pSink = pArg;
+
+    CHECK((pRaw->x >= 0) && (pRaw->x <= HW_PROFILE_RAW_MAX));
+    CHECK((pRaw->y >= 0) && (pRaw->y <= HW_PROFILE_RAW_MAX));
+    CHECK((int64_t) timestampUs >= pSink->lastUs);
+    pSink->lastUs = timestampUs;
+    pSink->nb++;
+}
+
+typedef struct Pipeline_t
+{
+    Controller_t * pCtrl;
+    Predict_t * pPredict;
+    Mouse_t * pMouse;
+    int64_t cyclePrevUs;
+    uint32_t cycleNb;
+} Pipeline_t;
+
+static void checkMouse(Pipeline_t * pPipe)
+{
+    MouseStats_t stats;
+    const Mouse_t * pMouse = pPipe->pMouse;
+
+    CHECK_EQ(MOUSE_getStats(pPipe->pMouse, &stats), 0U);
+
+    // Backlog is what was taken and not sent yet, within its bound
+    CHECK_EQ((int32_t) ((uint32_t) stats.moveIn.x - (uint32_t) stats.moveOut.x), pMouse->moveAcc.x);
+    CHECK_EQ((int32_t) ((uint32_t) stats.moveIn.y - (uint32_t) stats.moveOut.y), pMouse->moveAcc.y);
+    CHECK((pMouse->moveAcc.x >= -MOUSE_MOVE_ACC_MAX) && (pMouse->moveAcc.x <= MOUSE_MOVE_ACC_MAX));
+    CHECK((pMouse->moveAcc.y >= -MOUSE_MOVE_ACC_MAX) && (pMouse->moveAcc.y <= MOUSE_MOVE_ACC_MAX));
+    // Everything sent reached the host
+    CHECK_EQ(stats.moveOut.x, g_cap.x);
+    CHECK_EQ(stats.moveOut.y, g_cap.y);
+}
+
+// Part of val the bounded backlog takes
+static int32_t accTaken(int32_t acc, int32_t val)
+{
+    int32_t sum = acc + val;
+
+    sum = (sum > MOUSE_MOVE_ACC_MAX) ? MOUSE_MOVE_ACC_MAX : ((sum < -MOUSE_MOVE_ACC_MAX) ? -MOUSE_MOVE_ACC_MAX : sum);
+
+    return sum - acc;
+}
+
+/**
+ * @brief One mouse task report cycle
+ *
+ * acqNb acquisitions at jittered times, as many as fit between two timer
+ * firings, then averaged, predicted, mapped to motion and queued.
+ */
+static void cycle(Pipeline_t * pPipe, uint32_t * pRng, uint16_t acqNb, uint8_t bPoll)
+{
+    Coord_t joy;
+    Coord_t raw;
+    Coord_t acc = { 0, 0 };
+    Coord_t pred;
+    Coord_t motion;
+    MouseStats_t stats;
+    int32_t takenX = 0;
+    int32_t takenY = 0;
+    uint32_t clipNb = 0U;
+    int64_t nowUs = 0;
+
+    for (uint16_t i = 0U; i < acqNb; i++)
+    {
+        // Completions and flushes land anywhere between acquisitions
+        if (bPoll && ((TEST_rand(pRng) % 4U) == 0U))
+        {
+            MOCK_complete();
+        }
+        CHECK_EQ(MOUSE_flush(pPipe->pMouse), 0U);
+
+        CHECK_EQ(CONTROLLER_getJoy(pPipe->pCtrl, &joy), 0U);
+        CHECK((joy.x >= X_OUT_MIN) && (joy.x <= X_OUT_MAX));
+        CHECK((joy.y >= Y_OUT_MIN) && (joy.y <= Y_OUT_MAX));
+
+        // Raw values feed int16 FIR buffers and telemetry fields
+        CHECK_EQ(CONTROLLER_getRaw(pPipe->pCtrl, &raw), 0U);
+        CHECK((raw.x >= 0) && (raw.x <= HW_PROFILE_RAW_MAX) && (raw.x <= INT16_MAX));
+        CHECK((raw.y >= 0) && (raw.y <= HW_PROFILE_RAW_MAX) && (raw.y <= INT16_MAX));
+
+        acc.x += joy.x;
+        acc.y += joy.y;
+        FAKE_advanceUs(TEST_randRange(pRng, 50, 1500));
+    }
+
+    joy.x = acc.x / acqNb;
+    joy.y = acc.y / acqNb;
+
+    nowUs = esp_timer_get_time();
+    CHECK_EQ(PREDICT_update(pPipe->pPredict, &joy, (uint32_t) (nowUs - pPipe->cyclePrevUs), &pred), 0U);
+    pPipe->cyclePrevUs = nowUs;
+    CHECK((pred.x >= X_OUT_MIN) && (pred.x <= X_OUT_MAX));
+    CHECK((pred.y >= Y_OUT_MIN) && (pred.y <= Y_OUT_MAX));
+
+    CONTROLLER_toMotion(&pred, &motion);
+    CHECK((motion.x >= -MOTION_MAX) && (motion.x <= MOTION_MAX));
+    CHECK((motion.y >= -MOTION_MAX) && (motion.y <= MOTION_MAX));
+    CHECK((motion.x == 0) == ((pred.x >= X_OUT_CENTER - DEADZONE - 2) && (pred.x <= X_OUT_CENTER + DEADZONE + 2)));
+
+    // Motion conserved : taken up to the backlog bound, the rest counted as clipped
+    CHECK_EQ(MOUSE_getStats(pPipe->pMouse, &stats), 0U);
+    takenX = accTaken(pPipe->pMouse->moveAcc.x, motion.x);
+    takenY = accTaken(pPipe->pMouse->moveAcc.y, motion.y);
+    clipNb = stats.clipNb + (takenX != motion.x) + (takenY != motion.y);
+    takenX = (int32_t) ((uint32_t) stats.moveIn.x + (uint32_t) takenX);
+    takenY = (int32_t) ((uint32_t) stats.moveIn.y + (uint32_t) takenY);
+
+    CHECK_EQ(MOUSE_move(pPipe->pMouse, motion.x, motion.y), 0U);
+
+    CHECK_EQ(MOUSE_getStats(pPipe->pMouse, &stats), 0U);
+    CHECK_EQ(stats.moveIn.x, takenX);
+    CHECK_EQ(stats.moveIn.y, takenY);
+    CHECK_EQ(stats.clipNb, clipNb);
+
+    checkMouse(pPipe);
+    pPipe->cycleNb++;
+}
+
+static void pipelineInit(Pipeline_t * pPipe, AdcStream_t * pStream, TransportId_e id, uint8_t bPredict)
+{
+    const PredictParams_t params =
+    {
+        .bEn = bPredict,
+        .alpha = PREDICT_ALPHA_DFLT,
+        .beta = PREDICT_BETA_DFLT,
+        .leadUs = PREDICT_LEAD_US,
+    };
+    const HwProfile_t * pProfile = HW_PROFILE_get(HW_PROFILE_DFLT);
+    Transport_t * pTransport = NULL;
+
+    FAKE_reset();
+    FAKE_setTimeUs(1000000);
+    MOCK_reset();
+    g_mock.onReport = onReport;
+    memset(&g_cap, 0, sizeof(g_cap));
+
+    if (id == TRANSPORT_ID_BLE)
+    {
+        g_mock.bHold = 0U;
+        g_mock.intervalUs = 7500U;
+    }
+
+    pStream->pProfile = pProfile;
+    pStream->pWalk[0] = pProfile->x.center;
+    pStream->pWalk[1] = pProfile->y.center;
+    pStream->pRail[0] = HW_PROFILE_RAW_MAX;
+    pStream->pRail[1] = 0;
+    FAKE_setAdc(adcRead, pStream);
+
+    memset(pPipe, 0, sizeof(*pPipe));
+    pPipe->pCtrl = CONTROLLER_init(pProfile);
+    CHECK(pPipe->pCtrl);
+    pPipe->pPredict = PREDICT_init(&params, X_OUT_MIN, X_OUT_MAX);
+    CHECK(pPipe->pPredict);
+    pTransport = TRANSPORT_init(id);
+    CHECK(pTransport);
+    pPipe->pMouse = MOUSE_init(pTransport, 1U, MOUSE_PERSO_MOUSE);
+    CHECK(pPipe->pMouse);
+    pPipe->cyclePrevUs = esp_timer_get_time();
+}
+
+static void drain(Pipeline_t * pPipe)
+{
+    MouseStats_t stats;
+    uint32_t loopNb = 0U;
+
+    while ((pPipe->pMouse->moveAcc.x != 0) || (pPipe->pMouse->moveAcc.y != 0))
+    {
+        FAKE_advanceUs(8000);
+        MOCK_complete();
+        CHECK_EQ(MOUSE_flush(pPipe->pMouse), 0U);
+        CHECK(++loopNb < 1000U);
+    }
+
+    checkMouse(pPipe);
+    CHECK_EQ(MOUSE_getStats(pPipe->pMouse, &stats), 0U);
+    CHECK_EQ(stats.moveIn.x, stats.moveOut.x);
+    CHECK_EQ(stats.moveIn.y, stats.moveOut.y);
+}
+
+// Random streams, read errors, acquisition counts and timing
+static void testRandom(TransportId_e id, uint8_t bPredict, uint32_t seed)
+{
+    Pipeline_t pipe;
+    AdcStream_t stream;
+    MouseStats_t stats;
+    SampleSink_t sink = { 0U, 0 };
+    uint32_t rng = TEST_seed(seed);
+    struct timespec start;
+    struct timespec end;
+    double elapsedS = 0.0;
+
+    memset(&stream, 0, sizeof(stream));
+    stream.rng = TEST_rand(&rng);
+    stream.bRailSwitch = 1U;
+    pipelineInit(&pipe, &stream, id, bPredict);
+    CHECK_EQ(CONTROLLER_setSampleCb(pipe.pCtrl, onSample, &sink), 0U);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (uint32_t i = 0U; i < 20000U; i++)
+    {
+        uint32_t draw = TEST_rand(&rng) % 100U;
+        // Mostly on time, sometimes a stalled cycle with many acquisitions
+        uint16_t acqNb = (draw < 95U) ? (uint16_t) TEST_randRange(&rng, 1, 40) : (uint16_t) TEST_randRange(&rng, 41, 2000);
+
+        if ((TEST_rand(&rng) % 200U) == 0U)
+        {
+            stream.kind = (AdcKind_e) (TEST_rand(&rng) % ADC_KIND_NB);
+            stream.errPermil = (TEST_rand(&rng) & 1U) ? 0U : (uint32_t) TEST_randRange(&rng, 1, 300);
+        }
+
+        cycle(&pipe, &rng, acqNb, 1U);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    elapsedS = (double) (end.tv_sec - start.tv_sec) + (double) (end.tv_nsec - start.tv_nsec) * 1e-9;
+
+    drain(&pipe);
+    CHECK_EQ(MOUSE_getStats(pipe.pMouse, &stats), 0U);
+    CHECK(pipe.pCtrl->adcErrNb > 0U);
+    // Every ADC read pair reached the sample sink, not one average per cycle
+    CHECK_EQ(2U * sink.nb, FAKE_getAdcReadNb());
+
+    printf("%s%s : %" PRIu32 " cycles, %" PRIu32 " samples, %.0f samples/s, %" PRIu32 " adc errors, %" PRIu32 " reports, %" PRIu32 " clipped\n",
+        (id == TRANSPORT_ID_BLE) ? "ble" : "usb", bPredict ? " predict" : "", pipe.cycleNb, FAKE_getAdcReadNb(),
+        (double) FAKE_getAdcReadNb() / elapsedS, pipe.pCtrl->adcErrNb, stats.reportNb, stats.clipNb);
+}
+
+// Host stops polling with the stick held : backlog stops at its bound, then drains
+static void testStall(void)
+{
+    Pipeline_t pipe;
+    AdcStream_t stream;
+    MouseStats_t stats;
+    uint32_t rng = TEST_seed(7U);
+    int32_t signX = 0;
+    int32_t signY = 0;
+
+    memset(&stream, 0, sizeof(stream));
+    stream.rng = TEST_rand(&rng);
+    stream.kind = ADC_KIND_RAIL;
+    pipelineInit(&pipe, &stream, TRANSPORT_ID_USB, 0U);
+
+    // Full deflection on both axes, the first report is in flight and never completes
+    for (uint32_t i = 0U; i < 1000U; i++)
+    {
+        cycle(&pipe, &rng, 10U, 0U);
+    }
+
+    signX = (pipe.pMouse->moveAcc.x < 0) ? -1 : 1;
+    signY = (pipe.pMouse->moveAcc.y < 0) ? -1 : 1;
+    CHECK_EQ(pipe.pMouse->moveAcc.x, signX * MOUSE_MOVE_ACC_MAX);
+    CHECK_EQ(pipe.pMouse->moveAcc.y, signY * MOUSE_MOVE_ACC_MAX);
+    CHECK_EQ(MOUSE_getStats(pipe.pMouse, &stats), 0U);
+    CHECK(stats.clipNb > 0U);
+    CHECK_EQ(g_mock.sendNb, 1U);
+
+    drain(&pipe);
+    CHECK_EQ(g_cap.x, signX * (MOTION_MAX + MOUSE_MOVE_ACC_MAX));
+    CHECK_EQ(g_cap.y, signY * (MOTION_MAX + MOUSE_MOVE_ACC_MAX));
+}
+
+int main(void)
+{
+    testStall();
+    testRandom(TRANSPORT_ID_USB, 0U, 1U);
+    testRandom(TRANSPORT_ID_USB, 1U, 2U);
+    testRandom(TRANSPORT_ID_BLE, 1U, 3U);
+
+    printf("OK\n");
+
+    return 0;
+}
@@ -0,0 +1,237 @@
+
+#include <string.h>
+
+#include "rate_ctrl.h"
+
+#include "test_host.h"
+
+#define CHAN_NB 4U
+#define CENTER 338
+#define DEADZONE 40
+#define THRESHOLD 3
+#define FILT_SHIFT 2U
+#define PERIOD_IDLE_MS 10U
+#define PERIOD_MOVE_MS 2U
+
+// Same figures as AnalogReadSerial.ino
+static const RateCtrlConf_t CONF = {
+    CHAN_NB,
+    CENTER,
+    DEADZONE,
+    THRESHOLD,
+    FILT_SHIFT,
+    PERIOD_IDLE_MS,
+    PERIOD_MOVE_MS,
+};
+
+// Enough samples for the filter to settle on a constant input
+static void settle(RateCtrl_t * pInst, const int16_t * pVal)
+{
+    for (uint32_t i = 0U; i < 64U; i++)
+    {
+        for (uint8_t chan = 0U; chan < CHAN_NB; chan += 1U)
+        {
+            rateCtrlSample(pInst, chan, pVal[chan]);
+        }
+    }
+}
+
+static void testFilter(void)
+{
+    RateCtrl_t ctrl;
+    int16_t pOut[CHAN_NB];
+    int16_t pVal[CHAN_NB] = { CENTER + 100, CENTER, CENTER, CENTER };
+
+    rateCtrlInit(&ctrl, &CONF);
+    CHECK_EQ(rateCtrlGet(&ctrl, 0U), CENTER);
+
+    // Weight 1 / 2^FILT_SHIFT on the first sample
+    rateCtrlSample(&ctrl, 0U, pVal[0]);
+    CHECK_EQ(rateCtrlGet(&ctrl, 0U), CENTER + 100 / (1 << FILT_SHIFT));
+    CHECK_EQ(rateCtrlGet(&ctrl, 1U), CENTER);
+
+    // Converges exactly on a constant input, up and down
+    settle(&ctrl, pVal);
+    CHECK_EQ(rateCtrlGet(&ctrl, 0U), CENTER + 100);
+
+    pVal[0] = 0;
+    settle(&ctrl, pVal);
+    CHECK_EQ(rateCtrlGet(&ctrl, 0U), 0);
+
+    // Single spike inside the deadzone once filtered : no motion
+    rateCtrlInit(&ctrl, &CONF);
+    rateCtrlSample(&ctrl, 0U, CENTER + 4 * DEADZONE);
+    CHECK_EQ(rateCtrlStep(&ctrl, pOut), 0U);
+    CHECK(!rateCtrlIsDue(&ctrl, 0U));
+}
+
+static void testDelta(void)
+{
+    RateCtrl_t ctrl;
+    int16_t pOut[CHAN_NB];
+    int16_t pVal[CHAN_NB] = { CENTER, CENTER, CENTER, CENTER };
+    uint8_t mask = 0U;
+
+    rateCtrlInit(&ctrl, &CONF);
+
+    // Idle at centre : nothing due, slow period
+    mask = rateCtrlStep(&ctrl, pOut);
+    CHECK_EQ(mask, 0U);
+    CHECK(!rateCtrlIsDue(&ctrl, mask));
+    CHECK_EQ(rateCtrlPeriodMs(&ctrl), PERIOD_IDLE_MS);
+
+    // Just inside the deadzone still idle
+    pVal[0] = CENTER + DEADZONE;
+    settle(&ctrl, pVal);
+    CHECK_EQ(rateCtrlStep(&ctrl, pOut), 0U);
+
+    // Motion start sends every channel, fast period
+    pVal[0] = CENTER + DEADZONE + 1;
+    settle(&ctrl, pVal);
+    memset(pOut, 0, sizeof(pOut));
+    mask = rateCtrlStep(&ctrl, pOut);
+    CHECK_EQ(mask, (1U << CHAN_NB) - 1U);
+    CHECK(rateCtrlIsDue(&ctrl, mask));
+    CHECK_EQ(pOut[0], CENTER + DEADZONE + 1);
+    CHECK_EQ(pOut[1], CENTER);
+    CHECK_EQ(rateCtrlPeriodMs(&ctrl), PERIOD_MOVE_MS);
+
+    // No change : empty mask, still due as heartbeat
+    mask = rateCtrlStep(&ctrl, pOut);
+    CHECK_EQ(mask, 0U);
+    CHECK(rateCtrlIsDue(&ctrl, mask));
+
+    // Below threshold : not resent
+    pVal[1] = CENTER + THRESHOLD - 1;
+    settle(&ctrl, pVal);
+    CHECK_EQ(rateCtrlStep(&ctrl, pOut), 0U);
+
+    // Threshold reached on one channel : that channel only
+    pVal[1] = CENTER + THRESHOLD;
+    settle(&ctrl, pVal);
+    memset(pOut, 0, sizeof(pOut));
+    mask = rateCtrlStep(&ctrl, pOut);
+    CHECK_EQ(mask, 1U << 1);
+    CHECK_EQ(pOut[1], CENTER + THRESHOLD);
+    CHECK_EQ(pOut[0], 0);
+
+    // Negative deltas and a second active channel
+    pVal[1] = CENTER - DEADZONE - 10;
+    pVal[3] = CENTER + 20;
+    settle(&ctrl, pVal);
+    mask = rateCtrlStep(&ctrl, pOut);
+    CHECK_EQ(mask, (1U << 1) | (1U << 3));
+    CHECK_EQ(pOut[1], CENTER - DEADZONE - 10);
+    CHECK_EQ(pOut[3], CENTER + 20);
+}
+
+static void testRelease(void)
+{
+    RateCtrl_t ctrl;
+    int16_t pOut[CHAN_NB];
+    int16_t pVal[CHAN_NB] = { CENTER - 200, CENTER + 5, CENTER, CENTER - 7 };
+    uint8_t mask = 0U;
+
+    rateCtrlInit(&ctrl, &CONF);
+    settle(&ctrl, pVal);
+    CHECK_EQ(rateCtrlStep(&ctrl, pOut), (1U << CHAN_NB) - 1U);
+
+    // Released off centre but inside the deadzone : one centre frame with every channel
+    pVal[0] = CENTER + DEADZONE;
+    settle(&ctrl, pVal);
+    memset(pOut, 0, sizeof(pOut));
+    mask = rateCtrlStep(&ctrl, pOut);
+    CHECK_EQ(mask, (1U << CHAN_NB) - 1U);
+    CHECK(rateCtrlIsDue(&ctrl, mask));
+    for (uint8_t chan = 0U; chan < CHAN_NB; chan += 1U)
+    {
+        CHECK_EQ(pOut[chan], CENTER);
+    }
+    CHECK_EQ(rateCtrlPeriodMs(&ctrl), PERIOD_IDLE_MS);
+
+    // Only once
+    mask = rateCtrlStep(&ctrl, pOut);
+    CHECK_EQ(mask, 0U);
+    CHECK(!rateCtrlIsDue(&ctrl, mask));
+
+    // Next motion starts from the centre frame, full state again
+    pVal[2] = CENTER + 100;
+    settle(&ctrl, pVal);
+    CHECK_EQ(rateCtrlStep(&ctrl, pOut), (1U << CHAN_NB) - 1U);
+}
+
+static void testRandom(void)
+{
+    uint32_t rnd = TEST_seed(0x5eed0033U);
+    RateCtrl_t ctrl;
+    int16_t pOut[CHAN_NB];
+    // As the host sees it, centre until the first frame
+    int16_t pHost[CHAN_NB] = { CENTER, CENTER, CENTER, CENTER };
+    int16_t pVal[CHAN_NB] = { CENTER, CENTER, CENTER, CENTER };
+    uint8_t mask = 0U;
+
+    rateCtrlInit(&ctrl, &CONF);
+
+    for (uint32_t step = 0U; step < 20000U; step++)
+    {
+        uint8_t bActive = 0U;
+
+        // Mostly small moves, sometimes a jump or a release
+        for (uint8_t chan = 0U; chan < CHAN_NB; chan += 1U)
+        {
+            if ((TEST_rand(&rnd) % 64U) == 0U)
+            {
+                pVal[chan] = (TEST_rand(&rnd) % 2U) ? CENTER : (int16_t) TEST_randRange(&rnd, 0, 2 * CENTER);
+            }
+            else
+            {
+                pVal[chan] = (int16_t) TEST_randRange(&rnd, pVal[chan] - 4, pVal[chan] + 4);
+            }
+            for (uint8_t sampleIdx = 0U; sampleIdx < 4U; sampleIdx += 1U)
+            {
+                rateCtrlSample(&ctrl, chan, pVal[chan]);
+            }
+            if (rateCtrlAbs(rateCtrlGet(&ctrl, chan) - CENTER) > DEADZONE)
+            {
+                bActive = 1U;
+            }
+        }
+
+        mask = rateCtrlStep(&ctrl, pOut);
+        CHECK_EQ(mask >> CHAN_NB, 0U);
+        for (uint8_t chan = 0U; chan < CHAN_NB; chan += 1U)
+        {
+            if (mask & (1U << chan))
+            {
+                pHost[chan] = pOut[chan];
+            }
+        }
+
+        // Moving : fast period, the host within threshold of every channel. Idle : slow, host at centre.
+        CHECK_EQ(ctrl.bMoving, bActive);
+        CHECK_EQ(rateCtrlPeriodMs(&ctrl), bActive ? PERIOD_MOVE_MS : PERIOD_IDLE_MS);
+        for (uint8_t chan = 0U; chan < CHAN_NB; chan += 1U)
+        {
+            if (bActive)
+            {
+                CHECK(rateCtrlAbs(rateCtrlGet(&ctrl, chan) - pHost[chan]) < THRESHOLD);
+            }
+            else
+            {
+                CHECK_EQ(pHost[chan], CENTER);
+            }
+        }
+    }
+}
+
+int main(void)
+{
+    testFilter();
+    testDelta();
+    testRelease();
+    testRandom();
+
+    printf("OK\n");
+
+    return 0;
+}
@@ -0,0 +1,151 @@
+
+#include <string.h>
+
+#include "telemetry.h"
+
+#include "fakes.h"
+#include "mock_transport.h"
+#include "test_host.h"
+
+static const uint8_t REPORT_DESC[] = { 0x05, 0x01 };
+
+static Transport_t * transportStart(TransportId_e id)
+{
+    TransportConf_t conf;
+    Transport_t * pTransport = NULL;
+
+    FAKE_reset();
+    MOCK_reset();
+
+    memset(&conf, 0, sizeof(conf));
+    conf.pReportDesc = REPORT_DESC;
+    conf.reportDescLen = sizeof(REPORT_DESC);
+
+    pTransport = TRANSPORT_init(id);
+    CHECK(pTransport);
+    CHECK_EQ(TRANSPORT_start(pTransport, &conf), 0U);
+
+    return pTransport;
+}
+
+static void sampleInit(TelemetrySample_t * pSample)
+{
+    memset(pSample, 0, sizeof(*pSample));
+    pSample->timestampUs = 0x12345678U;
+    pSample->raw.x = 40000;
+    pSample->raw.y = -5;
+    pSample->mouse.x = -300;
+    pSample->cpu.load = SYSMON_CPU_UNKNOWN;
+}
+
+static void testUsb(void)
+{
+    TelemetrySample_t sample;
+    TelemetryPacket_t packet;
+    Telemetry_t * pTelem = TELEMETRY_init(transportStart(TRANSPORT_ID_USB), 2U);
+
+    CHECK(pTelem);
+    sampleInit(&sample);
+
+    // 1 record every 2 cycles, through the transport telemetry channel only
+    for (uint32_t i = 0U; i < 6U; i++)
+    {
+        CHECK_EQ(TELEMETRY_update(pTelem, &sample), 0U);
+    }
+
+    CHECK_EQ(g_mock.auxNb, 3U);
+    CHECK_EQ(g_mock.sendNb, 0U);
+    CHECK_EQ(g_mock.auxLastLen, TELEMETRY_REPORT_LEN);
+
+    memcpy(&packet, g_mock.pAuxLast, sizeof(packet));
+    CHECK_EQ(packet.version, TELEMETRY_VERSION);
+    CHECK_EQ(packet.seq, 2U);
+    CHECK_EQ(packet.timestampUs, 0x12345678U);
+    CHECK_EQ(packet.rawX, INT16_MAX);
+    CHECK_EQ(packet.rawY, -5);
+    CHECK_EQ(packet.mouseX, INT8_MIN);
+    CHECK_EQ(packet.telemDropCnt, 0U);
+
+    // Channel busy : dropped, sequence still advances
+    g_mock.bAuxReady = 0U;
+    CHECK_EQ(TELEMETRY_update(pTelem, &sample), 0U);
+    CHECK_EQ(TELEMETRY_update(pTelem, &sample), 0U);
+    CHECK_EQ(pTelem->dropCnt, 1U);
+
+    g_mock.bAuxReady = 1U;
+    CHECK_EQ(TELEMETRY_update(pTelem, &sample), 0U);
+    CHECK_EQ(TELEMETRY_update(pTelem, &sample), 0U);
+    memcpy(&packet, g_mock.pAuxLast, sizeof(packet));
+    CHECK_EQ(packet.seq, 4U);
+    CHECK_EQ(packet.telemDropCnt, 1U);
+    CHECK_EQ(packet.cpuTaskIdx, SYSMON_CPU_UNKNOWN);
+    CHECK_EQ(packet.cpuTaskName[0], '\0');
+}
+
+static void testTaskName(void)
+{
+    static const char * const TASK_NAME[] = { "main", "IDLE", "loggerMain", "0123456789abcdef" };
+    TelemetrySample_t sample;
+    TelemetryPacket_t packet;
+    Telemetry_t * pTelem = TELEMETRY_init(transportStart(TRANSPORT_ID_USB), 1U);
+
+    CHECK(pTelem);
+    sampleInit(&sample);
+    sample.cpu.load = 42U;
+    sample.cpu.taskNb = sizeof(TASK_NAME) / sizeof(TASK_NAME[0]);
+    for (uint8_t idx = 0U; idx < sample.cpu.taskNb; idx += 1U)
+    {
+        sample.cpu.pTaskLoad[idx] = 10U + idx;
+        sample.cpu.pTaskName[idx] = TASK_NAME[idx];
+    }
+
+    // One task per record, its name travels with it, longest names fill the field unterminated
+    for (uint32_t i = 0U; i < 2U * sample.cpu.taskNb; i++)
+    {
+        CHECK_EQ(TELEMETRY_update(pTelem, &sample), 0U);
+        memcpy(&packet, g_mock.pAuxLast, sizeof(packet));
+        CHECK_EQ(packet.cpuTaskIdx, packet.seq % sample.cpu.taskNb);
+        CHECK_EQ(packet.cpuTaskLoad, 10U + packet.cpuTaskIdx);
+        CHECK_EQ(packet.cpuTaskNb, sample.cpu.taskNb);
+        CHECK(strncmp(packet.cpuTaskName, TASK_NAME[packet.cpuTaskIdx], TELEMETRY_TASK_NAME_LEN) == 0);
+    }
+}
+
+static void testNoChannel(TransportId_e id)
+{
+    TelemetrySample_t sample;
+    Telemetry_t * pTelem = TELEMETRY_init(transportStart(id), 1U);
+    uint32_t errNb = 0U;
+
+    CHECK(pTelem);
+    CHECK_EQ(pTelem->period, 0U);
+    sampleInit(&sample);
+
+    // Stays disabled, nothing reaches the transport, no error per cycle
+    TELEMETRY_setPeriod(pTelem, 1U);
+    CHECK_EQ(pTelem->period, 0U);
+
+    errNb = FAKE_getLogNb(LOG_LVL_ERROR);
+    for (uint32_t i = 0U; i < 10U; i++)
+    {
+        CHECK_EQ(TELEMETRY_update(pTelem, &sample), 0U);
+    }
+
+    CHECK_EQ(g_mock.auxNb, 0U);
+    CHECK_EQ(g_mock.sendNb, 0U);
+    CHECK_EQ(FAKE_getLogNb(LOG_LVL_ERROR), errNb);
+}
+
+int main(void)
+{
+    testUsb();
+    testTaskName();
+    testNoChannel(TRANSPORT_ID_BLE);
+    testNoChannel(TRANSPORT_ID_LOOPBACK);
+
+    CHECK(TELEMETRY_init(NULL, 1U) == NULL);
+
+    printf("OK\n");
+
+    return 0;
+}
@@ -0,0 +1,166 @@
+
+import argparse
+import csv
+import random
+import sys
+
+# Keep in sync with main/predict.c (fixed point, C integer division)
+GAIN_SHIFT = 8
+GAIN_ONE = 1 << GAIN_SHIFT
+STATE_SHIFT = 16
+US_PER_MS = 1000
+US_PER_S = 1000000
+
+# Keep in sync with main/config.h
+REPORT_FREQ_HZ = 60
+ACQ_PERIOD_US = 500
+ALPHA_DFLT = 224
+BETA_DFLT = 32
+LEAD_US_DFLT = US_PER_S // REPORT_FREQ_HZ
+OUT_MIN = -100
+OUT_MAX = 100
+
+def cdiv(num: int, den: int) -> int:
+    """C integer division, truncates toward zero"""
+    quot = abs(num) // abs(den)
+    return quot if (num >= 0) == (den >= 0) else -quot
+
+class Predict:
+    """Single axis mirror of PREDICT_update"""
+
+    def __init__(self, alpha: int, beta: int, lead_us: int, enabled: bool = True):
+        self.alpha = alpha
+        self.beta = beta
+        self.lead_us = lead_us
+        self.enabled = enabled
+        self.pos = None
+        self.vel = 0
+
+    def update(self, val_in: int, dt_us: int) -> int:
+        if not self.enabled or self.pos is None:
+            self.pos = val_in << STATE_SHIFT
+            self.vel = 0
+            return val_in
+
+        pos = self.pos + cdiv(self.vel * dt_us, US_PER_MS)
+        res = (val_in << STATE_SHIFT) - pos
+        pos += cdiv(res * self.alpha, GAIN_ONE)
+        if dt_us:
+            self.vel += cdiv(cdiv(res * self.beta, GAIN_ONE) * US_PER_MS, dt_us)
+        self.pos = pos
+
+        out = self.pos + cdiv(self.vel * self.lead_us, US_PER_MS)
+        out = (out + (1 << (STATE_SHIFT - 1))) >> STATE_SHIFT
+        return min(max(out, OUT_MIN), OUT_MAX)
+
+def trace_synth(kind: str, duration_s: float, amplitude: int, ramp_ms: float):
+    """True thumb position, one point per acquisition"""
+    points = []
+    t_start_us = 100 * US_PER_MS
+    for t_us in range(0, int(duration_s * US_PER_S), ACQ_PERIOD_US):
+        if t_us < t_start_us:
+            val = 0.0
+        elif kind == "step":
+            val = amplitude
+        else:
+            val = amplitude * min(1.0, (t_us - t_start_us) / (ramp_ms * US_PER_MS))
+        points.append((t_us, val))
+    return points
+
+def reports_from_trace(points, noise: float):
+    """Report cycle averages of the acquisitions, as the mouse task computes them"""
+    period_us = US_PER_S // REPORT_FREQ_HZ
+    reports = []
+    acc = []
+    t_next = period_us
+    for t_us, val in points:
+        acc.append(val + random.gauss(0, noise) if noise else val)
+        if t_us >= t_next:
+            reports.append((t_us, int(sum(acc) / len(acc))))
+            acc = []
+            t_next += period_us
+    return reports
+
+def trace_csv(path: str, field: str):
+    """Recorded telemetry_decode.py --csv output, already report cycle averages"""
+    with open(path, newline="") as stream:
+        rows = list(csv.DictReader(stream))
+    t_first = int(rows[0]["timestamp_us"])
+    return [((int(row["timestamp_us"]) - t_first) % (1 << 32), int(row[field])) for row in rows]
+
+def run(reports, predict: Predict, tx_delay_us: int):
+    out = []
+    t_prev = reports[0][0]
+    for t_us, val in reports:
+        out.append((t_us + tx_delay_us, predict.update(val, t_us - t_prev)))
+        t_prev = t_us
+    return out
+
+def crossing_us(points, level: float, rising: bool):
+    for (t0, v0), (t1, v1) in zip(points, points[1:]):
+        if (rising and v0 < level <= v1) or (not rising and v0 > level >= v1):
+            return t0 + (t1 - t0) * (level - v0) / (v1 - v0)
+    return None
+
+def metrics(kind: str, ref, out):
+    """Net lag (ms, negative : ahead of reference) and overshoot (% of the move)"""
+    initial = ref[0][1]
+    final = ref[-1][1]
+    amplitude = final - initial
+    if not amplitude:
+        return None, None
+    rising = amplitude > 0
+
+    if kind == "step":
+        t_ref = crossing_us(ref, initial + amplitude / 2, rising)
+        t_out = crossing_us(out, initial + amplitude / 2, rising)
+        lag_ms = (t_out - t_ref) / US_PER_MS if t_ref is not None and t_out is not None else None
+    else:
+        # Time reference needed to reach each output value, over the middle of the ramp
+        lags = []
+        for t_us, val in out:
+            if abs(val - initial) < abs(amplitude) * 0.25 or abs(val - initial) > abs(amplitude) * 0.75:
+                continue
+            t_ref = crossing_us(ref, val, rising)
+            if t_ref is not None:
+                lags.append(t_us - t_ref)
+        lag_ms = sum(lags) / len(lags) / US_PER_MS if lags else None
+
+    peak = max(val for _, val in out) if rising else min(val for _, val in out)
+    overshoot = max(0.0, (peak - final) / amplitude * 100)
+    return lag_ms, overshoot
+
+def main():
+    parser = argparse.ArgumentParser(description="Simulate the predictive stage, report lag and overshoot")
+    parser.add_argument("--kind", choices=["step", "ramp"], default="step")
+    parser.add_argument("--csv", help="recorded trace (telemetry_decode.py --csv), synthetic if omitted")
+    parser.add_argument("--field", default="filt_x", help="CSV column used as input")
+    parser.add_argument("--alpha", type=int, default=ALPHA_DFLT, help=f"Q8, {GAIN_ONE} = 1.0")
+    parser.add_argument("--beta", type=int, default=BETA_DFLT, help=f"Q8, {GAIN_ONE} = 1.0")
+    parser.add_argument("--lead-us", type=int, default=LEAD_US_DFLT)
+    parser.add_argument("--tx-delay-us", type=int, default=0, help="report cycle to transmit delay")
+    parser.add_argument("--amplitude", type=int, default=60)
+    parser.add_argument("--ramp-ms", type=float, default=300)
+    parser.add_argument("--duration", type=float, default=1.0, help="synthetic trace length, in seconds")
+    parser.add_argument("--noise", type=float, default=0, help="synthetic acquisition noise, std dev")
+    args = parser.parse_args()
+
+    if args.csv:
+        # Recorded input is the reference, lag is relative to the averaged signal
+        reports = trace_csv(args.csv, args.field)
+        ref = reports
+    else:
+        random.seed(0)
+        ref = trace_synth(args.kind, args.duration, args.amplitude, args.ramp_ms)
+        reports = reports_from_trace(ref, args.noise)
+
+    for name, predict in (("passthrough", Predict(args.alpha, args.beta, args.lead_us, enabled=False)),
+                          ("predict", Predict(args.alpha, args.beta, args.lead_us))):
+        lag_ms, overshoot = metrics(args.kind, ref, run(reports, predict, args.tx_delay_us))
+        if lag_ms is None:
+            print(f"{name:12s} no {args.kind} found in trace", file=sys.stderr)
+            continue
+        print(f"{name:12s} {args.kind}: lag = {lag_ms:6.1f} ms, overshoot = {overshoot:5.1f} %")
+
+if __name__ == "__main__":
+    main()
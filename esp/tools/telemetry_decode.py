@@ -0,0 +1,124 @@
+
+import argparse
+import struct
+import sys
+
+# Keep in sync with TelemetryPacket_t (main/telemetry.h)
+TELEMETRY_VERSION = 4
+TELEMETRY_REPORT_LEN = 48
+TELEMETRY_FMT = "<BBIhhhhbbHHHHhhBBBB16s"
+TELEMETRY_FIELDS = [
+    "version",
+    "seq",
+    "timestamp_us",
+    "raw_x",
+    "raw_y",
+    "filt_x",
+    "filt_y",
+    "mouse_x",
+    "mouse_y",
+    "acq_nb",
+    "log_queue_depth",
+    "log_drop_cnt",
+    "telem_drop_cnt",
+    "pred_x",
+    "pred_y",
+    "cpu_load",
+    "cpu_task_idx",
+    "cpu_task_load",
+    "cpu_task_nb",
+    "cpu_task_name",
+]
+
+CPU_UNKNOWN = 0xFF
+
+US_PER_S = 1000000
+
+def decode(report: bytes):
+    if len(report) != TELEMETRY_REPORT_LEN:
+        return None
+    record = dict(zip(TELEMETRY_FIELDS, struct.unpack_from(TELEMETRY_FMT, report)))
+    if record["version"] != TELEMETRY_VERSION:
+        return None
+    # Sent by the device, NUL padded, the task table differs between builds
+    record["cpu_task_name"] = record["cpu_task_name"].rstrip(b"\0").decode("ascii", "replace") or f"task{record['cpu_task_idx']}"
+    return record
+
+def read_reports(stream):
+    while True:
+        report = stream.read(TELEMETRY_REPORT_LEN)
+        if len(report) < TELEMETRY_REPORT_LEN:
+            return
+        yield report
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode thumb_mouse telemetry HID stream")
+    parser.add_argument("path", help="hidraw device (e.g. /dev/hidraw3), recorded file, or - for stdin")
+    parser.add_argument("--csv", action="store_true", help="print one CSV line per record")
+    parser.add_argument("--count", type=int, default=0, help="stop after N records (0: run until EOF)")
+    args = parser.parse_args()
+
+    stream = sys.stdin.buffer if args.path == "-" else open(args.path, "rb", buffering=0)
+
+    if args.csv:
+        print(",".join(TELEMETRY_FIELDS))
+
+    record_nb = 0
+    bad_nb = 0
+    gap_nb = 0
+    seq_prev = None
+    ts_first = None
+    ts_prev = None
+    period_max_us = 0
+    cpu_load_max = 0
+    cpu_task_load = {}
+
+    try:
+        for report in read_reports(stream):
+            record = decode(report)
+            if record is None:
+                bad_nb += 1
+                continue
+
+            if seq_prev is not None:
+                gap_nb += (record["seq"] - seq_prev - 1) % 256
+            seq_prev = record["seq"]
+
+            ts = record["timestamp_us"]
+            if ts_first is None:
+                ts_first = ts
+            if ts_prev is not None:
+                period_max_us = max(period_max_us, (ts - ts_prev) % (1 << 32))
+            ts_prev = ts
+
+            if record["cpu_load"] != CPU_UNKNOWN:
+                cpu_load_max = max(cpu_load_max, record["cpu_load"])
+            if record["cpu_task_load"] != CPU_UNKNOWN:
+                cpu_task_load[record["cpu_task_name"]] = record["cpu_task_load"]
+
+            record_nb += 1
+
+            if args.csv:
+                print(",".join(str(record[field]) for field in TELEMETRY_FIELDS))
+
+            if args.count and record_nb >= args.count:
+                break
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if stream is not sys.stdin.buffer:
+            stream.close()
+
+    if record_nb:
+        span_us = (ts_prev - ts_first) % (1 << 32)
+        rate = (record_nb - 1) * US_PER_S / span_us if span_us else 0
+        print(f"records = {record_nb}, bad = {bad_nb}, seq gaps = {gap_nb}, "
+              f"rate = {rate:.1f} Hz, max period = {period_max_us} us", file=sys.stderr)
+        if cpu_task_load:
+            tasks = ", ".join(f"{name} {load} %" for name, load in cpu_task_load.items())
+            print(f"cpu load max = {cpu_load_max} %, last per task : {tasks}", file=sys.stderr)
+    else:
+        print(f"no records, bad = {bad_nb}", file=sys.stderr)
+
+if __name__ == "__main__":
+    main()